@@ -0,0 +1,38 @@
+#ifndef RAY_TRACER_ACCELERATOR_H
+#define RAY_TRACER_ACCELERATOR_H
+
+#include <vector>
+
+#include "shape.h"
+#include "bounds.h"
+#include "ray.h"
+
+// Interface for spatial structures that find a ray's intersections with the
+// world's objects without testing every object; see World::SetAccelerator().
+// Like ShapeGroup::Intersect(), implementations return every intersection
+// along the ray's line, including those behind its origin.
+class Accelerator {
+    void Flatten(const Shape* s);
+
+    protected:
+        // bounded primitives, indexed by the structure
+        std::vector<const Shape*> shapes_;
+        // primitives with infinite bounds (e.g., planes) are always tested
+        std::vector<const Shape*> unbounded_;
+        // the bounds of all bounded primitives, in world space
+        BoundingBox bounds_;
+
+        virtual void BuildStructure() = 0;
+        bool IntersectShape(IntersectionList& list, const Ray& ray, const Shape* s) const;
+        bool IntersectUnbounded(IntersectionList& list, const Ray& ray) const;
+
+    public:
+        Accelerator(): shapes_ {}, unbounded_ {}, bounds_ {} {}
+        virtual ~Accelerator() {}
+
+        virtual void Build(const std::vector<const Shape*>& objects);
+        virtual bool Intersect(IntersectionList& list, const Ray& ray) const = 0;
+        std::size_t NShapes() const { return shapes_.size() + unbounded_.size(); }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,73 @@
+#ifndef RAY_TRACER_AFFINE_H
+#define RAY_TRACER_AFFINE_H
+
+#include "space.h"
+#include "matrix.h"
+
+// The first three rows of a 4x4 transformation matrix, stored inline rather
+// than on the heap; the fourth row of an affine transformation is always
+// 0, 0, 0, 1. Products are accumulated in the same order as the Matrix
+// operators so that the results are identical.
+class AffineTransform {
+    double m_[3][4];
+
+    public:
+        AffineTransform() {
+            for (int row = 0; row < 3; row++) {
+                for (int column = 0; column < 4; column++) {
+                    m_[row][column] = (row == column) ? 1.0 : 0.0;
+                }
+            }
+        }
+
+        explicit AffineTransform(const Matrix& m) {
+            for (int row = 0; row < 3; row++) {
+                for (int column = 0; column < 4; column++) {
+                    m_[row][column] = m.At(row, column);
+                }
+            }
+        }
+
+        double At(int row, int column) const { return m_[row][column]; }
+
+        const Point operator*(const Point& p) const {
+            double x = p.X(), y = p.Y(), z = p.Z();
+            return Point {
+                0.0 + m_[0][0] * x + m_[0][1] * y + m_[0][2] * z + m_[0][3],
+                0.0 + m_[1][0] * x + m_[1][1] * y + m_[1][2] * z + m_[1][3],
+                0.0 + m_[2][0] * x + m_[2][1] * y + m_[2][2] * z + m_[2][3]
+            };
+        }
+
+        const Vector operator*(const Vector& v) const {
+            double x = v.X(), y = v.Y(), z = v.Z();
+            return Vector {
+                0.0 + m_[0][0] * x + m_[0][1] * y + m_[0][2] * z,
+                0.0 + m_[1][0] * x + m_[1][1] * y + m_[1][2] * z,
+                0.0 + m_[2][0] * x + m_[2][1] * y + m_[2][2] * z
+            };
+        }
+
+        // Multiplies a vector by the transpose of the transformation, as for
+        // transforming normals by the transpose of an inverse
+        const Vector TransposeMultiply(const Vector& v) const {
+            double x = v.X(), y = v.Y(), z = v.Z();
+            return Vector {
+                0.0 + m_[0][0] * x + m_[1][0] * y + m_[2][0] * z,
+                0.0 + m_[0][1] * x + m_[1][1] * y + m_[2][1] * z,
+                0.0 + m_[0][2] * x + m_[1][2] * y + m_[2][2] * z
+            };
+        }
+
+        const Matrix ToMatrix() const {
+            Matrix m = Matrix::Identity(4);
+            for (int row = 0; row < 3; row++) {
+                for (int column = 0; column < 4; column++) {
+                    m[row][column] = m_[row][column];
+                }
+            }
+            return m;
+        }
+};
+
+#endif
\ No newline at end of file
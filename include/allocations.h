@@ -0,0 +1,20 @@
+#ifndef RAY_TRACER_ALLOCATIONS_H
+#define RAY_TRACER_ALLOCATIONS_H
+
+// Counts the heap allocations made by each thread, to find allocations on
+// the rendering path. The counting is done by a replacement for the global
+// operator new in src/allocations.cc, which is only compiled in when
+// RAY_TRACER_COUNT_ALLOCATIONS is defined; otherwise the counts stay zero.
+class AllocationCounter {
+    public:
+        // whether operator new is counting allocations
+        static bool Enabled();
+        // allocations and bytes allocated by the calling thread
+        static unsigned long long Count();
+        static unsigned long long Bytes();
+        static void Reset();
+        // allocations by all threads, e.g., while rendering concurrently
+        static unsigned long long TotalCount();
+};
+
+#endif
\ No newline at end of file
@@ -8,34 +8,37 @@
 #include "space.h"
 #include "matrix.h"
 #include "ray.h"
+#include "ray-packet.h"
 
 const static double kBBInfinity { std::numeric_limits<double>::infinity() };
 
 class BoundingBox {
-    Point min_;
-    Point max_;
-
-    std::array<double, 2> IntersectionsByAxis(const Ray& ray,
-        const SpatialTuple::Coordinates axis) const;
+    // stored inline rather than as Points, whose elements are on the heap
+    std::array<double, 3> min_;
+    std::array<double, 3> max_;
 
     public:
         static const int kIndices[3];
 
-        BoundingBox():  min_ { Point { kBBInfinity, kBBInfinity, kBBInfinity } },
-            max_ { Point { -kBBInfinity, -kBBInfinity, -kBBInfinity } } {}
-        BoundingBox(const Point& min, const Point& max): min_ { min },
-            max_ { max } {}
+        BoundingBox():  min_ { { kBBInfinity, kBBInfinity, kBBInfinity } },
+            max_ { { -kBBInfinity, -kBBInfinity, -kBBInfinity } } {}
+        BoundingBox(const Point& min, const Point& max):
+            min_ { { min.X(), min.Y(), min.Z() } },
+            max_ { { max.X(), max.Y(), max.Z() } } {}
         BoundingBox(const BoundingBox& b): min_ { b.min_ }, max_ { b.max_ } {}
 
-        const Point Min() const { return min_; }
-        const Point Max() const { return max_; }
+        const Point Min() const { return Point { min_[0], min_[1], min_[2] }; }
+        const Point Max() const { return Point { max_[0], max_[1], max_[2] }; }
         void Add(const Point& p);
         void Add(const BoundingBox& b);
         bool Contains(const Point& p) const;
         bool Contains(const BoundingBox& b) const;
         const BoundingBox Transform(const Matrix& m) const;
         const bool Intersects(const Ray& r) const;
+        bool Intersects(const Ray& r, double& tmin, double& tmax) const;
+        LaneMask Intersects(const RayPacket& packet, double* tmin, double* tmax) const;
         const std::array<const BoundingBox, 2> Split() const;
+        double SurfaceArea() const;
 };
 
 #endif
\ No newline at end of file
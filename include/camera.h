@@ -1,10 +1,16 @@
 #ifndef RAY_TRACER_CAMERA_H
 #define RAY_TRACER_CAMERA_H
 
+#include <functional>
+#include <vector>
+
 #include "transformations.h"
 #include "ray.h"
+#include "ray-packet.h"
 #include "canvas.h"
 #include "world.h"
+#include "sampler.h"
+#include "checkpoint.h"
 
 class Camera {
     int horizontal_;
@@ -15,8 +21,33 @@ class Camera {
     double half_width_;
     double half_height_;
     double pixel_size_;
+    // In world space, the ray through the point (x, y) on the canvas starts
+    // at origin_ and its direction is (corner_ + y * down_) + x * right_,
+    // normalised; see UpdateRays()
+    double origin_[3];
+    double corner_[3];
+    double right_[3];
+    double down_[3];
+
+    void UpdateRays();
+
+    const Colour Refine(const World& world, double x, double y, double size,
+        const Colour& colour, const Shape* object, int& budget) const;
 
     public:
+        // Called by RenderProgressive() with the image after each pass
+        using PreviewCallback = std::function<void(const Canvas& image, int pass)>;
+
+        // see RenderAdaptive()
+        static const int kMaxAdaptiveSamples;
+        static const double kAdaptiveContrast;
+        // see RenderRegion()
+        static const int kRegionTileSize;
+        // see RenderConverged()
+        static const int kConvergenceTileSize;
+        static const int kMinConvergenceSamples;
+        static const int kConvergenceBatch;
+
         Camera(int horizontal, int vertical, double field_of_view);
 
         int Horizontal() const {
@@ -42,11 +73,66 @@ class Camera {
         void SetTransform(const Matrix& transform) {
             transform_ *= transform;
             inverse_transform_ = transform_.Inverse();
+            UpdateRays();
         }
 
         const Ray RayAt(int pixel_x, int pixel_y) const;
+        // through a point on the canvas, in pixels from its top left corner
+        const Ray RayThrough(double x, double y) const;
+        // Adds the rays through the centres of a tile of pixels, in rows, to
+        // the packet, as RayAt() would make them
+        void AddTile(RayPacket& packet, int column, int row, int columns, int rows) const;
         const Canvas Render(const World& world) const;
+        // Renders the rectangle of the image with its top left corner at the
+        // given pixel; its pixels are the same as those of the whole image.
+        // The threads take square tiles of the rectangle in turn.
+        const Canvas RenderRegion(const World& world, int column, int row, int width,
+            int height, int threads = 1, int tile_size = kRegionTileSize) const;
         const Canvas RenderConcurrent(const World& world) const;
+        const Canvas RenderPackets(const World& world, int packet_size = kMaxPacketSize) const;
+        // Traces one ray through the centre of each pixel, then refines the
+        // pixels whose colour or hit object differs from a neighbour's by
+        // tracing a ray through the centre of each quarter of the pixel,
+        // and so on for the quarters that differ, up to max_samples rays per
+        // pixel. If given, samples is set to the number of rays traced for
+        // each pixel, in rows.
+        const Canvas RenderAdaptive(const World& world, int max_samples = kMaxAdaptiveSamples,
+            std::vector<int>* samples = nullptr) const;
+        // Traces the sampler's number of rays through each pixel, placed by
+        // its pattern, and finds the colour of each pixel by weighting the
+        // samples around it with its filter. The rows are traced by the given
+        // number of threads; the image is the same however many there are.
+        const Canvas RenderMultisample(const World& world, const PixelSampler& sampler,
+            int threads = 1) const;
+        // Samples the image in tiles of kConvergenceTileSize pixels square,
+        // in rounds: each tile that hasn't converged takes a few more samples
+        // per pixel from the sampler, kMinConvergenceSamples in the first
+        // round and kConvergenceBatch after. A tile has converged when the 95%
+        // confidence interval of the mean luminance of each of its pixels is
+        // within threshold of the mean, or its pixels have the sampler's
+        // number of samples. Rendering stops when every tile has converged,
+        // or after the round that takes the time past time_budget seconds,
+        // if positive. If given, samples is set to the number of samples
+        // taken for each pixel, in rows. If given checkpoints, rendering
+        // carries on from the state saved in its file, if it was saved for
+        // the same camera and sampling (the scene is assumed to be the same),
+        // and the state is saved at the checkpoints' interval and at the end.
+        const Canvas RenderConverged(const World& world, const PixelSampler& sampler,
+            double threshold, double time_budget = 0, int threads = 1,
+            std::vector<int>* samples = nullptr, CheckpointWriter* checkpoints = nullptr) const;
+        // Traces every 16th pixel (every 4th of every 4th row) first, then
+        // every 4th, then the rest, so that a coarse image is ready early;
+        // each pass only traces the pixels the earlier ones didn't, and
+        // fills in the others from the nearest traced pixel above and to the
+        // left. If given, preview is called with the image after each pass.
+        // If time_budget is positive, tracing stops once that many seconds
+        // have passed, and the image so far is returned.
+        const Canvas RenderProgressive(const World& world, double time_budget = 0,
+            const PreviewCallback& preview = nullptr, int threads = 1) const;
+        // Traces the image in batches of pixels, each a stage at a time (see
+        // Wavefront) rather than following each primary ray recursively,
+        // optionally sorting the reflected and refracted rays of each stage
+        const Canvas RenderWavefront(const World& world, bool sort_secondary = true) const;
 };
 
 #endif
\ No newline at end of file
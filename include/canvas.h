@@ -38,4 +38,16 @@ class PPMv3 {
         friend std::ostream& operator<<(std::ostream& os, const PPMv3& ppm);
 };
 
+// The binary form of PPM, with a byte per channel, which is about a third of
+// the size of PPMv3 and quicker to write
+class PPMv6 {
+    const Canvas& canvas_;
+
+    public:
+        static const std::string kVersion;
+        PPMv6(const Canvas& c): canvas_ { c } {}
+
+        friend std::ostream& operator<<(std::ostream& os, const PPMv6& ppm);
+};
+
 #endif
\ No newline at end of file
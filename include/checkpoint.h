@@ -0,0 +1,90 @@
+#ifndef RAY_TRACER_CHECKPOINT_H
+#define RAY_TRACER_CHECKPOINT_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "colour.h"
+
+// The progress of Camera::RenderConverged(): the samples taken in each tile
+// and what they add up to so far, which is enough to carry on rendering
+// where it left off
+struct ConvergenceState {
+    // identifies the camera and sampling the state was made with
+    std::uint64_t key;
+    int width;
+    int height;
+    // the samples taken in each pixel of each tile
+    std::vector<std::int32_t> taken;
+    // the running mean of the luminance of each pixel's samples, and the
+    // sum of squared differences from it
+    std::vector<double> means;
+    std::vector<double> squares;
+    // the filtered sums of the samples around each pixel, and their weights
+    std::vector<Colour> sums;
+    std::vector<double> weights;
+
+    ConvergenceState(): key { 0 }, width { 0 }, height { 0 }, taken {}, means {},
+        squares {}, sums {}, weights {} {}
+
+    // Writes the state to the stream in native-endian binary: a magic
+    // number, the key, the image size and the number of tiles, then the
+    // arrays
+    void Save(std::ostream& os) const;
+    // Reads a state written by Save(); returns false, leaving the state
+    // unchanged, if the stream doesn't hold a complete one or any count of
+    // samples is negative
+    bool Load(std::istream& is);
+};
+
+// Saves the states of a render to a file on a thread of its own, so that
+// tracing carries on while they are written. Each state replaces the last
+// atomically (it is written to a temporary file that is then renamed), so a
+// render killed while saving leaves the previous checkpoint intact; if states
+// are queued faster than they are written, only the latest is kept.
+class CheckpointWriter {
+    std::string path_;
+    double interval_;
+    std::chrono::steady_clock::time_point last_;
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;
+    ConvergenceState pending_;
+    bool has_pending_;
+    bool writing_;
+    bool stopping_;
+    int written_;
+    std::thread thread_;
+
+    void Run();
+
+    public:
+        // Checkpoints are due every interval seconds
+        CheckpointWriter(const std::string& path, double interval);
+        CheckpointWriter(const CheckpointWriter&) = delete;
+        CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+        // Writes the queued state, if any, before returning
+        ~CheckpointWriter();
+
+        const std::string& Path() const { return path_; }
+
+        // Whether the interval has passed since the last state was queued,
+        // or since the writer was made
+        bool Due() const;
+        // Queues a state to be written
+        void Write(ConvergenceState&& state);
+        // Waits until the queued state has been written
+        void Flush();
+        // The number of states written to the file
+        int Written() const;
+
+        // Reads the state saved in the file; returns false if there is none
+        bool Resume(ConvergenceState& state) const;
+};
+
+#endif
\ No newline at end of file
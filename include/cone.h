@@ -18,6 +18,7 @@ class Cone: public Cylinder {
         bool Intersect(IntersectionList& list, const Ray& ray) const override;
         Vector LocalNormalAt(const Point &object_point) const override;
         const BoundingBox BoundsOf() const override;
+        std::size_t Memory() const override { return sizeof(*this) + HeapMemory(); }
 };
 
 #endif
\ No newline at end of file
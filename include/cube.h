@@ -2,24 +2,23 @@
 #define RAY_TRACER_CUBE_H
 
 #include <algorithm> // for max()
-#include <array>
-#include <limits>    // for infinity
 #include <cmath>     // for fabs()
 #include "shape.h"
 #include "space.h"
 
 class Cube: public Shape {
-    static std::array<double, 2> IntersectionsByAxis(const Ray& ray,
-        const SpatialTuple::Coordinates axis);
-
     public:
         Cube(): Shape { Point { 0, 0, 0 } } { bbox_ = BoundsOf(); }
         Cube(const Cube& p): Shape { p.origin_ } { bbox_ = BoundsOf(); }
 
         bool operator==(const Shape& s) const;
+        PrimitiveType Type() const override { return PrimitiveType::kCube; }
         bool Intersect(IntersectionList& list, const Ray& ray) const override;
+        LaneMask IntersectPacket(IntersectionList* lists, const RayPacket& packet,
+            LaneMask mask) const override;
         Vector LocalNormalAt(const Point &object_point) const override;
         const BoundingBox BoundsOf() const override;
+        std::size_t Memory() const override { return sizeof(*this) + HeapMemory(); }
         void Divide(int) override { /* do nothing: shape primitives are not divisible */ }
 };
 
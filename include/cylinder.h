@@ -34,6 +34,7 @@ class Cylinder: public Shape {
         bool Intersect(IntersectionList& list, const Ray& ray) const override;
         Vector LocalNormalAt(const Point &object_point) const override;
         const BoundingBox BoundsOf() const override;
+        std::size_t Memory() const override { return sizeof(*this) + HeapMemory(); }
         void Divide(int) override { /* do nothing: shape primitives are not divisible */ }
 
         void Minimum(double m) { minimum_ = m; }
@@ -21,6 +21,7 @@ class Disc: public Shape {
             return Vector { 0, 1, 0 };
         }
         const BoundingBox BoundsOf() const override;
+        std::size_t Memory() const override { return sizeof(*this) + HeapMemory(); }
         void Divide(int) override { /* do nothing: shape primitives are not divisible */ }
 };
 
@@ -0,0 +1,59 @@
+#ifndef RAY_TRACER_DISTRIBUTED_H
+#define RAY_TRACER_DISTRIBUTED_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "camera.h"
+#include "canvas.h"
+#include "world.h"
+
+// Rendering a frame across processes: a coordinator divides the image into
+// tiles and hands them out to workers as they ask for them; each worker has
+// the same scene and camera, renders its tiles with Camera::RenderRegion()
+// and streams back their pixels, and the coordinator puts the image
+// together. The processes talk over connected stream sockets in
+// native-endian binary, so they must run on the same kind of machine:
+//   worker to coordinator: a tile id of -1 to ask for the first tile, or the
+//     id of a finished tile followed by its pixels (red, green and blue
+//     doubles, in rows), which also asks for the next
+//   coordinator to worker: the id, column, row, width and height of a tile
+//     to render, or an id of -1 when the image is finished
+// The tile of a worker that disconnects is handed to another.
+
+static const int kDefaultWorkerTileSize { 32 };
+
+// Hands out the tiles of an image of the given size to the workers on the
+// sockets, and returns the image once they have rendered every tile; throws
+// std::runtime_error if every worker disconnects first
+const Canvas CoordinateWorkers(const std::vector<int>& sockets, int width, int height,
+    int tile_size = kDefaultWorkerTileSize);
+
+// Renders the tiles that the coordinator on the socket hands out until the
+// image is finished or the coordinator disconnects
+void RunWorker(int socket, const World& world, const Camera& camera);
+
+// Renders the image with the given number of worker processes, forked from
+// this one so that they share its scene; workers that fail are reported on
+// stderr, and the others render their tiles
+const Canvas RenderWithWorkers(const World& world, const Camera& camera, int workers,
+    int tile_size = kDefaultWorkerTileSize);
+
+// Listens on a Unix domain socket at the path, which mustn't exist, and
+// returns the sockets of the first count workers to connect; the path is
+// removed once they have
+std::vector<int> AcceptWorkers(const std::string& path, int count);
+
+// Sends or receives exactly size bytes on a connected socket, returning
+// false if the other end has disconnected
+bool SendAll(int socket, const void* data, std::size_t size);
+bool ReceiveAll(int socket, void* data, std::size_t size);
+
+// Returns a socket listening on a Unix domain socket at the path, which
+// mustn't exist, or connected to one, e.g. a coordinator's; throws
+// std::runtime_error if it can't
+int ListenAt(const std::string& path, int backlog);
+int ConnectTo(const std::string& path);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef RAY_TRACER_GRID_H
+#define RAY_TRACER_GRID_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "accelerator.h"
+
+// Divides the bounds of the world's objects into a uniform grid of cells and
+// steps a ray through the cells it passes through using a 3D digital
+// differential analyzer (3D-DDA); see Amanatides and Woo, "A Fast Voxel
+// Traversal Algorithm for Ray Tracing" (1987).
+class UniformGrid: public Accelerator {
+    // cells per axis
+    std::array<int, 3> resolution_;
+    std::array<double, 3> cell_size_;
+    // the indices of the shapes overlapping each cell
+    std::vector<std::vector<int>> cells_;
+    // identifies the structure built, so that each thread's mailboxes (see
+    // Intersect()) are only cleared when it changes
+    std::uint64_t build_;
+
+    int CellIndex(int x, int y, int z) const {
+        return x + resolution_[0] * (y + resolution_[1] * z);
+    }
+    int CellCoordinate(double coordinate, int axis) const;
+
+    protected:
+        void BuildStructure() override;
+
+    public:
+        // target number of cells per primitive
+        static const double kDensity;
+        static const int kMaxResolution;
+
+        UniformGrid(): Accelerator {}, resolution_ {}, cell_size_ {}, cells_ {}, build_ { 0 } {}
+
+        bool Intersect(IntersectionList& list, const Ray& ray) const override;
+        const std::array<int, 3> Resolution() const { return resolution_; }
+};
+
+#endif
\ No newline at end of file
@@ -2,17 +2,76 @@
 #define RAY_TRACER_GROUP_H
 
 #include <vector>
+#include <map>
+#include <string>
+#include <cstdint>
+#include <iostream>
+#include <atomic>
+#include <mutex>
 
 #include "shape.h"
+#include "leaf-blocks.h"
 
 #include "space.h"
 
+// Describes the shape and quality of a bounding volume hierarchy
+struct HierarchyStatistics {
+    int groups;
+    int primitives;
+    std::vector<int> groups_by_depth;
+    // primitives that did not fit into either half of their group's bounds
+    // when it was divided, by depth
+    std::vector<int> unsplit_by_depth;
+    // maps the number of primitives in a leaf group to the number of leaves
+    std::map<std::size_t, int> leaf_sizes;
+    double cost;
+    // bytes used by the groups themselves, not including the primitives
+    std::size_t memory;
+    // groups waiting to be divided on demand (see ShapeGroup::DivideLazily())
+    int undivided;
+
+    HierarchyStatistics(): groups { 0 }, primitives { 0 }, groups_by_depth {},
+        unsplit_by_depth {}, leaf_sizes {}, cost { 0 }, memory { 0 },
+        undivided { 0 } {}
+};
+
+std::ostream& operator<<(std::ostream& os, const HierarchyStatistics& stats);
+
 class ShapeGroup: public Shape {
     std::vector<Shape*> shapes_;
     std::vector<Shape*> subgroups_;
+    int threshold_;     // threshold given to the last call to Divide()
+    double build_cost_; // SAH cost of the hierarchy when it was last divided
+    bool lazy_;         // whether it was last divided by DivideLazily()
+    // set while the group is waiting to be divided by the first ray to enter
+    // it; the mutex serializes threads that enter it at the same time
+    mutable std::atomic<bool> undivided_;
+    mutable std::mutex divide_mutex_;
+    // the children sorted by type once the group is divided
+    LeafBlocks blocks_;
+
+    bool IsSubgroup(const Shape* s) const;
+    ShapeGroup* NewSubgroup(const std::vector<Shape *>& shapes);
+    void DivideOnDemand();
+    void RefitBounds();
+    void Collapse();
+    void CollectStatistics(HierarchyStatistics& stats, std::size_t depth) const;
+    std::uint64_t Hash(int threshold) const;
+    void Encode(std::vector<std::int32_t>& words,
+        const std::map<const Shape*, std::int32_t>& indices) const;
+    void Decode(const std::vector<std::int32_t>& words, std::size_t& position,
+        const std::vector<Shape*>& primitives, int threshold);
 
     public:
-        ShapeGroup(): Shape { Point { 0, 0, 0 } }, shapes_ {}, subgroups_ {} {}
+        // Relative costs used by the surface area heuristic (SAH)
+        static const double kTraversalCost;
+        static const double kIntersectionCost;
+        // Refit() rebuilds the hierarchy when its cost grows by this factor
+        static const double kMaxRefitDegradation;
+
+        ShapeGroup(): Shape { Point { 0, 0, 0 } }, shapes_ {}, subgroups_ {},
+            threshold_ { 0 }, build_cost_ { 0 }, lazy_ { false }, undivided_ { false },
+            divide_mutex_ {}, blocks_ {} {}
         ~ShapeGroup() {
             for (auto s: subgroups_) {
                 delete s;
@@ -21,18 +80,33 @@ class ShapeGroup: public Shape {
 
         const bool IsEmpty() const { return shapes_.size() == 0; }
         void Add(Shape* s);
+        // Adds the shapes, finding the group's bounds once rather than after
+        // each, which makes filling a large group linear
+        void Add(const std::vector<Shape*>& shapes);
         ShapeGroup& operator<<(Shape *s);
         bool Contains(Shape* s) const;
         const std::array<std::vector<Shape *>, 2> Partition();
         void AddSubgroup(std::vector<Shape *> shapes);
         const size_t Size() const { return shapes_.size(); }
         Shape* operator[](int i);
+        const std::vector<Shape*>& Children() const { return shapes_; }
 
         bool operator==(const Shape& s) const;
         bool Intersect(IntersectionList& list, const Ray& ray) const override;
+        LaneMask IntersectPacket(IntersectionList* lists, const RayPacket& packet,
+            LaneMask mask) const override;
         Vector LocalNormalAt(const Point &object_point) const override;
         const BoundingBox BoundsOf() const override;
         void Divide(int) override;
+        bool IsGroup() const override { return true; }
+        std::size_t Memory() const override;
+        double Cost() const;
+        bool Refit(double max_degradation = kMaxRefitDegradation);
+        const HierarchyStatistics Statistics() const;
+        void DivideAndSave(int threshold, std::ostream& os);
+        bool LoadDivided(int threshold, std::istream& is);
+        bool Divide(int threshold, const std::string& cache_path);
+        void DivideLazily(int threshold);
 };
 
 #endif
\ No newline at end of file
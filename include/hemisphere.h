@@ -13,8 +13,16 @@ class Hemisphere: public Sphere {
 
         bool operator==(const Shape& s) const override;
         bool Intersect(IntersectionList& list, const Ray& ray) const override;
+        // a hemisphere is not a sphere as far as the sphere kernels are
+        // concerned
+        LaneMask IntersectPacket(IntersectionList* lists, const RayPacket& packet,
+                LaneMask mask) const override {
+            return Shape::IntersectPacket(lists, packet, mask);
+        }
+        PrimitiveType Type() const override { return PrimitiveType::kOther; }
         Vector LocalNormalAt(const Point &object_point) const override;
         const BoundingBox BoundsOf() const override;
+        std::size_t Memory() const override { return sizeof(*this) + HeapMemory(); }
         void Divide(int) override { /* do nothing: shape primitives are not divisible */ }
 
         void Closed(bool closed) { closed_ = closed; }
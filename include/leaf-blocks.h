@@ -0,0 +1,76 @@
+#ifndef RAY_TRACER_LEAF_BLOCKS_H
+#define RAY_TRACER_LEAF_BLOCKS_H
+
+#include <array>
+#include <vector>
+
+#include "shape.h"
+#include "ray.h"
+
+class Sphere;
+class Cube;
+
+// The spheres of a group, with the data needed to intersect them copied into
+// a structure of arrays: the first three rows of each inverse transform (the
+// fourth is always 0, 0, 0, 1), each centre and each radius squared
+class SphereBlock {
+    std::vector<const Shape*> shapes_;
+    std::array<std::vector<double>, 12> inverse_;
+    std::vector<double> centre_x_;
+    std::vector<double> centre_y_;
+    std::vector<double> centre_z_;
+    std::vector<double> radius_squared_;
+
+    public:
+        SphereBlock(): shapes_ {}, inverse_ {}, centre_x_ {}, centre_y_ {},
+            centre_z_ {}, radius_squared_ {} {}
+
+        void Add(const Sphere* s);
+        void Clear();
+        std::size_t Size() const { return shapes_.size(); }
+        std::size_t Memory() const;
+        bool Intersect(IntersectionList& list, const Ray& ray) const;
+};
+
+// The cubes of a group, with the first three rows of their inverse transforms
+// copied into a structure of arrays
+class CubeBlock {
+    std::vector<const Shape*> shapes_;
+    std::array<std::vector<double>, 12> inverse_;
+
+    public:
+        CubeBlock(): shapes_ {}, inverse_ {} {}
+
+        void Add(const Cube* c);
+        void Clear();
+        std::size_t Size() const { return shapes_.size(); }
+        std::size_t Memory() const;
+        bool Intersect(IntersectionList& list, const Ray& ray) const;
+};
+
+// The children of a divided group sorted by type (see Shape::Type()), so that
+// the common primitives are intersected by kernels that loop over a block of
+// them without a virtual call each; other shapes, including subgroups, are
+// intersected as usual. The blocks copy the children's transforms, so they
+// must be rebuilt when the children change.
+class LeafBlocks {
+    SphereBlock spheres_;
+    CubeBlock cubes_;
+    std::vector<const Shape*> others_;
+    bool built_;
+
+    public:
+        LeafBlocks(): spheres_ {}, cubes_ {}, others_ {}, built_ { false } {}
+
+        void Build(const std::vector<Shape*>& shapes);
+        void Clear();
+        bool Built() const { return built_; }
+        std::size_t NSpheres() const { return spheres_.Size(); }
+        std::size_t NCubes() const { return cubes_.Size(); }
+        std::size_t NOthers() const { return others_.size(); }
+        // bytes allocated for the blocks
+        std::size_t Memory() const;
+        bool Intersect(IntersectionList& list, const Ray& ray) const;
+};
+
+#endif
\ No newline at end of file
@@ -1,6 +1,11 @@
 #ifndef RAY_TRACER_MATERIAL_H
 #define RAY_TRACER_MATERIAL_H
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include "space.h"
 #include "colour.h"
 
@@ -10,8 +15,10 @@ class Light {
     bool casts_shadow_;
 
     public:
-        Light(const Point& p, const Colour& c): position_ { p }, intensity_ { c } {}
-        Light(const Light& light): position_ { light.position_ }, intensity_ { light.intensity_} {}
+        Light(const Point& p, const Colour& c): position_ { p }, intensity_ { c },
+            casts_shadow_ { true } {}
+        Light(const Light& light): position_ { light.position_ }, intensity_ { light.intensity_},
+            casts_shadow_ { light.casts_shadow_ } {}
         const Point Position() const { return position_; }
         const Colour Intensity() const { return intensity_; }
         void CastsShadow(bool c) { casts_shadow_ = c; }
@@ -73,6 +80,10 @@ class Material {
             casts_shadow_ { m.casts_shadow_ } {}
 
         bool operator==(const Material& m) const;
+        // Exact comparison, unlike operator==, which allows for rounding
+        // errors and compares patterns by value rather than identity
+        bool Identical(const Material& m) const;
+        std::size_t Hash() const;
 
         Colour Surface() const { return surface_; }
         double Ambient() const { return ambient_; }
@@ -102,4 +113,49 @@ class Material {
         bool PatternExists() const { return pattern_ != nullptr; }
 };
 
+// Index of a material in the shared MaterialTable
+using MaterialIndex = std::uint32_t;
+
+// All the materials assigned to shapes, each stored once, so that a shape
+// refers to its material by a 32-bit index instead of holding a copy. Shapes
+// with the same material (e.g., a lattice of spheres in three colours) share
+// an entry. Entries are stored in chunks that never move, so they can be
+// looked up without locking while other threads intern more.
+//
+// Entries are never removed, so the table grows with each distinct material,
+// and an entry's pattern is only borrowed: an entry must not be used once the
+// owner of its pattern (e.g., a Scene) has freed it.
+class MaterialTable {
+    // the chunks, each of kChunkSize entries, and the number of entries used
+    std::unique_ptr<std::atomic<Material*>[]> chunks_;
+    std::size_t size_;
+    std::unordered_multimap<std::size_t, MaterialIndex> index_;
+    std::mutex mutex_;
+
+    MaterialTable();
+
+    public:
+        // the index of Material(), which all shapes start with
+        static const MaterialIndex kDefault;
+        static const MaterialIndex kChunkSize;
+        static const MaterialIndex kMaxChunks;
+
+        static MaterialTable& Shared();
+
+        MaterialTable(const MaterialTable&) = delete;
+        MaterialTable& operator=(const MaterialTable&) = delete;
+        ~MaterialTable();
+
+        // Returns the index of the entry identical to the given material,
+        // adding one if there is none; throws std::length_error if the table
+        // is full
+        MaterialIndex Intern(const Material& m);
+        const Material& At(MaterialIndex index) const {
+            return chunks_[index / kChunkSize].load(std::memory_order_acquire)[index % kChunkSize];
+        }
+        std::size_t Size();
+        // bytes allocated for the entries
+        std::size_t Memory();
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef RAY_TRACER_OCTREE_H
+#define RAY_TRACER_OCTREE_H
+
+#include <array>
+#include <vector>
+
+#include "accelerator.h"
+
+// Recursively divides the bounds of the world's objects into octants, but
+// only creates the octants that contain primitives. A primitive is stored in
+// the smallest octant that contains it entirely, so primitives straddling
+// an octant boundary stay in the octant's parent.
+class Octree: public Accelerator {
+    struct Node {
+        BoundingBox box;
+        std::vector<int> shapes;
+        // indices of the node's children in nodes_, or -1 if empty
+        std::array<int, 8> children;
+    };
+    std::vector<Node> nodes_;
+
+    void BuildNode(int node, const std::vector<int>& shapes, int depth);
+    bool IntersectNode(IntersectionList& list, const Ray& ray, int node) const;
+
+    protected:
+        void BuildStructure() override;
+
+    public:
+        static const int kMaxDepth;
+        // nodes with no more than this many primitives are not divided
+        static const int kMaxLeafSize;
+
+        Octree(): Accelerator {}, nodes_ {} {}
+
+        bool Intersect(IntersectionList& list, const Ray& ray) const override;
+        std::size_t NNodes() const { return nodes_.size(); }
+};
+
+#endif
\ No newline at end of file
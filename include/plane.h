@@ -12,11 +12,14 @@ class Plane: public Shape {
 
         bool operator==(const Shape& s) const;
         bool Intersect(IntersectionList& list, const Ray& ray) const override;
+        LaneMask IntersectPacket(IntersectionList* lists, const RayPacket& packet,
+            LaneMask mask) const override;
         Vector LocalNormalAt(const Point &object_point) const override {
             // Normal for x-z plane
             return Vector { 0, 1, 0 };
         }
         const BoundingBox BoundsOf() const override;
+        std::size_t Memory() const override { return sizeof(*this) + HeapMemory(); }
         void Divide(int) override { /* do nothing: shape primitives are not divisible */ }
 };
 
@@ -20,6 +20,7 @@ class PorousSheet: public Sheet {
 
         bool operator==(const Shape& s) const;
         bool Intersect(IntersectionList& list, const Ray& ray) const override;
+        std::size_t Memory() const override { return sizeof(*this) + HeapMemory(); }
 };
 
 #endif
\ No newline at end of file
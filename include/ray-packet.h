@@ -0,0 +1,139 @@
+#ifndef RAY_TRACER_RAY_PACKET_H
+#define RAY_TRACER_RAY_PACKET_H
+
+#include "space.h"
+#include "matrix.h"
+#include "affine.h"
+#include "ray.h"
+
+// A bitmask with one bit per lane of a packet
+using LaneMask = unsigned int;
+
+const static int kMaxPacketSize { 16 };
+
+// Up to kMaxPacketSize rays stored as a structure of arrays, so that a shape can
+// intersect all of them in loops that the compiler can vectorize. Lanes are
+// selected with a mask: shapes only intersect the lanes whose bit is set.
+class RayPacket {
+    int size_;
+    double origin_x_[kMaxPacketSize];
+    double origin_y_[kMaxPacketSize];
+    double origin_z_[kMaxPacketSize];
+    double direction_x_[kMaxPacketSize];
+    double direction_y_[kMaxPacketSize];
+    double direction_z_[kMaxPacketSize];
+    // see Ray::InverseDirection()
+    double inverse_direction_x_[kMaxPacketSize];
+    double inverse_direction_y_[kMaxPacketSize];
+    double inverse_direction_z_[kMaxPacketSize];
+
+    public:
+        RayPacket(): size_ { 0 } {}
+
+        int Size() const { return size_; }
+        LaneMask Mask() const { return (1u << size_) - 1; }
+
+        // Adds a ray to the next lane; returns false if the packet is full
+        bool Add(const Ray& ray) {
+            if (size_ == kMaxPacketSize) {
+                return false;
+            }
+            Point origin = ray.Origin();
+            Vector direction = ray.Direction();
+            origin_x_[size_] = origin.X();
+            origin_y_[size_] = origin.Y();
+            origin_z_[size_] = origin.Z();
+            direction_x_[size_] = direction.X();
+            direction_y_[size_] = direction.Y();
+            direction_z_[size_] = direction.Z();
+            inverse_direction_x_[size_] = ray.InverseDirection(0);
+            inverse_direction_y_[size_] = ray.InverseDirection(1);
+            inverse_direction_z_[size_] = ray.InverseDirection(2);
+            size_++;
+            return true;
+        }
+
+        // Adds a ray from its components to the next lane, as Add(const Ray&)
+        // would; returns false if the packet is full
+        bool Add(const double* origin, double direction_x, double direction_y,
+                double direction_z) {
+            if (size_ == kMaxPacketSize) {
+                return false;
+            }
+            origin_x_[size_] = origin[0];
+            origin_y_[size_] = origin[1];
+            origin_z_[size_] = origin[2];
+            direction_x_[size_] = direction_x;
+            direction_y_[size_] = direction_y;
+            direction_z_[size_] = direction_z;
+            inverse_direction_x_[size_] = 1.0 / direction_x;
+            inverse_direction_y_[size_] = 1.0 / direction_y;
+            inverse_direction_z_[size_] = 1.0 / direction_z;
+            size_++;
+            return true;
+        }
+
+        const Ray At(int lane) const {
+            return Ray {
+                Point { origin_x_[lane], origin_y_[lane], origin_z_[lane] },
+                Vector { direction_x_[lane], direction_y_[lane], direction_z_[lane] }
+            };
+        }
+
+        const double* OriginX() const { return origin_x_; }
+        const double* OriginY() const { return origin_y_; }
+        const double* OriginZ() const { return origin_z_; }
+        const double* DirectionX() const { return direction_x_; }
+        const double* DirectionY() const { return direction_y_; }
+        const double* DirectionZ() const { return direction_z_; }
+        const double* InverseDirectionX() const { return inverse_direction_x_; }
+        const double* InverseDirectionY() const { return inverse_direction_y_; }
+        const double* InverseDirectionZ() const { return inverse_direction_z_; }
+
+        // Same as Ray::Transform() for every lane, with the operations in the
+        // same order so that the results (including the reciprocal
+        // directions) are identical
+        const RayPacket Transform(const Matrix& transform) const {
+            return Transform(AffineTransform { transform });
+        }
+
+        const RayPacket Transform(const AffineTransform& transform) const {
+            double m[3][4];
+            for (int row = 0; row < 3; row++) {
+                for (int column = 0; column < 4; column++) {
+                    m[row][column] = transform.At(row, column);
+                }
+            }
+            RayPacket packet {};
+            packet.size_ = size_;
+            for (int lane = 0; lane < size_; lane++) {
+                double x = origin_x_[lane], y = origin_y_[lane], z = origin_z_[lane];
+                packet.origin_x_[lane] = m[0][0] * x + m[0][1] * y + m[0][2] * z + m[0][3];
+                packet.origin_y_[lane] = m[1][0] * x + m[1][1] * y + m[1][2] * z + m[1][3];
+                packet.origin_z_[lane] = m[2][0] * x + m[2][1] * y + m[2][2] * z + m[2][3];
+            }
+            for (int lane = 0; lane < size_; lane++) {
+                double x = direction_x_[lane], y = direction_y_[lane], z = direction_z_[lane];
+                packet.direction_x_[lane] = m[0][0] * x + m[0][1] * y + m[0][2] * z;
+                packet.direction_y_[lane] = m[1][0] * x + m[1][1] * y + m[1][2] * z;
+                packet.direction_z_[lane] = m[2][0] * x + m[2][1] * y + m[2][2] * z;
+            }
+            for (int lane = 0; lane < size_; lane++) {
+                packet.inverse_direction_x_[lane] = 1.0 / packet.direction_x_[lane];
+                packet.inverse_direction_y_[lane] = 1.0 / packet.direction_y_[lane];
+                packet.inverse_direction_z_[lane] = 1.0 / packet.direction_z_[lane];
+            }
+            return packet;
+        }
+};
+
+// The number of lanes selected by a mask
+inline int LaneCount(LaneMask mask) {
+    int count { 0 };
+    for (; mask; mask &= mask - 1) {
+        count++;
+    }
+    return count;
+}
+
+#endif
\ No newline at end of file
@@ -1,18 +1,38 @@
 #ifndef RAY_TRACER_RAY_H
 #define RAY_TRACER_RAY_H
 
+#include <array>
+
 #include "space.h"
 #include "matrix.h"
+#include "affine.h"
 
 class Ray {
     Point origin;
     Vector direction;
+    // Computed once for the slab tests in BoundingBox::Intersects(): the
+    // reciprocal of each component of the direction (infinite for a zero
+    // component), and whether it is negative
+    std::array<double, 3> inverse_direction;
+    std::array<int, 3> sign;
+
+    void ComputeInverseDirection() {
+        for (int axis = 0; axis < 3; axis++) {
+            inverse_direction[axis] = 1.0 / direction.At(axis);
+            sign[axis] = (inverse_direction[axis] < 0) ? 1 : 0;
+        }
+    }
 
     public:
-        Ray(const Point& p, const Vector& v): origin { p }, direction { v } {}
-        Ray(const Ray& r): origin { r.origin }, direction { r.direction } {}
-        const Point Origin() const {  return origin; }
-        const Vector Direction() const { return direction; }
+        Ray(const Point& p, const Vector& v): origin { p }, direction { v } {
+            ComputeInverseDirection();
+        }
+        Ray(const Ray& r): origin { r.origin }, direction { r.direction },
+            inverse_direction { r.inverse_direction }, sign { r.sign } {}
+        const Point& Origin() const {  return origin; }
+        const Vector& Direction() const { return direction; }
+        double InverseDirection(int axis) const { return inverse_direction[axis]; }
+        int Sign(int axis) const { return sign[axis]; }
         const Point Position(double t) const {
             return origin + direction * t;
         }
@@ -21,9 +41,16 @@ class Ray {
             Vector v = transform * direction;
             return Ray { p, v };
         }
+        const Ray Transform(const AffineTransform& transform) const {
+            Point p = transform * origin;
+            Vector v = transform * direction;
+            return Ray { p, v };
+        }
         Ray& operator=(const Ray& r) {
             origin = r.origin;
             direction = r.direction;
+            inverse_direction = r.inverse_direction;
+            sign = r.sign;
             return *this;
         }
 };
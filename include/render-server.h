@@ -0,0 +1,84 @@
+#ifndef RAY_TRACER_RENDER_SERVER_H
+#define RAY_TRACER_RENDER_SERVER_H
+
+#include <string>
+
+#include "camera.h"
+#include "canvas.h"
+#include "world.h"
+
+// A frame asked of a RenderServer, in one line of text: the word "render"
+// followed by any of
+//   width=<pixels> height=<pixels> fov=<radians>
+//   from=<x>,<y>,<z> to=<x>,<y>,<z> up=<x>,<y>,<z>
+//   crop=<column>,<row>,<width>,<height>
+// Whatever isn't given is taken from the server's camera; from, to and up
+// make a view transform, with to and up defaulting to the origin and the y
+// axis. With crop, only that rectangle of the image is rendered. Images are
+// at most 16384 pixels on a side and 16777216 pixels in all.
+struct RenderRequest {
+    int width;
+    int height;
+    double field_of_view;
+    bool has_view;
+    Point from;
+    Point to;
+    Vector up;
+    bool has_crop;
+    int crop_column;
+    int crop_row;
+    int crop_width;
+    int crop_height;
+
+    // A request for exactly the given camera's image
+    RenderRequest(const Camera& camera);
+
+    // Updates the request from a line in the format above; throws
+    // std::invalid_argument, leaving it unchanged, if the line isn't one
+    void Parse(const std::string& line);
+
+    // The camera the request asks for, which starts from the given one
+    const Camera MakeCamera(const Camera& camera) const;
+};
+
+// Keeps a scene loaded and renders frames of it on request, so that each
+// frame costs only its tracing. The server listens on a Unix domain socket;
+// each client connects, sends a request line (see RenderRequest) and reads
+// back the frame as a PPM image, or a line starting "error: " if the request
+// couldn't be rendered, before the server closes the connection. A line of
+// "stop" stops the server. For example,
+//   echo "render width=400 height=200 crop=0,0,200,100" |
+//       socat - UNIX-CONNECT:/tmp/scene.sock > frame.ppm
+class RenderServer {
+    const World& world_;
+    Camera camera_;
+    std::string path_;
+    int threads_;
+    int listener_;
+    int frames_;
+
+    public:
+        // Listens at the path, which mustn't exist, rendering with the given
+        // number of threads; throws std::runtime_error if it can't
+        RenderServer(const World& world, const Camera& camera, const std::string& path,
+            int threads = 1);
+        RenderServer(const RenderServer&) = delete;
+        RenderServer& operator=(const RenderServer&) = delete;
+        // Stops listening and removes the socket
+        ~RenderServer();
+
+        const std::string& Path() const { return path_; }
+        // The number of frames rendered so far
+        int Frames() const { return frames_; }
+
+        // Renders the frame a request line asks for
+        const Canvas Render(const std::string& line) const;
+
+        // Answers clients one at a time until one asks the server to stop
+        void Serve();
+};
+
+// Sends a request line to the server at the path and returns its reply
+std::string RequestRender(const std::string& path, const std::string& line);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,58 @@
+#ifndef RAY_TRACER_SAMPLER_H
+#define RAY_TRACER_SAMPLER_H
+
+#include <cstdint>
+#include <string>
+
+// How the samples of a pixel are placed within it:
+//   kRandom: independently, uniformly at random
+//   kStratified: one at random in each cell of a grid over the pixel
+//   kHalton: the points of the Halton sequence in bases 2 and 3
+//   kSobol: the points of the first two dimensions of the Sobol sequence
+enum class SamplePattern { kRandom, kStratified, kHalton, kSobol };
+
+// How the samples near a pixel are weighted to find its colour:
+//   kBox: the samples within the pixel, equally
+//   kTent: the samples within a pixel of its centre, by distance
+//   kMitchell: the samples within two pixels of its centre, by the
+//     Mitchell-Netravali filter (B = C = 1/3), which is sharper than the
+//     tent but has negative lobes
+enum class PixelFilter { kBox, kTent, kMitchell };
+
+// Places the samples of each pixel and weights them for reconstructing the
+// image (see Camera::RenderMultisample()). The placement is scrambled by a
+// hash of the pixel's coordinates and the seed, so that neighbouring pixels
+// don't share a pattern, yet each pixel's samples are the same however the
+// image is divided between threads.
+class PixelSampler {
+    int samples_;
+    SamplePattern pattern_;
+    PixelFilter filter_;
+    std::uint32_t seed_;
+
+    public:
+        PixelSampler(int samples, SamplePattern pattern = SamplePattern::kSobol,
+            PixelFilter filter = PixelFilter::kBox, std::uint32_t seed = 0);
+
+        int Samples() const { return samples_; }
+        SamplePattern Pattern() const { return pattern_; }
+        PixelFilter Filter() const { return filter_; }
+        std::uint32_t Seed() const { return seed_; }
+
+        // Sets x and y to the position, in [0, 1), of the given sample within
+        // the pixel, from its top left corner
+        void Sample(int pixel_x, int pixel_y, int index, double& x, double& y) const;
+
+        // The furthest a sample may be from the centre of a pixel along
+        // either axis, in pixels, and still count towards its colour
+        double Radius() const;
+        // The weight of a sample the given offsets from the centre of a pixel
+        double Weight(double dx, double dy) const;
+
+        // The patterns and filters by name, e.g. "halton" or "mitchell";
+        // unknown names throw std::invalid_argument
+        static SamplePattern ParsePattern(const std::string& name);
+        static PixelFilter ParseFilter(const std::string& name);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,108 @@
+#ifndef RAY_TRACER_SCENE_FILE_H
+#define RAY_TRACER_SCENE_FILE_H
+
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "camera.h"
+#include "material.h"
+#include "pattern.h"
+#include "scene.h"
+#include "shape.h"
+#include "transformations.h"
+#include "world.h"
+#include "yaml.h"
+
+// A world and camera described by a file in the YAML format of the book's
+// bonus chapters, e.g.
+//
+//     - add: camera
+//       width: 100
+//       height: 50
+//       field-of-view: 1.047
+//       from: [ 0, 1.5, -5 ]
+//       to: [ 0, 1, 0 ]
+//       up: [ 0, 1, 0 ]
+//     - add: light
+//       at: [ -10, 10, -10 ]
+//       intensity: [ 1, 1, 1 ]
+//     - define: shiny
+//       value:
+//         reflective: 0.3
+//     - define: red
+//       extend: shiny
+//       value:
+//         color: [ 1, 0.2, 0.2 ]
+//     - add: sphere
+//       material: red
+//       transform:
+//         - [ scale, 0.5, 0.5, 0.5 ]
+//         - [ translate, 0, 0.5, 0 ]
+//
+// or the same as JSON. The file is a list of entries, each built as soon as
+// it has been read:
+//   add: camera, with width, height, field-of-view (radians), from, to, up
+//   add: light, with at and intensity
+//   add: sphere, plane, cube, cylinder, cone, hemisphere or group, with a
+//     material, a transform and, for cylinders and cones, min, max and
+//     closed; groups have children, a list of shapes, which take the group's
+//     material if they have none of their own
+//   define: a name, with a value that is a material or a transform; a
+//     material may extend another, which it adds to, and a transform may
+//     include others, which must be defined before it
+// A material is the name of a defined one or a mapping of any of color,
+// ambient, diffuse, specular, shininess, reflective, transparency,
+// refractive-index, shadow (whether it casts one) and pattern; a pattern has
+// a type (stripes, gradient, rings or checkers), colors (two colours or
+// patterns) and a transform. A transform is a list of [ translate, x, y, z ],
+// [ scale, x, y, z ], [ rotate-x, radians ] (and -y and -z), [ shear, xy, xz,
+// yx, yz, zx, zy ] and names of defined transforms, applied in that order.
+// Colours, points and vectors are lists of three numbers.
+class SceneFile {
+    // owns the shapes and patterns
+    Scene objects_;
+    std::deque<Light> lights_;
+    std::unique_ptr<Camera> camera_;
+    World world_;
+    std::map<std::string, YamlNode> definitions_;
+    // the materials made, so that shapes with the same one share its
+    // patterns and its entry in the MaterialTable: those defined by name,
+    // and those written in the entry being added (e.g., a group's)
+    std::map<std::string, Material> named_materials_;
+    std::map<const YamlNode*, Material> entry_materials_;
+    std::size_t shapes_;
+
+    void Add(const YamlNode& entry);
+    void Define(const YamlNode& entry);
+    Shape* MakeShape(const YamlNode& node, const YamlNode* inherited);
+    const Material& MakeMaterial(const YamlNode& node);
+    Pattern* MakePattern(const YamlNode& node);
+    void ApplyTransform(Transformation& transform, const YamlNode& node) const;
+    const YamlNode& Definition(const YamlNode& name) const;
+    const YamlNode& TransformDefinition(const YamlNode& name) const;
+
+    public:
+        SceneFile(): objects_ {}, lights_ {}, camera_ {}, world_ {}, definitions_ {},
+            named_materials_ {}, entry_materials_ {}, shapes_ { 0 } {}
+        SceneFile(const SceneFile&) = delete;
+        SceneFile& operator=(const SceneFile&) = delete;
+
+        // Adds the entries of the file to the scene; throws
+        // std::invalid_argument, naming the line, if they aren't valid, and
+        // std::runtime_error if the file can't be opened
+        void Load(std::istream& is);
+        void Load(const std::string& path);
+
+        const World& SceneWorld() const { return world_; }
+        World& SceneWorld() { return world_; }
+        bool HasCamera() const { return camera_ != nullptr; }
+        // Throws std::runtime_error if the scene has no camera
+        const Camera& SceneCamera() const;
+        // The number of shapes made, including the children of groups
+        std::size_t NShapes() const { return shapes_; }
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,79 @@
+#ifndef RAY_TRACER_SCENE_H
+#define RAY_TRACER_SCENE_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// An arena that owns the objects of a scene (shapes, groups, patterns, ...),
+// placing them one after another in large blocks in the order they are made,
+// so that objects built together are near each other in memory. Nothing is
+// freed until the scene is cleared or destroyed, which releases the blocks
+// in one pass: objects that own no resources aren't visited at all, and the
+// others are only destroyed, not individually freed.
+//
+//     Scene scene {};
+//     Sphere* s = scene.Make<Sphere>();
+//     ShapeGroup* g = scene.Make<ShapeGroup>();
+//
+// Objects made by a scene must not be deleted, and must not outlive it.
+class Scene {
+    struct Destructor {
+        void* object;
+        void (*destroy)(void*);
+    };
+
+    std::size_t block_size_;
+    std::vector<char*> blocks_;
+    char* next_;  // the next free byte in the last block
+    char* end_;   // the end of the last block
+    std::vector<Destructor> destructors_;
+    std::size_t objects_;
+    std::size_t used_;     // bytes given to objects
+    std::size_t reserved_; // bytes allocated for blocks
+    std::size_t peak_;     // the most bytes reserved at any time
+
+    void* Allocate(std::size_t size, std::size_t alignment);
+
+    template <typename T>
+    static void Destroy(void* object) {
+        static_cast<T*>(object)->~T();
+    }
+
+    public:
+        static const std::size_t kDefaultBlockSize;
+
+        Scene(std::size_t block_size = kDefaultBlockSize): block_size_ { block_size },
+            blocks_ {}, next_ { nullptr }, end_ { nullptr }, destructors_ {},
+            objects_ { 0 }, used_ { 0 }, reserved_ { 0 }, peak_ { 0 } {}
+        Scene(const Scene&) = delete;
+        Scene& operator=(const Scene&) = delete;
+        ~Scene() { Clear(); }
+
+        // templated methods must be defined in the header file
+        template <typename T, typename... Args>
+        T* Make(Args&&... args) {
+            void* memory = Allocate(sizeof(T), alignof(T));
+            T* object = new (memory) T(std::forward<Args>(args)...);
+            objects_++;
+            if (!std::is_trivially_destructible<T>::value) {
+                destructors_.push_back(Destructor { object, &Destroy<T> });
+            }
+            return object;
+        }
+
+        // Destroys every object made by the scene and releases its blocks
+        void Clear();
+
+        std::size_t NObjects() const { return objects_; }
+        std::size_t NBlocks() const { return blocks_.size(); }
+        // bytes given to objects
+        std::size_t Used() const { return used_; }
+        // bytes allocated for blocks now, and at most since construction
+        std::size_t Memory() const { return reserved_; }
+        std::size_t PeakMemory() const { return peak_; }
+};
+
+#endif
\ No newline at end of file
@@ -1,14 +1,18 @@
 #ifndef RAY_TRACER_SHAPE_H
 #define RAY_TRACER_SHAPE_H
 
-#include <list>
-#include <set>
+#include <vector>
+#include <utility>
 #include <stdexcept>
 #include <iterator>
+#include <atomic>
+#include <iostream>
 #include <cmath> // for sqrt
 #include "space.h"
 #include "ray.h"
+#include "ray-packet.h"
 #include "matrix.h"
+#include "affine.h"
 #include "colour.h"
 #include "material.h"
 #include "bounds.h"
@@ -16,37 +20,104 @@
 class IntersectionList;
 class ShapeGroup;
 
+// Counters for the work done intersecting rays with the world's objects.
+// They are shared by all rendering threads, so they are only updated after
+// being enabled.
+//
+// The groups and shapes a ray visits are also passed through a simulated
+// cache, a stand-in for hardware counters as a measure of how coherent
+// successive rays are: each thread has a direct-mapped cache of
+// kSimulatedCacheLines lines of 64 bytes, and a visit to an object whose
+// first line isn't in it counts as a miss.
+class TraversalStatistics {
+    static std::atomic<bool> enabled_;
+    static std::atomic<unsigned long long> rays_;
+    static std::atomic<unsigned long long> groups_visited_;
+    static std::atomic<unsigned long long> primitives_tested_;
+    static std::atomic<unsigned long long> rays_pruned_;
+    static std::atomic<unsigned long long> cache_misses_;
+
+    static void CountAccess(const void* object);
+
+    public:
+        static void Enable(bool enabled = true) { enabled_ = enabled; }
+        static bool Enabled() { return enabled_.load(std::memory_order_relaxed); }
+        static void Reset();
+        static void CountRay() {
+            rays_.fetch_add(1, std::memory_order_relaxed);
+        }
+        static const int kSimulatedCacheLines;
+
+        static void CountGroupVisit(const Shape* group) {
+            groups_visited_.fetch_add(1, std::memory_order_relaxed);
+            CountAccess(group);
+        }
+        static void CountShapeTest(const Shape* s);
+        // a secondary ray not traced because it would contribute too little
+        static void CountPrunedRay() {
+            rays_pruned_.fetch_add(1, std::memory_order_relaxed);
+        }
+        static void CountPrimitiveTests(unsigned long long n) {
+            primitives_tested_.fetch_add(n, std::memory_order_relaxed);
+        }
+        static unsigned long long Rays() { return rays_; }
+        static unsigned long long GroupsVisited() { return groups_visited_; }
+        static unsigned long long PrimitivesTested() { return primitives_tested_; }
+        static unsigned long long RaysPruned() { return rays_pruned_; }
+        static unsigned long long CacheMisses() { return cache_misses_; }
+        static void Report(std::ostream& os);
+};
+
+// Identifies the primitives that a divided group intersects with specialized
+// kernels rather than virtual calls (see LeafBlocks)
+enum class PrimitiveType { kOther, kSphere, kCube };
+
 class Shape {
     protected:
+        // Hot data, read for every ray that reaches the shape: the inverse
+        // transform (stored inline; see AffineTransform) and the bounding box
+        // in parent space
+        AffineTransform inverse_transform_;
+        BoundingBox bbox_;
+        // Cold data, only read while building the scene or shading a hit
+        ShapeGroup* parent_;
+        MaterialIndex material_; // see MaterialTable
         Point origin_;
         Matrix transform_;
-        Matrix inverse_transform_;
-        Material material_;
-        ShapeGroup* parent_;
-        BoundingBox bbox_; // save bounding box of shape in parent space
+
+        // Bytes allocated on the heap by the shape's base class
+        std::size_t HeapMemory() const {
+            return transform_.Nrows() * (sizeof(double*) + transform_.Ncolumns() * sizeof(double));
+        }
 
     public:
         static const double kEpsilon;
 
         Shape(const Point& p):
-            origin_ { p },
-            transform_ { Matrix::Identity(4) },
-            inverse_transform_ { Matrix::Identity(4) },
-            material_ { Material() },
+            inverse_transform_ {},
+            bbox_ {},
             parent_ { nullptr },
-            bbox_ {} {}
+            material_ { MaterialTable::kDefault },
+            origin_ { p },
+            transform_ { Matrix::Identity(4) } {}
 
         Shape(const Shape& s):
-            origin_ { s.origin_ },
-            transform_ { s.transform_ },
             inverse_transform_ { s.inverse_transform_ },
-            material_ { s.material_ },
+            bbox_ { s.bbox_ },
             parent_ { s.parent_ },
-            bbox_ { s.bbox_ } {}
+            material_ { s.material_ },
+            origin_ { s.origin_ },
+            transform_ { s.transform_ } {}
 
         virtual ~Shape() {} // required for abstract base class
 
         virtual bool Intersect(IntersectionList& list, const Ray& ray) const = 0;
+        // Intersects the rays in the lanes selected by the mask, adding the
+        // intersections of each lane to lists[lane], and returns the lanes
+        // that intersected the shape. By default the rays are intersected
+        // one at a time; shapes override this with a vectorizable kernel.
+        virtual LaneMask IntersectPacket(IntersectionList* lists,
+            const RayPacket& packet, LaneMask mask) const;
 
         virtual Vector LocalNormalAt(const Point &object_point) const = 0;
         Vector NormalAt(const Point &world_point) const;
@@ -59,8 +130,13 @@ class Shape {
         }
 
         virtual void Divide(int threshold) = 0;
+        virtual bool IsGroup() const { return false; }
+        virtual PrimitiveType Type() const { return PrimitiveType::kOther; }
 
         const Point Origin() const { return origin_; }
+        // Bytes used by the shape, including its heap allocations but not
+        // those of its children or material
+        virtual std::size_t Memory() const { return sizeof(Shape) + HeapMemory(); }
 
         bool operator!=(const Shape& s) const {
             return !operator==(s);
@@ -68,7 +144,7 @@ class Shape {
 
         void SetTransform(const Matrix& m) {
             transform_ *= m;
-            inverse_transform_ = transform_.Inverse();
+            inverse_transform_ = AffineTransform { transform_.Inverse() };
             // transform the shape's bounding box by its transformation matrix
             // to get the box in parent space
             bbox_ = BoundsOf().Transform(transform_);
@@ -78,16 +154,16 @@ class Shape {
             return transform_;
         }
 
-        const Matrix& InverseTransform() const {
+        const AffineTransform& InverseTransform() const {
             return inverse_transform_;
         }
 
         void SetMaterial(const Material& m) {
-            material_ = m;
+            material_ = MaterialTable::Shared().Intern(m);
         }
 
         const Material& ShapeMaterial() const {
-            return material_;
+            return MaterialTable::Shared().At(material_);
         }
 
         Colour ApplyLightAt(const Light& light, const Point& point,
@@ -141,6 +217,33 @@ class Intersection {
         }
 };
 
+// The most deeply nested objects a ray is tracked inside of
+const static int kMaxMediumDepth { 16 };
+
+// The objects a ray is inside of, innermost last, from which the refractive
+// indices on either side of a surface are found. In a well-formed scene a
+// ray leaves objects in the reverse of the order it entered them, so leaving
+// one is usually a pop. Objects nested more deeply than kMaxMediumDepth are
+// ignored.
+class MediumStack {
+    const Shape* objects_[kMaxMediumDepth];
+    int size_;
+
+    public:
+        MediumStack(): size_ { 0 } {}
+        int Size() const { return size_; }
+        bool Contains(const Shape* s) const;
+        // Enters the object if the ray is outside it, otherwise leaves it
+        void Cross(const Shape* s);
+        // of the innermost object, or 1.0 if the ray is outside every object
+        double RefractiveIndex() const;
+};
+
+// The shading record for a hit. Only what every material needs (the point,
+// eye vector and normal) is found when it is made; the points just above and
+// below the surface and the reflection vector are found when asked for, and
+// the refractive indices as described below, so that opaque or unreflective
+// materials don't pay for them.
 class IntersectionComputation {
     const Shape* object_;
     double distance_;
@@ -148,62 +251,114 @@ class IntersectionComputation {
     Vector eye_vector_;
     Vector normal_vector_;
     bool inside_;
-    Point over_point_;
-    Vector reflection_vector_;
-    // refractive indices
-    double n1_;
-    double n2_;
-    Point under_point_;
+    // The objects the ray is inside of before it reaches the hit, and the
+    // refractive indices on either side of it. Unless the medium was carried
+    // along the ray's path, these are found from the intersections with the
+    // ray only if the hit is transparent or they are asked for, so the list
+    // must outlive the computation.
+    IntersectionList* xs_;
+    mutable MediumStack medium_;
+    mutable bool medium_known_;
+    mutable double n1_;
+    mutable double n2_;
+
+    void FindMedium() const;
+    void FindRefractiveIndices() const;
 
     public:
         static const double kEpsilon;
         IntersectionComputation(const Intersection& i, const Ray& r,
             IntersectionList* xs = nullptr);
+        // For a ray that travels through the given medium, e.g., one
+        // reflected or refracted at a previous hit
+        IntersectionComputation(const Intersection& i, const Ray& r,
+            const MediumStack& medium);
         const Shape* Object() const { return object_; }
         double Distance() const { return distance_; }
         const Point WorldPoint() const { return point_; }
         const Vector EyeVector() const { return eye_vector_; }
         const Vector NormalVector() const { return normal_vector_; }
         bool Inside() const { return inside_; }
-        const Point OverPoint() const { return over_point_; }
-        const Vector ReflectionVector() const { return reflection_vector_; }
-        const double N1() const { return n1_; }
-        const double N2() const { return n2_; }
-        const Point UnderPoint() const { return under_point_; }
+        const Point OverPoint() const { return point_ + normal_vector_ * kEpsilon; }
+        const Vector ReflectionVector() const {
+            return Vector::Reflect(-eye_vector_, normal_vector_);
+        }
+        const double N1() const;
+        const double N2() const;
+        const Point UnderPoint() const { return point_ - normal_vector_ * kEpsilon; }
         const double Reflectance() const;
+        // The medium a ray reflected at the hit travels through, or nullptr
+        // if it hasn't been found
+        const MediumStack* ReflectedMedium() const;
+        // The medium a ray refracted at the hit travels through
+        const MediumStack RefractedMedium() const;
 };
 
 class IntersectionList {
-    const Intersection* hit_;
-    const Intersection* shadow_hit_;
-
-    struct IntersectionComparator
-    {
-        bool operator()(const Intersection* a, const Intersection* b) const {
-            return a->Distance() < b->Distance();
-        }
-    };
-    using ListType = std::multiset<const Intersection*, IntersectionComparator>;
-    ListType list_;
+    using Storage = std::vector<Intersection>;
+
+    // The intersections in the order they were added, until something asks
+    // for them in order of distance. Storage is taken from a pool kept by
+    // each thread and returned to it when the list is destroyed, so that
+    // once a thread has warmed up its lists don't allocate.
+    Storage list_;
+    bool sorted_;
+    // indices in list_ of Hit() and ShadowHit(), or -1 for none
+    int hit_;
+    int shadow_hit_;
+
+    static Storage TakeStorage();
+    static void ReturnStorage(Storage& storage);
+    void Sort();
 
     public:
-        IntersectionList(): hit_ { nullptr }, shadow_hit_ { nullptr },
-            list_ {} { }
-        ~IntersectionList();
+        // A forward iterator over pointers to the intersections, for
+        // compatibility with code that iterates over the list
+        class Iterator {
+            const Intersection* i_;
+
+            public:
+                Iterator(const Intersection* i): i_ { i } {}
+                const Intersection* operator*() const { return i_; }
+                Iterator& operator++() { i_++; return *this; }
+                bool operator==(const Iterator& it) const { return i_ == it.i_; }
+                bool operator!=(const Iterator& it) const { return i_ != it.i_; }
+        };
+
+        IntersectionList(): list_ { TakeStorage() }, sorted_ { true }, hit_ { -1 },
+            shadow_hit_ { -1 } {}
+        IntersectionList(IntersectionList&& xs): list_ { std::move(xs.list_) },
+            sorted_ { xs.sorted_ }, hit_ { xs.hit_ }, shadow_hit_ { xs.shadow_hit_ } {
+            xs.list_.clear();
+            xs.hit_ = xs.shadow_hit_ = -1;
+        }
+        IntersectionList(const IntersectionList&) = delete;
+        IntersectionList& operator=(const IntersectionList&) = delete;
+        ~IntersectionList() { ReturnStorage(list_); }
         const Intersection* operator[](unsigned int index);
+        // takes ownership of the intersection
         void Add(const Intersection* i);
         void Add(double d, const Shape* s);
         void Add(const Intersection& i);
         int Size() const { return list_.size(); }
+        // The pointers returned by these and operator[] are only valid until
+        // the list is added to or iterated over
         const Intersection* Hit() const;
         const Intersection* ShadowHit() const;
+        // Intersections further along the ray than this can't change Hit()
+        // or ShadowHit(), so shapes beyond it don't need to be tested
+        double CullDistance() const {
+            return (shadow_hit_ >= 0) ? list_[shadow_hit_].Distance() : kBBInfinity;
+        }
         IntersectionList& operator<<(const Intersection* i);
         IntersectionList& operator<<(const Intersection& i);
-        ListType::iterator begin() {
-            return list_.begin();
+        Iterator begin() {
+            Sort();
+            return Iterator { list_.data() };
         }
-        ListType::iterator end() {
-            return list_.end();
+        Iterator end() {
+            Sort();
+            return Iterator { list_.data() + list_.size() };
         }
 };
 
@@ -12,12 +12,16 @@ class Sphere: public Shape {
         Sphere(const Point& p, double r): Shape { p }, radius_ { r } { bbox_ = BoundsOf(); }
         Sphere(const Sphere& s): Shape { s.origin_ }, radius_ { s.radius_ } { bbox_ = BoundsOf(); }
 
-        const double Radius() { return radius_; }
+        double Radius() const { return radius_; }
+        PrimitiveType Type() const override { return PrimitiveType::kSphere; }
 
         bool operator==(const Shape& s) const override;
         bool Intersect(IntersectionList& list, const Ray& ray) const override;
+        LaneMask IntersectPacket(IntersectionList* lists, const RayPacket& packet,
+            LaneMask mask) const override;
         Vector LocalNormalAt(const Point &object_point) const override;
         const BoundingBox BoundsOf() const override;
+        std::size_t Memory() const override { return sizeof(*this) + HeapMemory(); }
         void Divide(int) override { /* do nothing: shape primitives are not divisible */ }
 };
 
@@ -6,6 +6,20 @@
 #include <iostream>
 
 class Tuple {
+    // Tuples of up to this many elements (points, vectors and colours) keep
+    // them inline; only larger ones allocate them on the heap
+    static const std::size_t kInlineSize { 4 };
+    double inline_[kInlineSize];
+
+    void Allocate(std::size_t n) {
+        elements_ = (n <= kInlineSize) ? inline_ : new double[n];
+    }
+    void Release() {
+        if (elements_ != inline_) {
+            delete[] elements_;
+        }
+    }
+
     protected:
         double *elements_;
         std::size_t size_;
@@ -16,7 +30,7 @@ class Tuple {
             if (N < 0) {
                 throw std::invalid_argument("Tuple size must be > 0");
             }
-            elements_ = new double[N];
+            Allocate(N);
             for (int i = 0; i < N; i++) {
                 elements_[i] = src[i];
             }
@@ -29,7 +43,7 @@ class Tuple {
         Tuple(const Tuple& t);
 
         ~Tuple() {
-            delete[] elements_;
+            Release();
         }
 
         bool operator==(const Tuple& t) const;
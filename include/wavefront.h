@@ -0,0 +1,86 @@
+#ifndef RAY_TRACER_WAVEFRONT_H
+#define RAY_TRACER_WAVEFRONT_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "shape.h"
+#include "ray.h"
+#include "material.h"
+
+// A ray waiting to be traced in a wavefront: the colour found for it is
+// scaled by weight and added to colours[slot], where the slot is usually a
+// pixel. depth is the number of reflected or refracted rays that may still
+// follow from it, and the medium the objects it is inside of, if known.
+struct WavefrontRay {
+    Ray ray;
+    int slot;
+    double weight;
+    int depth;
+    bool medium_known;
+    MediumStack medium;
+
+    WavefrontRay(const Ray& r, int s, double w, int d): ray { r }, slot { s },
+        weight { w }, depth { d }, medium_known { false }, medium {} {}
+    WavefrontRay(const Ray& r, int s, double w, int d, const MediumStack& m):
+        ray { r }, slot { s }, weight { w }, depth { d }, medium_known { true },
+        medium { m } {}
+};
+
+// A ray from a hit towards a light: once it is known whether anything is in
+// the way, the light's contribution at the hit is added to colours[slot]
+struct ShadowRay {
+    Ray ray;
+    double distance; // to the light
+    const Light* light;
+    const Shape* object;
+    Point point;
+    Vector eye_vector;
+    Vector normal_vector;
+    int slot;
+    double weight;
+
+    ShadowRay(const Ray& r, double d, const Light* l, const IntersectionComputation& ic,
+        const Point& p, int s, double w): ray { r }, distance { d }, light { l },
+        object { ic.Object() }, point { p }, eye_vector { ic.EyeVector() },
+        normal_vector { ic.NormalVector() }, slot { s }, weight { w } {}
+};
+
+// The queues of rays for World::ColourAt(Wavefront&, ...), which finds the
+// colours of a batch of rays a stage at a time instead of recursively: all
+// the queued rays of a stage are traced in packets, then shading their hits
+// queues the shadow rays, which are traced next, and the reflected and
+// refracted rays, which are traced in the following stages. The queues keep
+// their storage, so reusing a wavefront for each batch avoids allocating.
+struct Wavefront {
+    std::vector<WavefrontRay> primary;
+    std::vector<WavefrontRay> reflected;
+    std::vector<WavefrontRay> refracted;
+    std::vector<ShadowRay> shadow;
+    // the rays of the stage being traced, moved from one of the queues above
+    std::vector<WavefrontRay> tracing;
+    // Whether reflected and refracted rays are sorted (see Sort()) before
+    // they are traced
+    bool sort_secondary;
+
+    // storage for Sort()
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> keys;
+    std::vector<WavefrontRay> sorted;
+
+    Wavefront(bool sort = true): primary {}, reflected {}, refracted {}, shadow {},
+        tracing {}, sort_secondary { sort }, keys {}, sorted {} {}
+
+    // Reorders the rays so that rays starting near each other and heading
+    // the same way are next to each other, and so tend to visit the same
+    // parts of the scene one after another: rays are sorted by the octant
+    // of their direction, then by the Morton code of their origin quantised
+    // to a grid over the rays' origins
+    void Sort(std::vector<WavefrontRay>& rays);
+
+    // The key Sort() orders a ray by, for origins quantised over the given
+    // bounds
+    static std::uint64_t MortonKey(const Ray& ray, const double* min, const double* max);
+};
+
+#endif
\ No newline at end of file
@@ -2,22 +2,41 @@
 #define RAY_TRACER_WORLD_H
 
 #include <set>
+#include <iostream>
 #include <cmath> // for sqrt
 #include "shape.h"
 #include "ray.h"
+#include "ray-packet.h"
 #include "material.h"
 #include "colour.h"
 #include "space.h"
 #include "utils.h"
+#include "accelerator.h"
+#include "wavefront.h"
 
 class World {
     std::set<const Shape*> objects_;
     std::set<const Light*> lights_;
+    const Accelerator* accelerator_;
+    int max_depth_;
+    double min_contribution_;
     bool InShadow(const Point& point, const Light* light) const;
+    void Intersect(IntersectionList& xs, const Ray& ray) const;
+    // Finds the colour for a ray travelling through the given medium, or
+    // through the medium found from its intersections if nullptr, whose
+    // colour will be scaled by weight in the final image
+    const Colour ColourAt(const Ray& ray, const int max_depth,
+        const MediumStack* medium, double weight, const Shape** object = nullptr) const;
+    // The stages of ColourAt(Wavefront&, ...)
+    void TraceStage(Wavefront& wavefront, Colour* colours) const;
+    void TraceShadows(Wavefront& wavefront, Colour* colours) const;
+    void Shade(const IntersectionComputation& ic, const WavefrontRay& ray,
+        Wavefront& wavefront, Colour* colours) const;
 
     public:
         static const int kMaxReflections;
-        World(): objects_ {}, lights_ {} {}
+        World(): objects_ {}, lights_ {}, accelerator_ { nullptr },
+            max_depth_ { kMaxReflections }, min_contribution_ { 0 } {}
         void Add(const Shape* object);
         void Add(const Light* light);
         std::size_t Remove(const Shape* object);
@@ -26,17 +45,43 @@ class World {
         bool Contains(const Shape* object) const;
         bool Contains(const Light* light) const;
         IntersectionList Intersect(const Ray& ray) const;
+        void Intersect(IntersectionList* lists, const RayPacket& packet) const;
+        void SetAccelerator(Accelerator* accelerator);
         std::size_t NObjects() const { return objects_.size(); }
         std::size_t NLights() const { return lights_.size(); }
+        // The most reflected or refracted rays followed from a primary ray
+        // by a camera rendering the world
+        int MaxDepth() const { return max_depth_; }
+        void SetMaxDepth(int max_depth) { max_depth_ = max_depth; }
+        // Reflected and refracted rays that would contribute less than this
+        // fraction of their colour to the image (the product of the
+        // reflectivity, transparency and Fresnel terms along their path) are
+        // not traced; 0, the default, traces them all
+        double MinContribution() const { return min_contribution_; }
+        void SetMinContribution(double min_contribution) { min_contribution_ = min_contribution; }
+        // Prints the number of shapes of each type in the world (including
+        // the children of groups) and the bytes they use, and the size of
+        // the shared material table
+        void MemoryReport(std::ostream& os) const;
+        // weight is the fraction of the colour that reaches the image
         const Colour ColourAt(const IntersectionComputation& ic,
-            const int max_depth = World::kMaxReflections) const;
+            const int max_depth = World::kMaxReflections, double weight = 1.0) const;
         const Colour ColourAt(const Ray& ray,
             const int max_depth = World::kMaxReflections) const;
+        // Also sets object to the object the ray hits, or nullptr
+        const Colour ColourAt(const Ray& ray, const int max_depth, const Shape** object) const;
+        void ColourAt(const RayPacket& packet, Colour* colours,
+            const int max_depth = World::kMaxReflections) const;
+        // Adds the colour of each ray queued in the wavefront's primary stage
+        // to colours[ray.slot], tracing the rays a stage at a time rather
+        // than recursively (see Wavefront); the results are the same as
+        // ColourAt() for each ray, up to rounding
+        void ColourAt(Wavefront& wavefront, Colour* colours) const;
         bool InShadow(const Point& point) const;
         const Colour ReflectedColour(const IntersectionComputation& ic,
-            const int max_depth = World::kMaxReflections) const;
+            const int max_depth = World::kMaxReflections, double weight = 1.0) const;
         const Colour RefractedColour(const IntersectionComputation& ic,
-            const int max_depth = World::kMaxReflections) const;
+            const int max_depth = World::kMaxReflections, double weight = 1.0) const;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,101 @@
+#ifndef RAY_TRACER_YAML_H
+#define RAY_TRACER_YAML_H
+
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A value read from a YAML document: a scalar, kept as text, a sequence or a
+// mapping, whose entries keep the order they were written in
+struct YamlNode {
+    enum class Kind { kNull, kScalar, kSequence, kMapping };
+
+    Kind kind;
+    std::string text;
+    std::vector<YamlNode> items;
+    std::vector<std::pair<std::string, YamlNode>> entries;
+    // where the value starts in the document, for error messages
+    int line;
+
+    YamlNode(Kind k = Kind::kNull, int l = 0): kind { k }, text {}, items {}, entries {},
+        line { l } {}
+
+    bool IsScalar() const { return kind == Kind::kScalar; }
+    bool IsSequence() const { return kind == Kind::kSequence; }
+    bool IsMapping() const { return kind == Kind::kMapping; }
+
+    // The value of the last entry with the key, or nullptr if there is none
+    // or this isn't a mapping
+    const YamlNode* Find(const std::string& key) const;
+
+    // The scalar as a number or a boolean (true, false, yes or no); throws
+    // std::invalid_argument if it isn't one
+    double Number() const;
+    bool Boolean() const;
+
+    // Throws std::invalid_argument with the message and the line of the value
+    [[noreturn]] void Fail(const std::string& message) const;
+};
+
+// Reads the subset of YAML used by scene files: block sequences and
+// mappings, flow sequences ([a, b]) and mappings ({a: b}), which may span
+// lines, plain and quoted scalars, and comments. Anchors, tags, multi-line
+// scalars and multiple documents aren't supported. A JSON document is also
+// a flow value, so JSON files can be read too.
+//
+// A document whose top level is a sequence can be streamed, reading one item
+// at a time, so that a scene can be built as it is read without holding the
+// whole document:
+//
+//     YamlReader reader { file };
+//     YamlNode item {};
+//     while (reader.Next(item)) { ... }
+//
+// Malformed documents throw std::invalid_argument, naming the line.
+class YamlReader {
+    enum class State { kStart, kBlock, kFlow, kDone };
+
+    std::istream& is_;
+    // the current line, without its comment, and the position reached in
+    // it; position_ is also the column of a block value starting there
+    std::string line_;
+    std::size_t position_;
+    int number_;
+    bool has_line_;
+    State state_;
+    std::size_t column_; // of the top-level block sequence
+
+    bool NextLine();
+    bool AtEnd() const { return position_ >= line_.size(); }
+    char Current() const { return line_[position_]; }
+    bool AtDash() const;
+    bool AtKey() const;
+    void SkipSpaces();
+    void SkipFlowSpace();
+    [[noreturn]] void Fail(const std::string& message) const;
+
+    YamlNode ParseBlock();
+    YamlNode ParseBlockSequence();
+    YamlNode ParseBlockMapping();
+    YamlNode ParseSequenceItem(std::size_t column);
+    YamlNode ParseInline();
+    YamlNode ParseFlow();
+    YamlNode ParseQuoted();
+    YamlNode ParsePlain(bool flow);
+    void ExpectLineEnd();
+
+    public:
+        YamlReader(std::istream& is): is_ { is }, line_ {}, position_ { 0 }, number_ { 0 },
+            has_line_ { false }, state_ { State::kStart }, column_ { 0 } {}
+        YamlReader(const YamlReader&) = delete;
+        YamlReader& operator=(const YamlReader&) = delete;
+
+        // Reads the next item of a document that is a sequence; returns
+        // false after the last one
+        bool Next(YamlNode& item);
+        // Reads the whole document, which may be any kind of value
+        YamlNode Document();
+};
+
+#endif
\ No newline at end of file
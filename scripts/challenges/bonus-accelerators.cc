@@ -0,0 +1,188 @@
+/*
+Bonus: compare the acceleration structures
+
+Render a few scenes without acceleration, with a bounding volume hierarchy
+(ShapeGroup::Divide()), with a uniform grid and with an octree, and print the
+time each render took as a table.
+
+The scenes are the sphere lattice from bonus-bvh.cc, the spheres from the
+Chapter 7 scene, and a cluster of randomly placed spheres of varying sizes,
+which is less uniform than the lattice.
+
+Supply a scaling factor at the command line to increase the image dimensions.
+Configure with -DRAY_TRACER_COUNT_ALLOCATIONS=ON to also print the heap
+allocations per pixel of each render.
+*/
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "challenges.h"
+#include "chapter-07-scene.h"
+#include "sphere.h"
+#include "group.h"
+#include "grid.h"
+#include "octree.h"
+#include "allocations.h"
+
+static const int kBVHThreshold { 50 };
+
+struct BenchmarkScene {
+    std::string name;
+    std::vector<Shape*> shapes;
+    Point light_position;
+    Matrix view_transform;
+    double fov;
+
+    BenchmarkScene(const std::string& n, const Point& p, const Matrix& v, double f):
+        name { n }, shapes {}, light_position { p }, view_transform { v }, fov { f } {}
+
+    ~BenchmarkScene() {
+        for (auto s: shapes) {
+            delete s;
+        }
+    }
+};
+
+void Lattice(BenchmarkScene& scene, int dim) {
+    std::vector<Colour> colours = {
+        Colour { 1, 0, 0 },
+        Colour { 0, 1, 0 },
+        Colour { 0, 0, 1 }
+    };
+    for (int y = 0; y < dim; y++) {
+        for (int z = 0; z < dim; z++) {
+            for (int x = 0; x < dim; x++) {
+                Sphere* s = new Sphere();
+                s->SetTransform(Transformation().Translate(2*x, 2*y, 2*z));
+                s->SetMaterial(Material().Surface(colours[(x + y + z) % colours.size()]));
+                scene.shapes.push_back(s);
+            }
+        }
+    }
+}
+
+Sphere* CopySphere(const Sphere& original) {
+    // Sphere's copy constructor doesn't copy the transform or material
+    Sphere* s = new Sphere();
+    s->SetTransform(original.Transform());
+    s->SetMaterial(original.ShapeMaterial());
+    return s;
+}
+
+void Chapter7Spheres(BenchmarkScene& scene) {
+    scene.shapes.push_back(CopySphere(LargeSphere(1)));
+    scene.shapes.push_back(CopySphere(SmallerSphere(1)));
+    scene.shapes.push_back(CopySphere(SmallestSphere(1)));
+    Sphere* floor = new Sphere();
+    floor->SetTransform(Transformation().Scale(10, 0.01, 10));
+    floor->SetMaterial(FloorMaterial());
+    scene.shapes.push_back(floor);
+}
+
+void RandomCluster(BenchmarkScene& scene, int n) {
+    // a fixed seed keeps the scene the same from run to run
+    std::mt19937 generator { 12345 };
+    std::normal_distribution<double> position { 0, 10 };
+    std::uniform_real_distribution<double> radius { 0.2, 2 };
+    for (int i = 0; i < n; i++) {
+        Sphere* s = new Sphere();
+        s->SetTransform(
+            Transformation()
+            .Scale(radius(generator))
+            .Translate(position(generator), position(generator), position(generator))
+        );
+        scene.shapes.push_back(s);
+    }
+}
+
+void TimeRender(const World& world, const Camera& camera) {
+    // prints the time taken, and the heap allocations per pixel when they
+    // are counted
+    unsigned long long allocations = AllocationCounter::TotalCount();
+    auto start = std::chrono::steady_clock::now();
+    camera.Render(world);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << '\t' << elapsed.count();
+    if (AllocationCounter::Enabled()) {
+        int pixels = camera.Horizontal() * camera.Vertical();
+        std::cout << '\t' << static_cast<double>(AllocationCounter::TotalCount() - allocations) / pixels;
+    }
+}
+
+void Benchmark(BenchmarkScene& scene, double scale) {
+    Camera camera = SceneCamera(scale, 100, 50, scene.fov, scene.view_transform);
+    Light light { scene.light_position, Colour { 1, 1, 1 } };
+
+    World world {};
+    world.Add(&light);
+    for (auto s: scene.shapes) {
+        world.Add(s);
+    }
+
+    std::cout << scene.name << '\t' << scene.shapes.size();
+    TimeRender(world, camera);
+
+    UniformGrid grid {};
+    world.SetAccelerator(&grid);
+    TimeRender(world, camera);
+
+    Octree octree {};
+    world.SetAccelerator(&octree);
+    TimeRender(world, camera);
+    world.SetAccelerator(nullptr);
+
+    // the hierarchy goes last, since adding the shapes to it changes their
+    // parent; World::ClearObjects() would delete the scene's shapes, so
+    // remove them instead
+    for (auto s: scene.shapes) {
+        world.Remove(s);
+    }
+    ShapeGroup bvh {};
+    for (auto s: scene.shapes) {
+        bvh.Add(s);
+    }
+    bvh.Divide(kBVHThreshold);
+    world.Add(&bvh);
+    TimeRender(world, camera);
+    std::cout << std::endl;
+}
+
+int main(int argc, char** argv) {
+    double scale = GetScale(argc, argv);
+
+    std::cout << "scene\tshapes";
+    for (auto name: { "none", "grid", "octree", "bvh" }) {
+        std::cout << '\t' << name << " (s)";
+        if (AllocationCounter::Enabled()) {
+            std::cout << '\t' << name << " (allocations/pixel)";
+        }
+    }
+    std::cout << std::endl;
+
+    BenchmarkScene lattice {
+        "lattice", Point { 50, 50, -50 },
+        ViewTransform { Point { 60, 55, -75 }, Point { 20, 15, 0 }, Vector { 0, 1, 0 } },
+        M_PI / 3
+    };
+    Lattice(lattice, 10);
+    Benchmark(lattice, scale);
+
+    BenchmarkScene chapter_7 {
+        "chapter-07", Point { -10, 10, -10 }, CameraTransform(1), M_PI / 3
+    };
+    Chapter7Spheres(chapter_7);
+    Benchmark(chapter_7, scale);
+
+    BenchmarkScene cluster {
+        "cluster", Point { -50, 50, -50 },
+        ViewTransform { Point { 0, 0, -60 }, Point { 0, 0, 0 }, Vector { 0, 1, 0 } },
+        M_PI / 3
+    };
+    RandomCluster(cluster, 1000);
+    Benchmark(cluster, scale);
+
+    return 0;
+}
\ No newline at end of file
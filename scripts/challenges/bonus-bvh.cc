@@ -7,6 +7,18 @@ Render a scene containing a lot of objects, to confirm that a bounding volume
 hierarchy (BVH) facilitates rendering in a reasonable amount of time.
 
 Supply a scaling factor at the command line to increase the image dimensions.
+Add --stats to print statistics for the hierarchy and its traversal to stderr,
+and the memory used by each type of shape (and, if configured with
+-DRAY_TRACER_COUNT_ALLOCATIONS=ON, the heap allocations per pixel).
+Add --bvh-cache=<file> to save the hierarchy to the file, or to reuse the
+hierarchy saved there by a previous run of the same scene.
+Add --lazy-bvh to divide each part of the hierarchy only when a ray first enters
+it; with --stats, the number of groups left undivided is reported afterwards.
+Add --packets=<n> to trace the primary rays in packets of n (4, 8 or 16) rays
+on a single thread, instead of one ray per thread, or --wavefront to trace the
+rays a stage at a time (see Camera::RenderWavefront()), with --unsorted as well
+to leave the reflected rays unsorted.
+Add --reflective to make the spheres reflect each other.
 */
 
 #include <vector>
@@ -15,6 +27,8 @@ Supply a scaling factor at the command line to increase the image dimensions.
 #include "sphere.h"
 #include "group.h"
 #include "plane.h"
+#include "scene.h"
+#include "allocations.h"
 
 Light WorldLight(double scale) {
     Point origin { 50*scale, 50 * scale, -50*scale };
@@ -30,7 +44,15 @@ Matrix CameraTransform(double scale) {
 
 int main(int argc, char** argv) {
     double scale = GetScale(argc, argv);
-
+    bool stats = HasOption(argc, argv, "--stats");
+    std::string bvh_cache = GetOption(argc, argv, "--bvh-cache");
+    bool lazy_bvh = HasOption(argc, argv, "--lazy-bvh");
+    std::string packets = GetOption(argc, argv, "--packets");
+    bool wavefront = HasOption(argc, argv, "--wavefront");
+    bool reflective = HasOption(argc, argv, "--reflective");
+
+    // owns the spheres, laid out in the order they are made
+    Scene scene {};
     World world {};
 
     Light light = WorldLight(scale);
@@ -48,13 +70,11 @@ int main(int argc, char** argv) {
     ShapeGroup shapes {};
     world.Add(&shapes);
 
-    std::vector<Shape*> objects {};
     int dim { 20 };
     for (int y = 0; y < dim; y++) {
         for (int z = 0; z < dim; z++) {
             for (int x = 0; x < dim; x++) {
-                Sphere* s = new Sphere();
-                objects.push_back(s);
+                Sphere* s = scene.Make<Sphere>();
                 shapes << s;
                 s->SetTransform(
                     Transformation()
@@ -63,22 +83,53 @@ int main(int argc, char** argv) {
                 );
                 Material m {};
                 m.Surface(colours[(x + y + z) % colours.size()]);
+                if (reflective) {
+                    m.Reflectivity(0.5);
+                }
                 s->SetMaterial(m);
             }
         }
     }
 
-    shapes.Divide(50);
+    if (lazy_bvh) {
+        shapes.DivideLazily(50);
+    }
+    else if (bvh_cache.empty()) {
+        shapes.Divide(50);
+    }
+    else {
+        shapes.Divide(50, bvh_cache);
+    }
+
+    if (stats) {
+        std::cerr << shapes.Statistics();
+        world.MemoryReport(std::cerr);
+        std::cerr << "scene arena\t" << scene.NObjects() << '\t' << scene.PeakMemory()
+            << std::endl;
+        TraversalStatistics::Enable();
+    }
 
     Camera camera = SceneCamera(scale, 108, 135, M_PI / 3, CameraTransform(scale));
-    Canvas canvas = camera.RenderConcurrent(world);
+    unsigned long long allocations = AllocationCounter::TotalCount();
+    Canvas canvas = wavefront ?
+            camera.RenderWavefront(world, !HasOption(argc, argv, "--unsorted"))
+        : packets.empty() ? camera.RenderConcurrent(world)
+        : camera.RenderPackets(world, std::stoi(packets));
+
+    if (stats) {
+        TraversalStatistics::Report(std::cerr);
+        if (AllocationCounter::Enabled()) {
+            std::cerr << "heap allocations per pixel: "
+                << static_cast<double>(AllocationCounter::TotalCount() - allocations) /
+                    (camera.Horizontal() * camera.Vertical()) << std::endl;
+        }
+        if (lazy_bvh) {
+            std::cerr << shapes.Statistics();
+        }
+    }
     PPMv3 ppm { canvas };
     std::cout << ppm;
 
-    for (auto o: objects) {
-        delete o;
-    }
-
     return 0;
 }
 
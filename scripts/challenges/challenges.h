@@ -3,8 +3,14 @@
 
 #define _USE_MATH_DEFINES // for M_PI
 
+#include <algorithm> // for min, max, max_element
 #include <cmath>
+#include <cstring> // for strcmp
 #include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "matrix.h"
 #include "transformations.h"
@@ -13,14 +19,19 @@
 #include "world.h"
 #include "camera.h"
 #include "canvas.h"
+#include "sampler.h"
 
 static double kMaxScale { 20.0 };
 
 double GetScale(int argc, char** argv) {
     double scale { 1.0 };
 
-    if (argc > 1) {
-        scale = atof(argv[1]);
+    // the scale is the first argument that isn't an option
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--", 2) != 0) {
+            scale = atof(argv[i]);
+            break;
+        }
     }
 
     if (scale <= 0 || scale > kMaxScale) {
@@ -30,6 +41,69 @@ double GetScale(int argc, char** argv) {
     return scale;
 }
 
+bool HasOption(int argc, char** argv, const char* option) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], option) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Returns the value of an option given as --name=value, or an empty string
+std::string GetOption(int argc, char** argv, const char* option) {
+    std::size_t length = strlen(option);
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], option, length) == 0 && argv[i][length] == '=') {
+            return std::string { argv[i] + length + 1 };
+        }
+    }
+    return std::string {};
+}
+
+// Applies the options that limit how far reflected and refracted rays are
+// followed: --max-depth=<n> and --min-contribution=<fraction> (see World)
+void SetTracingOptions(int argc, char** argv, World& world) {
+    std::string depth = GetOption(argc, argv, "--max-depth"),
+                contribution = GetOption(argc, argv, "--min-contribution");
+    if (!depth.empty()) {
+        world.SetMaxDepth(std::stoi(depth));
+    }
+    if (!contribution.empty()) {
+        world.SetMinContribution(std::stod(contribution));
+    }
+}
+
+// The sampler for the options --samples=<n> (by default, the given number),
+// --pattern=<name> (random, stratified, halton or sobol) and --filter=<name>
+// (box, tent or mitchell); see PixelSampler
+PixelSampler GetSampler(int argc, char** argv, int default_samples = 1) {
+    std::string samples = GetOption(argc, argv, "--samples"),
+                pattern = GetOption(argc, argv, "--pattern"),
+                filter = GetOption(argc, argv, "--filter");
+    try {
+        return PixelSampler {
+            samples.empty() ? default_samples : std::stoi(samples),
+            pattern.empty() ? SamplePattern::kSobol : PixelSampler::ParsePattern(pattern),
+            filter.empty() ? PixelFilter::kBox : PixelSampler::ParseFilter(filter)
+        };
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Invalid sampling options: " << e.what() << std::endl;
+        exit(-1);
+    }
+}
+
+// The number of threads to render with, from --threads=<n> or else the
+// number the hardware supports
+int GetThreads(int argc, char** argv) {
+    std::string threads = GetOption(argc, argv, "--threads");
+    if (!threads.empty()) {
+        return std::stoi(threads);
+    }
+    return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
 Camera SceneCamera(double scale, int width, int height, double fov,
         const Matrix& view_transform) {
     int scale_int = static_cast<int>(scale);
@@ -38,6 +112,44 @@ Camera SceneCamera(double scale, int width, int height, double fov,
     return camera;
 }
 
+// Prints a summary of the rays traced for each pixel (see
+// Camera::RenderAdaptive())
+void ReportSamples(const std::vector<int>& samples, std::ostream& os) {
+    std::vector<int> histogram {};
+    long total { 0 };
+    for (int n: samples) {
+        if (n >= static_cast<int>(histogram.size())) {
+            histogram.resize(n + 1, 0);
+        }
+        histogram[n]++;
+        total += n;
+    }
+    os << "rays per pixel: " << static_cast<double>(total) / samples.size() << std::endl;
+    os << "rays\tpixels" << std::endl;
+    for (std::size_t n = 0; n < histogram.size(); n++) {
+        if (histogram[n] > 0) {
+            os << n << '\t' << histogram[n] << std::endl;
+        }
+    }
+}
+
+// An image of the number of samples taken for each pixel, in rows of the
+// given width, from black for none through red and yellow to white for the
+// most taken for any pixel
+Canvas SampleHeatmap(const std::vector<int>& samples, int width) {
+    int height = samples.size() / width,
+        most = std::max(1, *std::max_element(samples.begin(), samples.end()));
+    Canvas heatmap { width, height };
+    for (int pixel = 0; pixel < width * height; pixel++) {
+        double heat = 3.0 * samples[pixel] / most;
+        heatmap[pixel / width][pixel % width] = Colour {
+            std::min(1.0, heat), std::max(0.0, std::min(1.0, heat - 1)),
+            std::max(0.0, std::min(1.0, heat - 2))
+        };
+    }
+    return heatmap;
+}
+
 Material GlassMaterial(const Colour& colour) {
     return Material()
         .Transparency(1.0)
@@ -4,13 +4,51 @@ The Ray Tracer Challenge: Chapter 7 (and Chapter 8)
 Render the scene described on pp. 105–107.
 
 Supply a scaling factor at the command line to increase the image dimensions.
+Add --packets=<n> to trace the primary rays in packets of n (4, 8 or 16) rays.
+Add --wavefront to trace the rays a stage at a time (see Camera::RenderWavefront()).
+Add --adaptive=<n> to antialias edges with up to n rays per pixel (see
+Camera::RenderAdaptive()); with --stats, the rays per pixel are reported,
+and --heatmap=<file> writes an image of the rays per pixel.
+Add --samples=<n> to trace n rays per pixel, placed by --pattern=<name>
+(random, stratified, halton or sobol) and weighted by --filter=<name> (box,
+tent or mitchell), with --threads=<n> threads (see Camera::RenderMultisample()).
+Add --converge=<threshold> to sample each tile of pixels until the mean
+brightness of its pixels is known to within the threshold, with up to
+--samples=<n> (by default 64) rays per pixel and for up to --time-budget=<s>
+seconds (see Camera::RenderConverged()); --stats and --heatmap are as for
+--adaptive. With --checkpoint=<file>, the progress is saved to the file every
+--checkpoint-interval=<s> seconds (by default 10) and when rendering stops,
+and a later run with the same file carries on from it.
+Add --workers=<n> to render tiles of the image in n processes forked from
+this one (see RenderWithWorkers()). With --coordinate=<socket>, the image is
+instead rendered by the first --workers=<n> (by default 1) processes to run
+with --work-for=<socket> and the same scaling factor, which connect to a Unix
+domain socket at that path; workers write no image.
+Add --sampling-stats to print the error of each pattern at a few numbers of
+samples per pixel to stderr.
+Add --shading-stats to print the time taken to shade each hit to stderr.
 */
 
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "challenges.h"
 #include "chapter-07-scene.h"
+#include "shading-benchmark.h"
+#include "sampling-benchmark.h"
 #include "camera.h"
+#include "checkpoint.h"
+#include "distributed.h"
 #include "world.h"
 
+// The most rays per pixel for --converge, unless --samples is given
+static const int kConvergeSamples { 64 };
+// The seconds between checkpoints, unless --checkpoint-interval is given
+static const double kCheckpointInterval { 10 };
+
 Sphere Floor(const Material& material, double scale) {
     Sphere floor {};
     Matrix transform = Transformation().Scale(10 * scale, 0.01, 10 * scale);
@@ -44,16 +82,8 @@ Sphere RightWall(const Material& material, double scale) {
 }
 
 int main(int argc, char** argv) {
-    double scale { 1 }, max_scale { 20 };
-
-    if (argc > 1) {
-        scale = atof(argv[1]);
-    }
-
-    if (scale <= 0 || scale > max_scale) {
-        std::cerr << "Given scale invalid (1-" << max_scale << ")" << std::endl;
-        return 1;
-    }
+    double scale = GetScale(argc, argv);
+    std::string packets = GetOption(argc, argv, "--packets");
 
     int scale_int = static_cast<int>(scale);
 
@@ -79,7 +109,56 @@ int main(int argc, char** argv) {
     Camera camera { 100 * scale_int, 50 * scale_int, M_PI / 3 };
     camera.SetTransform(CameraTransform(scale));
 
-    Canvas canvas = camera.Render(world);
+    if (HasOption(argc, argv, "--shading-stats")) {
+        ShadingBenchmark(world, camera, std::cerr);
+    }
+    if (HasOption(argc, argv, "--sampling-stats")) {
+        SamplingBenchmark(world, camera, GetSampler(argc, argv).Filter(),
+            GetThreads(argc, argv), std::cerr);
+    }
+
+    std::string work_for = GetOption(argc, argv, "--work-for");
+    if (!work_for.empty()) {
+        int coordinator = ConnectTo(work_for);
+        RunWorker(coordinator, world, camera);
+        close(coordinator);
+        return 0;
+    }
+
+    std::string adaptive = GetOption(argc, argv, "--adaptive");
+    std::vector<int> samples {};
+    std::string converge = GetOption(argc, argv, "--converge"),
+                budget = GetOption(argc, argv, "--time-budget");
+    PixelSampler sampler = GetSampler(argc, argv, converge.empty() ? 1 : kConvergeSamples);
+    std::string checkpoint = GetOption(argc, argv, "--checkpoint"),
+                interval = GetOption(argc, argv, "--checkpoint-interval");
+    std::unique_ptr<CheckpointWriter> checkpoints {};
+    if (!checkpoint.empty()) {
+        checkpoints.reset(new CheckpointWriter { checkpoint,
+            interval.empty() ? kCheckpointInterval : std::stod(interval) });
+    }
+    bool multisample = !GetOption(argc, argv, "--samples").empty();
+    std::string workers = GetOption(argc, argv, "--workers"),
+                coordinate = GetOption(argc, argv, "--coordinate");
+    Canvas canvas = !coordinate.empty() ? CoordinateWorkers(AcceptWorkers(coordinate,
+            workers.empty() ? 1 : std::stoi(workers)), camera.Horizontal(), camera.Vertical())
+        : !workers.empty() ? RenderWithWorkers(world, camera, std::stoi(workers))
+        : !converge.empty() ? camera.RenderConverged(world, sampler,
+            std::stod(converge), budget.empty() ? 0 : std::stod(budget),
+            GetThreads(argc, argv), &samples, checkpoints.get())
+        : multisample ? camera.RenderMultisample(world, sampler, GetThreads(argc, argv))
+        : !adaptive.empty() ? camera.RenderAdaptive(world, std::stoi(adaptive), &samples)
+        : HasOption(argc, argv, "--wavefront") ? camera.RenderWavefront(world)
+        : packets.empty() ? camera.Render(world)
+        : camera.RenderPackets(world, std::stoi(packets));
+    if (!samples.empty() && HasOption(argc, argv, "--stats")) {
+        ReportSamples(samples, std::cerr);
+    }
+    std::string heatmap = GetOption(argc, argv, "--heatmap");
+    if (!samples.empty() && !heatmap.empty()) {
+        std::ofstream file { heatmap };
+        file << PPMv3 { SampleHeatmap(samples, camera.Horizontal()) };
+    }
     PPMv3 ppm { canvas };
     std::cout << ppm;
 
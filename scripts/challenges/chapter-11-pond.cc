@@ -5,12 +5,20 @@ Render a scene that observes the surface of a pond from above, looking down
 at the rocks beneath (p. 165).
 
 Supply a scaling factor at the command line to increase the image dimensions.
+Add --max-depth=<n> to follow at most n reflected or refracted rays from each
+primary ray, and --min-contribution=<fraction> to skip those that would add
+less than that fraction of their colour to the image. Add --stats to print
+the number of rays traced and skipped to stderr.
+Add --wavefront to trace the rays a stage at a time (see Camera::RenderWavefront()),
+and --unsorted as well to leave the reflected and refracted rays unsorted.
+Add --shading-stats to print the time taken to shade each hit to stderr.
 */
 
 #include "challenges.h"
 #include "plane.h"
 #include "sphere.h"
 #include "pattern.h"
+#include "shading-benchmark.h"
 
 Light WorldLight(double scale) {
     double scaled = 10 * scale;
@@ -128,6 +136,7 @@ int main(int argc, char** argv) {
     double scale = GetScale(argc, argv);
 
     World world {};
+    SetTracingOptions(argc, argv, world);
 
     Light light = WorldLight(scale);
     world.Add(&light);
@@ -161,7 +170,20 @@ int main(int argc, char** argv) {
     world.Add(&marble);
 
     Camera camera = SceneCamera(scale, 108, 135, M_PI / 3, CameraTransform(scale));
-    Canvas canvas = camera.Render(world);
+    if (HasOption(argc, argv, "--shading-stats")) {
+        ShadingBenchmark(world, camera, std::cerr);
+    }
+
+    bool stats = HasOption(argc, argv, "--stats");
+    if (stats) {
+        TraversalStatistics::Enable();
+    }
+    bool wavefront = HasOption(argc, argv, "--wavefront"),
+         sorted = !HasOption(argc, argv, "--unsorted");
+    Canvas canvas = wavefront ? camera.RenderWavefront(world, sorted) : camera.Render(world);
+    if (stats) {
+        TraversalStatistics::Report(std::cerr);
+    }
     PPMv3 ppm { canvas };
     std::cout << ppm;
 
@@ -4,6 +4,12 @@ The Ray Tracer Challenge: Chapter 11
 Render a scene demonstrating reflections (p. 149).
 
 Supply a scaling factor at the command line to increase the image dimensions.
+Add --max-depth=<n> to follow at most n reflected or refracted rays from each
+primary ray, and --min-contribution=<fraction> to skip those that would add
+less than that fraction of their colour to the image. Add --stats to print
+the number of rays traced and skipped to stderr.
+Add --wavefront to trace the rays a stage at a time (see Camera::RenderWavefront()),
+and --unsorted as well to leave the reflected and refracted rays unsorted.
 */
 
 #include "challenges.h"
@@ -92,6 +98,7 @@ int main(int argc, char** argv) {
     double scale = GetScale(argc, argv);
 
     World world {};
+    SetTracingOptions(argc, argv, world);
 
     Light light = WorldLight(scale);
     world.Add(&light);
@@ -112,7 +119,16 @@ int main(int argc, char** argv) {
     world.Add(&smaller_sphere);
 
     Camera camera = SceneCamera(scale, 108, 135, M_PI / 3, CameraTransform(scale));
-    Canvas canvas = camera.Render(world);
+    bool stats = HasOption(argc, argv, "--stats");
+    if (stats) {
+        TraversalStatistics::Enable();
+    }
+    bool wavefront = HasOption(argc, argv, "--wavefront"),
+         sorted = !HasOption(argc, argv, "--unsorted");
+    Canvas canvas = wavefront ? camera.RenderWavefront(world, sorted) : camera.Render(world);
+    if (stats) {
+        TraversalStatistics::Report(std::cerr);
+    }
     PPMv3 ppm { canvas };
     std::cout << ppm;
 
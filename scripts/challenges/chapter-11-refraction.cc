@@ -4,6 +4,12 @@ The Ray Tracer Challenge: Chapter 11
 Render a glass sphere containing an air bubble, like the one described on p. 159
 
 Supply a scaling factor at the command line to increase the image dimensions.
+Add --max-depth=<n> to follow at most n reflected or refracted rays from each
+primary ray, and --min-contribution=<fraction> to skip those that would add
+less than that fraction of their colour to the image. Add --stats to print
+the number of rays traced and skipped to stderr.
+Add --wavefront to trace the rays a stage at a time (see Camera::RenderWavefront()),
+and --unsorted as well to leave the reflected and refracted rays unsorted.
 */
 
 #include "challenges.h"
@@ -73,6 +79,7 @@ int main(int argc, char** argv) {
     int scale_int = static_cast<int>(scale);
 
     World world {};
+    SetTracingOptions(argc, argv, world);
 
     Light light = WorldLight(scale);
     world.Add(&light);
@@ -93,7 +100,16 @@ int main(int argc, char** argv) {
     world.Add(&bubble);
 
     Camera camera = SceneCamera(scale, 108, 135, M_PI / 3, CameraTransform(scale));
-    Canvas canvas = camera.Render(world);
+    bool stats = HasOption(argc, argv, "--stats");
+    if (stats) {
+        TraversalStatistics::Enable();
+    }
+    bool wavefront = HasOption(argc, argv, "--wavefront"),
+         sorted = !HasOption(argc, argv, "--unsorted");
+    Canvas canvas = wavefront ? camera.RenderWavefront(world, sorted) : camera.Render(world);
+    if (stats) {
+        TraversalStatistics::Report(std::cerr);
+    }
     PPMv3 ppm { canvas };
     std::cout << ppm;
 
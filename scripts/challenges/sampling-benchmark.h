@@ -0,0 +1,54 @@
+#ifndef RAY_TRACER_SAMPLING_BENCHMARK_H
+#define RAY_TRACER_SAMPLING_BENCHMARK_H
+
+#include <cmath>
+#include <iostream>
+
+#include "camera.h"
+#include "canvas.h"
+#include "sampler.h"
+#include "world.h"
+
+// The samples per pixel of the reference image the others are compared with
+static const int kReferenceSamples { 256 };
+
+// The root mean square difference between the components of two images
+double RMSError(const Canvas& image, const Canvas& reference) {
+    double sum { 0 };
+    for (int row = 0; row < image.Height(); row++) {
+        for (int column = 0; column < image.Width(); column++) {
+            Colour a = image.At(row, column), b = reference.At(row, column);
+            for (int i = Colour::kRed; i <= Colour::kBlue; i++) {
+                sum += (a.At(i) - b.At(i)) * (a.At(i) - b.At(i));
+            }
+        }
+    }
+    return std::sqrt(sum / (3.0 * image.Width() * image.Height()));
+}
+
+// Renders the scene with each sample pattern at a few numbers of samples per
+// pixel, and prints how far each image is from a reference rendered with
+// many more samples; the lower the error for a number of samples, the fewer
+// samples the pattern needs for a given level of noise
+void SamplingBenchmark(const World& world, const Camera& camera, PixelFilter filter,
+        int threads, std::ostream& os) {
+    Canvas reference = camera.RenderMultisample(world,
+        PixelSampler { kReferenceSamples, SamplePattern::kSobol, filter, 1 }, threads);
+    const char* names[] = { "random", "stratified", "halton", "sobol" };
+    os << "RMS error against " << kReferenceSamples << " samples per pixel" << std::endl;
+    os << "samples";
+    for (auto name: names) {
+        os << '\t' << name;
+    }
+    os << std::endl;
+    for (int samples: { 4, 16, 64 }) {
+        os << samples;
+        for (auto name: names) {
+            PixelSampler sampler { samples, PixelSampler::ParsePattern(name), filter };
+            os << '\t' << RMSError(camera.RenderMultisample(world, sampler, threads), reference);
+        }
+        os << std::endl;
+    }
+}
+
+#endif
\ No newline at end of file
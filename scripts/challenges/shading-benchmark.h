@@ -0,0 +1,62 @@
+#ifndef RAY_TRACER_SHADING_BENCHMARK_H
+#define RAY_TRACER_SHADING_BENCHMARK_H
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "camera.h"
+#include "world.h"
+
+static const int kShadingRepeats { 5 };
+
+// Finds the hits of the camera's primary rays, then times preparing each hit
+// for shading (IntersectionComputation) and shading it (World::ColourAt(),
+// including its secondary rays) apart from finding the hits, and prints the
+// average cost per hit of the fastest of a few passes
+void ShadingBenchmark(const World& world, const Camera& camera, std::ostream& os) {
+    std::vector<Ray> rays {};
+    std::vector<IntersectionList> lists {};
+    for (int y = 0; y < camera.Vertical(); y++) {
+        for (int x = 0; x < camera.Horizontal(); x++) {
+            Ray ray = camera.RayAt(x, y);
+            IntersectionList xs = world.Intersect(ray);
+            if (xs.Hit() != nullptr) {
+                rays.push_back(ray);
+                lists.push_back(std::move(xs));
+            }
+        }
+    }
+    if (rays.empty()) {
+        os << "no hits to shade" << std::endl;
+        return;
+    }
+
+    double prepare { 0 }, shade { 0 };
+    Colour total {};
+    for (int repeat = 0; repeat < kShadingRepeats; repeat++) {
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < rays.size(); i++) {
+            const IntersectionComputation ic { *lists[i].Hit(), rays[i], &lists[i] };
+            total += Colour { ic.Distance(), 0, 0 };
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        prepare = (repeat == 0 || elapsed.count() < prepare) ? elapsed.count() : prepare;
+
+        start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < rays.size(); i++) {
+            const IntersectionComputation ic { *lists[i].Hit(), rays[i], &lists[i] };
+            total += world.ColourAt(ic);
+        }
+        elapsed = std::chrono::steady_clock::now() - start;
+        shade = (repeat == 0 || elapsed.count() < shade) ? elapsed.count() : shade;
+    }
+
+    // the total is printed only so that the work can't be optimised away
+    os << "primary hits: " << rays.size() << std::endl;
+    os << "prepare per hit (ns): " << prepare * 1e9 / rays.size() << std::endl;
+    os << "shade per hit (ns): " << shade * 1e9 / rays.size() << std::endl;
+    os << "checksum: " << total.Red() << std::endl;
+}
+
+#endif
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include "pattern.h"
 #include "group.h"
 #include "hemisphere.h"
+#include "scene.h"
 
 Matrix CameraTransform(double scale) {
     Point from { -0.5*scale, scale, -7* scale }, to { -0.5*scale, 0.5*scale, 0 };
@@ -16,24 +17,18 @@ Matrix CameraTransform(double scale) {
 using Cup = ShapeGroup*;
 
 class CupFactory {
-    std::vector<Shape*> objects_;
+    // owns the cups' parts and groups
+    Scene scene_;
 
     public:
-        CupFactory() {}
-        ~CupFactory() {
-            for (auto o: objects_) {
-                delete o;
-            }
-        }
+        CupFactory(): scene_ {} {}
         Cup GetCup(const Transformation& t) {
-            Hemisphere* cup = new Hemisphere();
-            objects_.push_back(cup);
+            Hemisphere* cup = scene_.Make<Hemisphere>();
             cup->SetTransform(t);
             cup->SetMaterial(CupMaterial());
             cup->Closed(false);
 
-            Hemisphere* bob = new Hemisphere();
-            objects_.push_back(bob);
+            Hemisphere* bob = scene_.Make<Hemisphere>();
             bob->SetTransform(
                 t *
                 Transformation()
@@ -43,8 +38,7 @@ class CupFactory {
             );
             bob->SetMaterial(BobMaterial());
 
-            Cup collection = new ShapeGroup();
-            objects_.push_back(collection);
+            Cup collection = scene_.Make<ShapeGroup>();
             *collection << cup << bob;
             return collection;
         }
@@ -135,6 +129,9 @@ int main(int argc, char** argv) {
         .Surface(Colour {0.5, 0.2, 0.6}));
 
     Camera camera = SceneCamera(scale, 108, 135, M_PI / 3, CameraTransform(scale));
+    if (Serve(argc, argv, world, camera)) {
+        return 0;
+    }
     Canvas canvas = camera.RenderConcurrent(world);
     PPMv3 ppm { canvas };
     std::cout << ppm;
@@ -2,6 +2,8 @@
 Render a scene composed of randomly positioned submerged spheres of different sizes and colours.
 
 Supply a scaling factor at the command line to increase the resolution.
+Add --serve=<socket> to keep the scene loaded and render frames of it on
+request (see RenderServer).
 */
 
 #include <vector>
@@ -14,57 +16,46 @@ Supply a scaling factor at the command line to increase the resolution.
 #include "sphere.h"
 #include "pattern.h"
 #include "group.h"
+#include "scene.h"
 
 class PatternManager {
-    std::vector<Pattern*> patterns_;
+    // owns the patterns
+    Scene& scene_;
 
     public:
-        PatternManager(): patterns_ {} {}
-        ~PatternManager();
+        PatternManager(Scene& scene): scene_ { scene } {}
         Pattern* GroundPattern(double scale);
         Pattern* HorizonPattern(double scale);
         Pattern* BlobPattern(double scale, const Colour& base_colour);
 };
 
-PatternManager::~PatternManager() {
-    for (Pattern* pattern: patterns_) {
-        delete pattern;
-    }
-}
-
 Pattern* PatternManager::GroundPattern(double scale) {
-    RadialGradientPattern* rgp = new RadialGradientPattern(
+    RadialGradientPattern* rgp = scene_.Make<RadialGradientPattern>(
         Colour { 184.0 / 255, 134.0 / 255, 11.0 / 255 }, // dark golden rod
         Colour { 245.0 / 255, 222.0 / 255, 179.0 / 255 } // wheat
     );
     rgp->SetTransform(Transformation().Scale(0.125 * scale, 1, 1));
-    PerturbedPattern* ground_pattern = new PerturbedPattern(rgp);
-    patterns_.push_back(rgp);
-    patterns_.push_back(ground_pattern);
+    PerturbedPattern* ground_pattern = scene_.Make<PerturbedPattern>(rgp);
     return ground_pattern;
 }
 
 Pattern* PatternManager::HorizonPattern(double scale) {
-    GradientPattern* gp = new GradientPattern(
+    GradientPattern* gp = scene_.Make<GradientPattern>(
         Colour { 140.0 / 255, 190.0 / 255, 214.0 / 255 }, // dark sky blue
         Colour { 135.0 / 255, 206.0 / 255, 250.0 / 255 }  // light sky blue
     );
     gp->SetTransform(Transformation().Scale(scale * 20, 1, 1).RotateY(-M_PI / 2));
-    PerturbedPattern* horizon_pattern = new PerturbedPattern(gp);
-    patterns_.push_back(gp);
-    patterns_.push_back(horizon_pattern);
+    PerturbedPattern* horizon_pattern = scene_.Make<PerturbedPattern>(gp);
     return horizon_pattern;
 }
 
 Pattern* PatternManager::BlobPattern(double scale, const Colour& base_colour) {
-    RadialGradientPattern* rgp = new RadialGradientPattern(
+    RadialGradientPattern* rgp = scene_.Make<RadialGradientPattern>(
         base_colour,
         Colour { 152.0 / 255, 118.0 / 255, 84.0 / 255 } // pale brown
     );
     rgp->SetTransform(Transformation().Scale(0.25 * scale, 1, 1));
-    PerturbedPattern* blob_pattern = new PerturbedPattern(rgp);
-    patterns_.push_back(rgp);
-    patterns_.push_back(blob_pattern);
+    PerturbedPattern* blob_pattern = scene_.Make<PerturbedPattern>(rgp);
     return blob_pattern;
 }
 
@@ -108,15 +99,15 @@ Colour RandomBlobColour(const SimpleRandomNumberGenerator& srng) {
     return Colour { base.Red() + Number(), base.Green() + Number(), base.Blue() + Number() };
 }
 
-Sphere Blob(double scale, double x, double z, const SimpleRandomNumberGenerator& srng,
-        PatternManager& pm) {
+Sphere* Blob(Scene& scene, double scale, double x, double z,
+        const SimpleRandomNumberGenerator& srng, PatternManager& pm) {
     Material material {};
     material.Specular(0.1);
     material.Shininess(10);
     material.Diffuse(1);
     material.SurfacePattern(pm.BlobPattern(scale, RandomBlobColour(srng)));
-    Sphere blob {};
-    blob.SetMaterial(material);
+    Sphere* blob = scene.Make<Sphere>();
+    blob->SetMaterial(material);
     double size = scale * 0.25 * (srng.Number() % 3 + 1),
            x_size = size,
            y_size = size,
@@ -140,7 +131,7 @@ Sphere Blob(double scale, double x, double z, const SimpleRandomNumberGenerator&
         .Scale(x_size, y_size, z_size)
         .Translate(x * scale, 0, z * scale)
         .RotateY(rotation);
-    blob.SetTransform(transform);
+    blob->SetTransform(transform);
     return blob;
 }
 
@@ -171,8 +162,10 @@ int main(int argc, char** argv) {
 
     int scale_int = static_cast<int>(scale);
 
+    // owns the patterns and blobs
+    Scene scene {};
     World world {};
-    PatternManager pattern_mgr {};
+    PatternManager pattern_mgr { scene };
 
     Plane ground = Ground(pattern_mgr.GroundPattern(scale));
     world.Add(&ground);
@@ -216,11 +209,9 @@ int main(int argc, char** argv) {
     ShapeGroup collection {};
     world.Add(&collection);
 
-    Sphere blobs[n_blobs] {};
     for (int i = 0; i < n_blobs; i++) {
         MapPosition position = XZ(map);
-        blobs[i] = Blob(scale, position.x_, position.z_, srng, pattern_mgr);
-        collection.Add(&blobs[i]);
+        collection.Add(Blob(scene, scale, position.x_, position.z_, srng, pattern_mgr));
     }
 
     Light light = WorldLight(scale);
@@ -229,9 +220,11 @@ int main(int argc, char** argv) {
     Camera camera { 191 * scale_int, 100 * scale_int, M_PI / 3 };
     camera.SetTransform(CameraTransform(scale));
 
-    Canvas canvas = camera.RenderConcurrent(world);
-    PPMv3 ppm { canvas };
-    std::cout << ppm;
+    if (!Serve(argc, argv, world, camera)) {
+        Canvas canvas = camera.RenderConcurrent(world);
+        PPMv3 ppm { canvas };
+        std::cout << ppm;
+    }
 
     // Clean up heap
     for (int i = 0; i < map_dimension; i++) {
@@ -20,6 +20,8 @@ Matrix CameraTransform(double scale) {
 
 int main(int argc, char** argv) {
     double scale = GetScale(argc, argv);
+    bool stats = HasOption(argc, argv, "--stats");
+    std::string bvh_cache = GetOption(argc, argv, "--bvh-cache");
 
     double sheet_scale { 3 * scale },
            sheet_y { sheet_scale / 2 },
@@ -89,10 +91,27 @@ int main(int argc, char** argv) {
             row->Add(flag);
         }
     }
-    shapes.Divide(100);
+    if (bvh_cache.empty()) {
+        shapes.Divide(100);
+    }
+    else {
+        shapes.Divide(100, bvh_cache);
+    }
+
+    if (stats) {
+        std::cerr << shapes.Statistics();
+        TraversalStatistics::Enable();
+    }
 
     Camera camera = SceneCamera(scale, 108, 135, M_PI / 3, CameraTransform(scale));
+    if (Serve(argc, argv, world, camera)) {
+        return 0;
+    }
     Canvas canvas = camera.RenderConcurrent(world);
+
+    if (stats) {
+        TraversalStatistics::Report(std::cerr);
+    }
     PPMv3 ppm { canvas };
     std::cout << ppm;
 
@@ -44,6 +44,9 @@ int main(int argc, char** argv) {
     s2.SetMaterial(GlassMaterial(Colour {0, 0, 1}));
 
     Camera camera = SceneCamera(scale, 108, 135, M_PI / 3, CameraTransform(scale));
+    if (Serve(argc, argv, world, camera)) {
+        return 0;
+    }
     Canvas canvas = camera.RenderConcurrent(world);
     PPMv3 ppm { canvas };
     std::cout << ppm;
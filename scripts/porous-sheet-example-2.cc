@@ -85,6 +85,9 @@ int main(int argc, char** argv) {
     }
 
     Camera camera = SceneCamera(scale, 108, 135, M_PI / 2, CameraTransform(scale));
+    if (Serve(argc, argv, world, camera)) {
+        return 0;
+    }
     Canvas canvas = camera.RenderConcurrent(world);
     PPMv3 ppm { canvas };
     std::cout << ppm;
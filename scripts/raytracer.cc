@@ -0,0 +1,134 @@
+/*
+Render a scene described by a YAML or JSON file (see SceneFile), e.g.
+
+    raytracer scenes/chapter-07.yml --threads=4 --output=chapter-07.ppm
+
+The scene is read from stdin if the file is "-". The image is written to
+stdout, or to --output=<file>, as plain PPM or, with --format=p6, binary PPM.
+Add --threads=<n> to trace with n threads (by default, as many as the
+hardware supports), which take square tiles of --tile-size=<n> pixels in
+turn, and --crop=<column>,<row>,<width>,<height> to render only that
+rectangle of the image.
+Add --samples=<n> to trace n rays per pixel, placed by --pattern=<name>
+(random, stratified, halton or sobol) and weighted by --filter=<name> (box,
+tent or mitchell) (see Camera::RenderMultisample()).
+Add --workers=<n> to render the tiles in n processes forked from this one
+(see RenderWithWorkers()).
+Add --serve=<socket> to keep the scene loaded and render frames of it on
+request (see RenderServer).
+Add --stats to print the time taken to load and to render the scene to
+stderr.
+*/
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "scripts.h"
+#include "scene-file.h"
+#include "sampler.h"
+#include "distributed.h"
+
+// Parses --crop=<column>,<row>,<width>,<height>
+static bool ParseCrop(const std::string& crop, int region[4]) {
+    std::istringstream values { crop };
+    char comma { ',' };
+    for (int i = 0; i < 4; i++) {
+        if ((i > 0 && !(values >> comma)) || comma != ',' || !(values >> region[i])) {
+            return false;
+        }
+    }
+    return values.eof();
+}
+
+int main(int argc, char** argv) {
+    std::string path {};
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--", 2) != 0) {
+            path = argv[i];
+            break;
+        }
+    }
+    if (path.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <scene file> [options]" << std::endl;
+        return 1;
+    }
+
+    try {
+        auto start = std::chrono::steady_clock::now();
+        SceneFile scene {};
+        if (path == "-") {
+            scene.Load(std::cin);
+        }
+        else {
+            scene.Load(path);
+        }
+        const World& world = scene.SceneWorld();
+        const Camera& camera = scene.SceneCamera();
+        auto loaded = std::chrono::steady_clock::now();
+
+        if (Serve(argc, argv, world, camera)) {
+            return 0;
+        }
+
+        std::string tile_size = GetOption(argc, argv, "--tile-size"),
+                    crop = GetOption(argc, argv, "--crop"),
+                    samples = GetOption(argc, argv, "--samples"),
+                    workers = GetOption(argc, argv, "--workers"),
+                    format = GetOption(argc, argv, "--format"),
+                    output = GetOption(argc, argv, "--output");
+        int tile = tile_size.empty() ? Camera::kRegionTileSize : std::stoi(tile_size);
+        int region[4] { 0, 0, camera.Horizontal(), camera.Vertical() };
+        if (!crop.empty() && !ParseCrop(crop, region)) {
+            throw std::invalid_argument("Invalid --crop: " + crop);
+        }
+        if (!crop.empty() && !(samples.empty() && workers.empty())) {
+            throw std::invalid_argument("--crop can't be used with --samples or --workers");
+        }
+        if (!format.empty() && format != "p3" && format != "p6") {
+            throw std::invalid_argument("Unknown --format: " + format);
+        }
+
+        std::string pattern = GetOption(argc, argv, "--pattern"),
+                    filter = GetOption(argc, argv, "--filter");
+        PixelSampler sampler { samples.empty() ? 1 : std::stoi(samples),
+            pattern.empty() ? SamplePattern::kSobol : PixelSampler::ParsePattern(pattern),
+            filter.empty() ? PixelFilter::kBox : PixelSampler::ParseFilter(filter) };
+
+        Canvas canvas = !workers.empty() ? RenderWithWorkers(world, camera, std::stoi(workers),
+                tile_size.empty() ? kDefaultWorkerTileSize : tile)
+            : !samples.empty() ? camera.RenderMultisample(world, sampler, GetThreads(argc, argv))
+            : camera.RenderRegion(world, region[0], region[1], region[2], region[3],
+                GetThreads(argc, argv), tile);
+        auto rendered = std::chrono::steady_clock::now();
+
+        std::ofstream file {};
+        if (!output.empty()) {
+            file.open(output, std::ios::binary);
+            if (!file) {
+                throw std::runtime_error("Couldn't write to " + output);
+            }
+        }
+        std::ostream& os = output.empty() ? std::cout : file;
+        if (format == "p6") {
+            os << PPMv6 { canvas };
+        }
+        else {
+            os << PPMv3 { canvas };
+        }
+
+        if (HasOption(argc, argv, "--stats")) {
+            std::chrono::duration<double> loading = loaded - start, rendering = rendered - loaded;
+            std::cerr << "Loaded " << scene.NShapes() << " shapes in " << loading.count()
+                << "s; rendered " << canvas.Width() << "x" << canvas.Height() << " pixels in "
+                << rendering.count() << "s" << std::endl;
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
\ No newline at end of file
@@ -1,9 +1,24 @@
+/*
+Supply a scaling factor at the command line to increase the image dimensions.
+Add --progressive to trace a coarse image first and refine it (see
+Camera::RenderProgressive()), with --threads=<n> threads; --time-budget=<s>
+stops tracing after s seconds and writes the image so far, and
+--preview=<prefix> writes the image after each pass to <prefix>-<pass>.ppm.
+Add --serve=<socket> to keep the scene loaded and render frames of it on
+request (see RenderServer).
+*/
+
+#include <chrono>
+#include <fstream>
+#include <string>
+
 #include "scripts.h"
 #include "plane.h"
 #include "sphere.h"
 #include "pattern.h"
 #include "group.h"
 #include "sheet.h"
+#include "scene.h"
 
 Light WorldLight(double scale) {
     Point origin { -25 * scale, 30 * scale, -20 * scale };
@@ -23,21 +38,15 @@ Matrix CameraTransform(double scale) {
 }
 
 class PatternFactory {
-    std::vector<Pattern*> patterns_;
+    // owns the patterns
+    Scene scene_;
 
     public:
-        PatternFactory(): patterns_ {} {}
-
-        ~PatternFactory() {
-            for (auto p: patterns_) {
-                delete p;
-            }
-        }
+        PatternFactory(): scene_ {} {}
 
         Pattern* SandPattern(const Colour& colour,
                 const Matrix* transform = nullptr) {
-            SpeckledPattern* speckled_ptn = new SpeckledPattern(colour);
-            patterns_.push_back(speckled_ptn);
+            SpeckledPattern* speckled_ptn = scene_.Make<SpeckledPattern>(colour);
             speckled_ptn->SetDarkThreshold(0.8);
             speckled_ptn->SetAttentuation(0.3);
             speckled_ptn->SetLightThreshold(0.8);
@@ -46,20 +55,17 @@ class PatternFactory {
 
         Pattern* RockPattern(const Colour& dark, const Colour& light,
                 const Matrix* transform = nullptr) {
-            SpeckledPattern* dark_ptn = new SpeckledPattern(dark);
-            patterns_.push_back(dark_ptn);
+            SpeckledPattern* dark_ptn = scene_.Make<SpeckledPattern>(dark);
             dark_ptn->SetDarkThreshold(0.8);
-            SpeckledPattern* light_ptn = new SpeckledPattern(light);
-            patterns_.push_back(light_ptn);
+            SpeckledPattern* light_ptn = scene_.Make<SpeckledPattern>(light);
             light_ptn->SetDarkThreshold(0.8);
             light_ptn->SetLightThreshold(0.8);
             light_ptn->SetAttentuation(0.8);
-            RadialGradientPattern* gradient_ptn = new RadialGradientPattern(dark_ptn, light_ptn);
-            patterns_.push_back(gradient_ptn);
+            RadialGradientPattern* gradient_ptn = scene_.Make<RadialGradientPattern>(dark_ptn, light_ptn);
             if (transform) {
                 gradient_ptn->SetTransform(*transform);
             }
-            PerturbedPattern* perturbed_ptn = new PerturbedPattern(gradient_ptn);
+            PerturbedPattern* perturbed_ptn = scene_.Make<PerturbedPattern>(gradient_ptn);
             return perturbed_ptn;
         }
 };
@@ -117,30 +123,22 @@ Sheet Water(double scale) {
 using Bubble = ShapeGroup*;
 
 class BubbleFactory {
-    std::vector<Shape*> shapes_;
+    // owns the bubbles and their spheres
+    Scene scene_;
 
     public:
-        BubbleFactory(): shapes_ {} {}
-
-        ~BubbleFactory() {
-            for (auto s: shapes_) {
-                delete s;
-            }
-        }
+        BubbleFactory(): scene_ {} {}
 
         Bubble Generate(const Colour& colour, double scale, double bubble_ratio=0.98) {
-            Bubble bubble = new ShapeGroup();
-            shapes_.push_back(bubble);
+            Bubble bubble = scene_.Make<ShapeGroup>();
 
-            Sphere* outside = new Sphere();
-            shapes_.push_back(outside);
+            Sphere* outside = scene_.Make<Sphere>();
             outside->SetTransform(Transformation().Scale(scale));
             outside->SetMaterial(GlassMaterial(colour));
             *bubble << outside;
 
             if (bubble_ratio > 0.0 && bubble_ratio < 1.0) {
-                Sphere* inside = new Sphere();
-                shapes_.push_back(inside);
+                Sphere* inside = scene_.Make<Sphere>();
                 inside->SetTransform(Transformation().Scale(scale * bubble_ratio));
                 inside->SetMaterial(AirBubbleMaterial());
                 *bubble << inside;
@@ -182,8 +180,9 @@ int main(int argc, char** argv) {
         .Translate(-scale, -0.1*scale, -1.3*scale)
     );
 
+    Matrix rock_1_inverse = rock_1.InverseTransform().ToMatrix();
     rock_1.SetMaterial(RockMaterial(pattern_factory.RockPattern(
-        spanish_bistre, raw_umber, &rock_1.InverseTransform()
+        spanish_bistre, raw_umber, &rock_1_inverse
     )));
 
     Sphere rock_2 {};
@@ -197,8 +196,9 @@ int main(int argc, char** argv) {
         .Translate(0.15*scale, 0, 1.25 * scale)
     );
 
+    Matrix rock_2_inverse = rock_2.InverseTransform().ToMatrix();
     rock_2.SetMaterial(RockMaterial(pattern_factory.RockPattern(
-        pale_brown, wood_brown, &rock_2.InverseTransform()
+        pale_brown, wood_brown, &rock_2_inverse
     )));
 
     Sphere rock_3 {};
@@ -210,8 +210,9 @@ int main(int argc, char** argv) {
         .Translate(0.5*scale, 0.15*scale, -2*scale)
     );
 
+    Matrix rock_3_inverse = rock_3.InverseTransform().ToMatrix();
     rock_3.SetMaterial(RockMaterial(pattern_factory.RockPattern(
-        bistre, bistre, &rock_3.InverseTransform()
+        bistre, bistre, &rock_3_inverse
     )));
 
     Plane sand {};
@@ -251,6 +252,27 @@ int main(int argc, char** argv) {
     }
 
     Camera camera = SceneCamera(scale, 108, 135, M_PI / 3, CameraTransform(scale));
+    if (Serve(argc, argv, world, camera)) {
+        return 0;
+    }
+    if (HasOption(argc, argv, "--progressive")) {
+        std::string budget = GetOption(argc, argv, "--time-budget"),
+                    prefix = GetOption(argc, argv, "--preview");
+        auto start = std::chrono::steady_clock::now();
+        Camera::PreviewCallback preview = [&](const Canvas& image, int pass) {
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            std::cerr << "pass " << pass << " after " << elapsed.count() << "s" << std::endl;
+            if (!prefix.empty()) {
+                std::ofstream file { prefix + "-" + std::to_string(pass) + ".ppm" };
+                file << PPMv3 { image };
+            }
+        };
+        Canvas canvas = camera.RenderProgressive(world, budget.empty() ? 0 : std::stod(budget),
+            preview, GetThreads(argc, argv));
+        std::cout << PPMv3 { canvas };
+        return 0;
+    }
+
     Canvas canvas = camera.RenderConcurrent(world);
     PPMv3 ppm { canvas };
     std::cout << ppm;
@@ -3,8 +3,12 @@
 
 #define _USE_MATH_DEFINES // for M_PI
 
+#include <algorithm> // for max
 #include <cmath>
+#include <cstring> // for strcmp
 #include <iostream>
+#include <string>
+#include <thread>
 
 #include "matrix.h"
 #include "transformations.h"
@@ -13,14 +17,19 @@
 #include "world.h"
 #include "camera.h"
 #include "canvas.h"
+#include "render-server.h"
 
 static double kMaxScale { 20.0 };
 
 double GetScale(int argc, char** argv) {
     double scale { 1.0 };
 
-    if (argc > 1) {
-        scale = atof(argv[1]);
+    // the scale is the first argument that isn't an option
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--", 2) != 0) {
+            scale = atof(argv[i]);
+            break;
+        }
     }
 
     if (scale <= 0 || scale > kMaxScale) {
@@ -30,6 +39,52 @@ double GetScale(int argc, char** argv) {
     return scale;
 }
 
+bool HasOption(int argc, char** argv, const char* option) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], option) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Returns the value of an option given as --name=value, or an empty string
+std::string GetOption(int argc, char** argv, const char* option) {
+    std::size_t length = strlen(option);
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], option, length) == 0 && argv[i][length] == '=') {
+            return std::string { argv[i] + length + 1 };
+        }
+    }
+    return std::string {};
+}
+
+// The number of threads to render with, from --threads=<n> or else the
+// number the hardware supports
+int GetThreads(int argc, char** argv) {
+    std::string threads = GetOption(argc, argv, "--threads");
+    if (!threads.empty()) {
+        return std::stoi(threads);
+    }
+    return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+// With --serve=<socket>, keeps the scene loaded and renders frames of it on
+// request (see RenderServer), with --threads=<n> threads, until a client
+// asks it to stop; returns whether it served rather than the script
+// rendering its image once
+bool Serve(int argc, char** argv, const World& world, const Camera& camera) {
+    std::string path = GetOption(argc, argv, "--serve");
+    if (path.empty()) {
+        return false;
+    }
+    RenderServer server { world, camera, path, GetThreads(argc, argv) };
+    std::cerr << "Serving frames at " << path << std::endl;
+    server.Serve();
+    std::cerr << "Rendered " << server.Frames() << " frames" << std::endl;
+    return true;
+}
+
 Camera SceneCamera(double scale, int width, int height, double fov, const Matrix& view_transform) {
     int scale_int = static_cast<int>(scale);
     Camera camera { width * scale_int, height * scale_int, fov };
@@ -0,0 +1,49 @@
+#include <cmath> // for isfinite
+#include "accelerator.h"
+#include "group.h"
+
+void Accelerator::Flatten(const Shape* s) {
+    // Groups without a transform can be replaced by their children, since
+    // their children's bounds in parent space are also in world space; any
+    // other group is treated as a single primitive
+    if (s->IsGroup() && s->Transform() == Matrix::Identity(4)) {
+        for (auto child: static_cast<const ShapeGroup*>(s)->Children()) {
+            Flatten(child);
+        }
+    }
+    else if (!std::isfinite(s->BoundsOfInParentSpace().SurfaceArea())) {
+        // transforming infinite bounds can also produce NaNs
+        unbounded_.push_back(s);
+    }
+    else {
+        shapes_.push_back(s);
+        bounds_.Add(s->BoundsOfInParentSpace());
+    }
+}
+
+void Accelerator::Build(const std::vector<const Shape*>& objects) {
+    shapes_.clear();
+    unbounded_.clear();
+    bounds_ = BoundingBox {};
+    for (auto s: objects) {
+        Flatten(s);
+    }
+    BuildStructure();
+}
+
+bool Accelerator::IntersectShape(IntersectionList& list, const Ray& ray, const Shape* s) const {
+    if (TraversalStatistics::Enabled()) {
+        TraversalStatistics::CountShapeTest(s);
+    }
+    return s->Intersect(list, ray);
+}
+
+bool Accelerator::IntersectUnbounded(IntersectionList& list, const Ray& ray) const {
+    bool intersected { false };
+    for (auto s: unbounded_) {
+        if (IntersectShape(list, ray, s)) {
+            intersected = true;
+        }
+    }
+    return intersected;
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#include <atomic>
+#include <cstdlib> // for malloc, free
+#include <new>
+#include "allocations.h"
+
+static thread_local unsigned long long allocations { 0 };
+static thread_local unsigned long long bytes_allocated { 0 };
+static std::atomic<unsigned long long> total_allocations { 0 };
+
+bool AllocationCounter::Enabled() {
+#ifdef RAY_TRACER_COUNT_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+unsigned long long AllocationCounter::Count() {
+    return allocations;
+}
+
+unsigned long long AllocationCounter::Bytes() {
+    return bytes_allocated;
+}
+
+unsigned long long AllocationCounter::TotalCount() {
+    return total_allocations;
+}
+
+void AllocationCounter::Reset() {
+    allocations = 0;
+    bytes_allocated = 0;
+}
+
+#ifdef RAY_TRACER_COUNT_ALLOCATIONS
+
+// The other forms of operator new and delete (arrays, nothrow) call these
+void* operator new(std::size_t size) {
+    allocations++;
+    bytes_allocated += size;
+    total_allocations.fetch_add(1, std::memory_order_relaxed);
+    void* p = std::malloc(size > 0 ? size : 1);
+    if (p == nullptr) {
+        throw std::bad_alloc {};
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+#endif
\ No newline at end of file
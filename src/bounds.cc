@@ -21,8 +21,8 @@ void BoundingBox::Add(const Point& p) {
 void BoundingBox::Add(const BoundingBox& b) {
     // resize bounding box so its min/max contain the given box
     for (auto index: kIndices) {
-        double min_coord = b.min_.At(index),
-               max_coord = b.max_.At(index);
+        double min_coord = b.min_[index],
+               max_coord = b.max_[index];
         if (min_coord < min_[index]) {
             min_[index] = min_coord;
         }
@@ -35,7 +35,7 @@ void BoundingBox::Add(const BoundingBox& b) {
 bool BoundingBox::Contains(const Point& p) const {
     for (auto index: kIndices) {
         double coord = p.At(index);
-        if (coord < min_.At(index) || coord > max_.At(index)) {
+        if (coord < min_[index] || coord > max_[index]) {
             return false;
         }
     }
@@ -44,9 +44,9 @@ bool BoundingBox::Contains(const Point& p) const {
 
 bool BoundingBox::Contains(const BoundingBox& b) const {
     for (auto index: kIndices) {
-        double min_coord = b.min_.At(index),
-               max_coord = b.max_.At(index);
-        if (min_coord < min_.At(index) || max_coord > max_.At(index)) {
+        double min_coord = b.min_[index],
+               max_coord = b.max_[index];
+        if (min_coord < min_[index] || max_coord > max_[index]) {
             return false;
         }
     }
@@ -54,82 +54,96 @@ bool BoundingBox::Contains(const BoundingBox& b) const {
 }
 
 const BoundingBox BoundingBox::Transform(const Matrix& m) const {
-    // Apply given transform to each corner of the bounding box and return the
-    // result
-    BoundingBox transformed {};
-    std::array<Point, 8> corners = {
-        min_,
-        { min_.X(), min_.Y(), max_.Z() },
-        { min_.X(), max_.Y(), min_.Z() },
-        { min_.X(), max_.Y(), max_.Z() },
-        { max_.X(), min_.Y(), min_.Z() },
-        { max_.X(), min_.Y(), max_.Z() },
-        { max_.X(), max_.Y(), min_.Z() },
-        max_
-    };
-
-    for (auto corner: corners) {
-        transformed.Add(m * corner);
+    // Apply given transform to the bounding box and return the result.
+    // Rather than transforming each of the box's eight corners, find the
+    // extent of each axis of the result from the products of the matrix
+    // elements and the box's extents (see James Arvo, "Transforming
+    // Axis-Aligned Bounding Boxes", Graphics Gems, 1990). Zero elements are
+    // skipped, so that unbounded boxes (e.g., for planes) don't produce
+    // NaNs from 0 * infinity.
+    if (min_[0] > max_[0]) {
+        // an empty box stays empty
+        return BoundingBox {};
     }
-
-    return transformed;
+    Point min, max;
+    for (auto row: kIndices) {
+        double translation = m.At(row, 3);
+        min[row] = max[row] = translation;
+        for (auto column: kIndices) {
+            double element = m.At(row, column);
+            if (element == 0) {
+                continue;
+            }
+            double a = element * min_[column],
+                   b = element * max_[column];
+            min[row] += std::min(a, b);
+            max[row] += std::max(a, b);
+        }
+    }
+    return BoundingBox { min, max };
 }
 
-std::array<double, 2> BoundingBox::IntersectionsByAxis(const Ray& ray,
-        const SpatialTuple::Coordinates axis) const {
-    // This is essentially the same as Cube::IntersectionsByAxis(), but replaces
-    // the unit offsets for the numerators with the actual the minimum and
-    // maximum extents of the bounding box for the given axis
-
-    double origin = ray.Origin().At(axis),
-           direction = ray.Direction().At(axis);
-
-    double tmin_numerator = min_.At(axis) - origin,
-           tmax_numerator = max_.At(axis) - origin;
-
-    std::array<double, 2> t {};
+const bool BoundingBox::Intersects(const Ray& ray) const {
+    double tmin { -kBBInfinity }, tmax { kBBInfinity };
+    return Intersects(ray, tmin, tmax);
+}
 
-    if (std::fabs(direction) >= kEpsilon) {
-        t[0] = tmin_numerator / direction;
-        t[1] = tmax_numerator / direction;
+bool BoundingBox::Intersects(const Ray& ray, double& tmin, double& tmax) const {
+    // Slab test: narrow the interval [tmin, tmax] to the distances at which
+    // the ray is between each pair of planes bounding the box. The ray's sign
+    // bits select the near and far planes, so there are no branches. If the
+    // ray lies in one of the planes the distance is NaN, and comparisons with
+    // NaN are false, so that axis leaves the interval as it is. On a hit,
+    // tmin and tmax are set to where the ray enters and leaves the box.
+    const Point& origin = ray.Origin();
+    const std::array<double, 3>* bounds[2] = { &min_, &max_ };
+    double t0 = tmin,
+           t1 = tmax;
+    for (auto axis: kIndices) {
+        int sign = ray.Sign(axis);
+        double inverse = ray.InverseDirection(axis),
+               near = ((*bounds[sign])[axis] - origin.At(axis)) * inverse,
+               far = ((*bounds[1 - sign])[axis] - origin.At(axis)) * inverse;
+        t0 = (near > t0) ? near : t0;
+        t1 = (far < t1) ? far : t1;
     }
-    else {
-        double infinity = std::numeric_limits<double>::infinity();
-        t[0] = tmin_numerator * kBBInfinity;
-        t[1] = tmax_numerator * kBBInfinity;
+    if (t0 <= t1) {
+        tmin = t0;
+        tmax = t1;
+        return true;
     }
-
-    if (t[0] > t[1]) {
-        double temp = t[0];
-        t[0] = t[1];
-        t[1] = temp;
-    }
-    return t;
+    return false;
 }
 
-const bool BoundingBox::Intersects(const Ray& ray) const {
-    // This is essentially the same as Cube::Intersects()
-
-    std::array<double, 2> xt = IntersectionsByAxis(ray, SpatialTuple::Coordinates::kX),
-                          yt = IntersectionsByAxis(ray, SpatialTuple::Coordinates::kY);
-
-    if (xt[0] > yt[1] || yt[0] > xt[1]) {
-        return false;
+LaneMask BoundingBox::Intersects(const RayPacket& packet, double* tmin, double* tmax) const {
+    // The same slab test for every lane, with the planes selected per lane so
+    // that the results are identical; returns the lanes that hit the box
+    const int size = packet.Size();
+    const double* origins[3] = { packet.OriginX(), packet.OriginY(), packet.OriginZ() };
+    const double* inverses[3] = {
+        packet.InverseDirectionX(), packet.InverseDirectionY(), packet.InverseDirectionZ()
+    };
+    for (auto axis: kIndices) {
+        const double* origin = origins[axis];
+        const double* inverse_direction = inverses[axis];
+        double min = min_[axis],
+               max = max_[axis];
+        for (int lane = 0; lane < size; lane++) {
+            double inverse = inverse_direction[lane];
+            bool negative = inverse < 0;
+            double near = ((negative ? max : min) - origin[lane]) * inverse,
+                   far = ((negative ? min : max) - origin[lane]) * inverse;
+            tmin[lane] = (near > tmin[lane]) ? near : tmin[lane];
+            tmax[lane] = (far < tmax[lane]) ? far : tmax[lane];
+        }
     }
-
-    double tmin = std::max(xt[0], yt[0]),
-           tmax = std::min(xt[1], yt[1]);
-
-    std::array<double, 2> zt = IntersectionsByAxis(ray, SpatialTuple::Coordinates::kZ);
-
-    if (zt[0] > tmax || zt[1] < tmin) {
-        return false;
+    LaneMask hits { 0 };
+    for (int lane = 0; lane < size; lane++) {
+        if (tmin[lane] <= tmax[lane]) {
+            hits |= 1u << lane;
+        }
     }
-
-    tmin = std::max(tmin, zt[0]);
-    tmax = std::min(tmax, zt[1]);
-
-    return tmax > tmin;
+    return hits;
 }
 
 const std::array<const BoundingBox, 2> BoundingBox::Split() const {
@@ -141,8 +155,8 @@ const std::array<const BoundingBox, 2> BoundingBox::Split() const {
     int index_of_greatest {};
 
     for (auto index: kIndices) {
-        double min_coord = min_.At(index),
-               max_coord = max_.At(index),
+        double min_coord = min_[index],
+               max_coord = max_[index],
                length = max_coord - min_coord;
         if (length > greatest) {
             greatest = length;
@@ -152,8 +166,8 @@ const std::array<const BoundingBox, 2> BoundingBox::Split() const {
 
     // variables to help construct the points on
     // the dividing plane
-    Point p0 = min_,
-          p1 = max_;
+    Point p0 = Min(),
+          p1 = Max();
 
     // adjust the points so that they lie on the
     // dividing plane
@@ -162,7 +176,25 @@ const std::array<const BoundingBox, 2> BoundingBox::Split() const {
 
     // construct and return the two halves of
     // the bounding box
-    BoundingBox left { min_, p1 },
-                right { p0, max_ };
+    BoundingBox left { Min(), p1 },
+                right { p0, Max() };
     return std::array<const BoundingBox, 2> { left, right };
+}
+
+double BoundingBox::SurfaceArea() const {
+    // Used by the surface area heuristic (SAH) to estimate the probability
+    // that a ray hitting a parent box also hits this box
+    double dx = max_[0] - min_[0],
+           dy = max_[1] - min_[1],
+           dz = max_[2] - min_[2];
+
+    if (dx < 0 || dy < 0 || dz < 0) {
+        // the box is empty
+        return 0;
+    }
+    if (std::isinf(dx) || std::isinf(dy) || std::isinf(dz)) {
+        // avoid 0 * infinity for unbounded shapes like planes
+        return kBBInfinity;
+    }
+    return 2 * (dx * dy + dy * dz + dz * dx);
 }
\ No newline at end of file
@@ -1,5 +1,11 @@
+#include <algorithm> // for all_of, min, max
+#include <atomic>
+#include <chrono>
 #include <cmath>
 #include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 #include "camera.h"
 #include "space.h"
 #include "colour.h"
@@ -21,33 +27,70 @@ Camera::Camera(int horizontal, int vertical, double field_of_view):
         half_height_ = half_view;
     }
     pixel_size_ = half_width_ * 2 / horizontal;
+    UpdateRays();
+}
+
+// Precompute in world space what every ray needs, so that finding a ray takes
+// no matrix multiplications
+void Camera::UpdateRays() {
+    // The camera looks towards -z in its own space, so +x in the world is on
+    // the left from its POV; the canvas is at z = -1, with its top left
+    // corner at (half_width_, half_height_, -1)
+    Point origin = inverse_transform_ * Point { 0, 0, 0 },
+          corner = inverse_transform_ * Point { half_width_, half_height_, -1 };
+    Vector right = inverse_transform_ * Vector { -pixel_size_, 0, 0 },
+           down = inverse_transform_ * Vector { 0, -pixel_size_, 0 };
+    for (int axis = 0; axis < 3; axis++) {
+        origin_[axis] = origin.At(axis);
+        corner_[axis] = corner.At(axis) - origin.At(axis);
+        right_[axis] = right.At(axis);
+        down_[axis] = down.At(axis);
+    }
 }
 
 // Compute in world coords the ray passing through the given pixel (canvas coords)
 const Ray Camera::RayAt(int pixel_x, int pixel_y) const {
-    // Calculate x,y offsets from bottom-left corner of canvas to the center
-    // of the pixel; add 0.5 because (pixel_x, pixel_y) is bottom left
-    // coordinates of the pixel
-    double x_offset = (pixel_x + 0.5) * pixel_size_;
-    double y_offset = (pixel_y + 0.5) * pixel_size_;
-
-    // Calculate untransformed coords of the pixel in world space.
-    // The camera looks towards -z in world space, so +x in the world is on
-    // the left from the camera's POV.
-    double world_x = half_width_ - x_offset;
-    double world_y = half_height_ - y_offset;
-
-    // Apply camera's transform to orient world relative to camera
-    // (moving camera 2 units to the right is the same as moving the world 2
-    // units to the left).
-    // The canvas is positioned at z = -1 in world space.
-    Point world_point { world_x, world_y, -1 },
-          world_origin { 0, 0, 0 },
-          pixel = inverse_transform_ * world_point,
-          origin = inverse_transform_ * world_origin;
-    Vector direction = pixel - origin;
-    Ray ray { origin, direction.Normalize() };
-    return ray;
+    // Add 0.5 because (pixel_x, pixel_y) is bottom left coordinates of the
+    // pixel
+    return RayThrough(pixel_x + 0.5, pixel_y + 0.5);
+}
+
+// Compute in world coords the ray passing through the given point on the
+// canvas, in units of pixels
+const Ray Camera::RayThrough(double x, double y) const {
+    double d[3];
+    for (int axis = 0; axis < 3; axis++) {
+        d[axis] = (corner_[axis] + y * down_[axis]) + x * right_[axis];
+    }
+    double length = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+    return Ray {
+        Point { origin_[0], origin_[1], origin_[2] },
+        Vector { d[0] / length, d[1] / length, d[2] / length }
+    };
+}
+
+void Camera::AddTile(RayPacket& packet, int column, int row, int columns, int rows) const {
+    // The same calculation as RayThrough() for each pixel, a row of
+    // directions at a time
+    double x[kMaxPacketSize], d[3][kMaxPacketSize], length[kMaxPacketSize];
+    for (int c = 0; c < columns; c++) {
+        x[c] = column + c + 0.5;
+    }
+    for (int r = 0; r < rows; r++) {
+        double y = row + r + 0.5;
+        for (int axis = 0; axis < 3; axis++) {
+            double start = corner_[axis] + y * down_[axis];
+            for (int c = 0; c < columns; c++) {
+                d[axis][c] = start + x[c] * right_[axis];
+            }
+        }
+        for (int c = 0; c < columns; c++) {
+            length[c] = std::sqrt(d[0][c] * d[0][c] + d[1][c] * d[1][c] + d[2][c] * d[2][c]);
+        }
+        for (int c = 0; c < columns; c++) {
+            packet.Add(origin_, d[0][c] / length[c], d[1][c] / length[c], d[2][c] / length[c]);
+        }
+    }
 }
 
 const Canvas Camera::Render(const World& world) const {
@@ -55,13 +98,561 @@ const Canvas Camera::Render(const World& world) const {
     for (int row = 0; row < vertical_; row++) {
         for (int column = 0; column < horizontal_; column++) {
             Ray ray = RayAt(column, row);
-            Colour colour = world.ColourAt(ray);
+            Colour colour = world.ColourAt(ray, world.MaxDepth());
             image[row][column] = colour;
         }
     }
     return image;
 }
 
+const int Camera::kRegionTileSize = 16;
+
+const Canvas Camera::RenderRegion(const World& world, int column, int row, int width,
+    int height, int threads, int tile_size) const {
+    if (column < 0 || row < 0 || width < 1 || height < 1 ||
+            width > horizontal_ - column || height > vertical_ - row) {
+        throw std::invalid_argument("Region must be within the image");
+    }
+    if (tile_size < 1) {
+        throw std::invalid_argument("Tile size must be positive");
+    }
+    Canvas image { width, height };
+    int columns = (width + tile_size - 1) / tile_size,
+        tiles = columns * ((height + tile_size - 1) / tile_size);
+    std::atomic<int> next { 0 };
+    auto trace = [&]() {
+        for (int tile = next++; tile < tiles; tile = next++) {
+            int left = tile % columns * tile_size, top = tile / columns * tile_size;
+            for (int r = top; r < std::min(top + tile_size, height); r++) {
+                for (int c = left; c < std::min(left + tile_size, width); c++) {
+                    image[r][c] = world.ColourAt(RayAt(column + c, row + r), world.MaxDepth());
+                }
+            }
+        }
+    };
+    std::vector<std::thread> workers {};
+    for (int t = 1; t < std::min(threads, tiles); t++) {
+        workers.emplace_back(trace);
+    }
+    trace();
+    for (std::thread& worker: workers) {
+        worker.join();
+    }
+    return image;
+}
+
+// Render tiles of 2x2, 4x2 or 4x4 pixels, tracing the primary rays of each
+// tile as one packet; the rays of neighbouring pixels are nearly parallel, so
+// they tend to enter the same groups and hit the same shapes
+const Canvas Camera::RenderPackets(const World& world, int packet_size) const {
+    if (packet_size != 4 && packet_size != 8 && packet_size != 16) {
+        throw std::invalid_argument("Packet size must be 4, 8 or 16");
+    }
+    int tile_width = (packet_size == 4) ? 2 : 4,
+        tile_height = packet_size / tile_width;
+    Canvas image { horizontal_, vertical_ };
+    Colour colours[kMaxPacketSize];
+    for (int tile_row = 0; tile_row < vertical_; tile_row += tile_height) {
+        for (int tile_column = 0; tile_column < horizontal_; tile_column += tile_width) {
+            // tiles at the right and bottom edges may be partly outside the
+            // canvas
+            int rows = std::min(tile_height, vertical_ - tile_row),
+                columns = std::min(tile_width, horizontal_ - tile_column);
+            RayPacket packet {};
+            AddTile(packet, tile_column, tile_row, columns, rows);
+            world.ColourAt(packet, colours, world.MaxDepth());
+            for (int lane = 0; lane < packet.Size(); lane++) {
+                image[tile_row + lane / columns][tile_column + lane % columns] = colours[lane];
+            }
+        }
+    }
+    return image;
+}
+
+const int Camera::kMaxAdaptiveSamples = 21;
+const double Camera::kAdaptiveContrast = 0.1;
+
+// Whether two samples differ enough to be worth sampling between them: they
+// hit different objects, or a component of their colours differs by more
+// than kAdaptiveContrast
+static bool SamplesDiffer(Colour a, const Shape* a_object, Colour b, const Shape* b_object) {
+    if (a_object != b_object) {
+        return true;
+    }
+    for (int i = Colour::kRed; i <= Colour::kBlue; i++) {
+        if (std::abs(a.At(i) - b.At(i)) > Camera::kAdaptiveContrast) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const Colour Camera::Refine(const World& world, double x, double y, double size,
+    const Colour& colour, const Shape* object, int& budget) const {
+    // Sample the centre of each quarter of the square, then refine the
+    // quarters whose samples differ from another's or from the square's own
+    double half = size / 2;
+    Colour colours[4];
+    const Shape* objects[4];
+    for (int q = 0; q < 4; q++) {
+        colours[q] = world.ColourAt(RayThrough(x + (q % 2 + 0.5) * half,
+            y + (q / 2 + 0.5) * half), world.MaxDepth(), &objects[q]);
+    }
+    budget -= 4;
+    for (int q = 0; q < 4; q++) {
+        bool differs = SamplesDiffer(colours[q], objects[q], colour, object);
+        for (int other = 0; other < 4 && !differs; other++) {
+            differs = SamplesDiffer(colours[q], objects[q], colours[other], objects[other]);
+        }
+        if (differs && budget >= 4) {
+            colours[q] = Refine(world, x + (q % 2) * half, y + (q / 2) * half, half,
+                colours[q], objects[q], budget);
+        }
+    }
+    return (colours[0] + colours[1] + colours[2] + colours[3]) * 0.25;
+}
+
+const Canvas Camera::RenderAdaptive(const World& world, int max_samples,
+    std::vector<int>* samples) const {
+    Canvas image { horizontal_, vertical_ };
+    int pixels = horizontal_ * vertical_;
+    std::vector<const Shape*> objects(pixels);
+    std::vector<int> counts(pixels, 1);
+    for (int row = 0; row < vertical_; row++) {
+        for (int column = 0; column < horizontal_; column++) {
+            image[row][column] = world.ColourAt(RayAt(column, row), world.MaxDepth(),
+                &objects[row * horizontal_ + column]);
+        }
+    }
+
+    // Find the pixels to refine from the first samples, before any change
+    std::vector<bool> refine(pixels, false);
+    auto compare = [&](int row, int column, int other_row, int other_column) {
+        int pixel = row * horizontal_ + column,
+            other = other_row * horizontal_ + other_column;
+        if (SamplesDiffer(image[row][column], objects[pixel],
+                image[other_row][other_column], objects[other])) {
+            refine[pixel] = refine[other] = true;
+        }
+    };
+    for (int row = 0; row < vertical_; row++) {
+        for (int column = 0; column < horizontal_; column++) {
+            if (column + 1 < horizontal_) {
+                compare(row, column, row, column + 1);
+            }
+            if (row + 1 < vertical_) {
+                compare(row, column, row + 1, column);
+            }
+        }
+    }
+
+    for (int pixel = 0; pixel < pixels; pixel++) {
+        int budget = max_samples - 1;
+        if (!refine[pixel] || budget < 4) {
+            continue;
+        }
+        int row = pixel / horizontal_, column = pixel % horizontal_;
+        image[row][column] = Refine(world, column, row, 1.0, image[row][column],
+            objects[pixel], budget);
+        counts[pixel] = max_samples - budget;
+    }
+    if (samples != nullptr) {
+        samples->swap(counts);
+    }
+    return image;
+}
+
+// The sums of the samples around each pixel, weighted by a sampler's filter
+class FilteredSums {
+    const PixelSampler& sampler_;
+    int width_;
+    int height_;
+    int reach_; // the furthest pixel, in rows or columns, a sample counts for
+    std::vector<Colour> sums_;
+    std::vector<double> weights_;
+
+    public:
+        FilteredSums(const PixelSampler& sampler, int width, int height): sampler_ { sampler },
+            width_ { width }, height_ { height },
+            reach_ { static_cast<int>(std::ceil(sampler.Radius() - 0.5)) },
+            sums_(width * height), weights_(width * height, 0.0) {}
+
+        // Adds the colour of a sample at (x, y) within the given pixel to the
+        // pixels within the filter's radius of it
+        void Add(int column, int row, double x, double y, const Colour& colour) {
+            int last_row = std::min(height_ - 1, row + reach_),
+                last_column = std::min(width_ - 1, column + reach_);
+            for (int r = std::max(0, row - reach_); r <= last_row; r++) {
+                for (int c = std::max(0, column - reach_); c <= last_column; c++) {
+                    double weight = sampler_.Weight(column + x - (c + 0.5), row + y - (r + 0.5));
+                    if (weight != 0) {
+                        sums_[r * width_ + c] += colour * weight;
+                        weights_[r * width_ + c] += weight;
+                    }
+                }
+            }
+        }
+
+        // for saving and restoring the sums
+        std::vector<Colour>& Sums() { return sums_; }
+        std::vector<double>& Weights() { return weights_; }
+
+        const Canvas Image() const {
+            Canvas image { width_, height_ };
+            for (int pixel = 0; pixel < width_ * height_; pixel++) {
+                image[pixel / width_][pixel % width_] = (weights_[pixel] != 0) ?
+                    sums_[pixel] / weights_[pixel] : Colour::kBlack;
+            }
+            return image;
+        }
+};
+
+const Canvas Camera::RenderMultisample(const World& world, const PixelSampler& sampler,
+    int threads) const {
+    int n = sampler.Samples(), pixels = horizontal_ * vertical_;
+    std::vector<Colour> colours(static_cast<std::size_t>(pixels) * n);
+    auto trace = [&](int first_row, int last_row) {
+        double x, y;
+        for (int row = first_row; row < last_row; row++) {
+            for (int column = 0; column < horizontal_; column++) {
+                std::size_t first = static_cast<std::size_t>(row * horizontal_ + column) * n;
+                for (int i = 0; i < n; i++) {
+                    sampler.Sample(column, row, i, x, y);
+                    colours[first + i] = world.ColourAt(RayThrough(column + x, row + y),
+                        world.MaxDepth());
+                }
+            }
+        }
+    };
+    threads = std::max(1, std::min(threads, vertical_));
+    std::vector<std::future<void>> bands {};
+    for (int t = 1; t < threads; t++) {
+        bands.push_back(std::async(std::launch::async, trace,
+            vertical_ * t / threads, vertical_ * (t + 1) / threads));
+    }
+    trace(0, vertical_ / threads);
+    for (auto& band: bands) {
+        band.get();
+    }
+
+    // Add the samples in the same order whatever the number of threads
+    FilteredSums sums { sampler, horizontal_, vertical_ };
+    double x, y;
+    for (int row = 0; row < vertical_; row++) {
+        for (int column = 0; column < horizontal_; column++) {
+            std::size_t first = static_cast<std::size_t>(row * horizontal_ + column) * n;
+            for (int i = 0; i < n; i++) {
+                sampler.Sample(column, row, i, x, y);
+                sums.Add(column, row, x, y, colours[first + i]);
+            }
+        }
+    }
+    return sums.Image();
+}
+
+const int Camera::kConvergenceTileSize = 4;
+const int Camera::kMinConvergenceSamples = 8;
+const int Camera::kConvergenceBatch = 4;
+
+// The brightness of a colour as the eye sees it (Rec. 709 luminance)
+static double Luminance(Colour c) {
+    return 0.2126 * c.Red() + 0.7152 * c.Green() + 0.0722 * c.Blue();
+}
+
+// Identifies the camera and the placement of the samples, which must be the
+// same to carry on from a saved ConvergenceState (an FNV-1a hash)
+static std::uint64_t ConvergenceKey(const Matrix& transform, double field_of_view,
+        const PixelSampler& sampler) {
+    std::uint64_t hash { 14695981039346656037ULL };
+    auto add = [&hash](const void* data, std::size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 1099511628211ULL;
+        }
+    };
+    for (int row = 0; row < 4; row++) {
+        for (int column = 0; column < 4; column++) {
+            double entry = transform.At(row, column);
+            add(&entry, sizeof(entry));
+        }
+    }
+    // the stratified patterns depend on the number of samples
+    std::int32_t settings[5] { Camera::kConvergenceTileSize, sampler.Samples(),
+        static_cast<std::int32_t>(sampler.Pattern()), static_cast<std::int32_t>(sampler.Filter()),
+        static_cast<std::int32_t>(sampler.Seed()) };
+    add(&field_of_view, sizeof(field_of_view));
+    add(settings, sizeof(settings));
+    return hash;
+}
+
+const Canvas Camera::RenderConverged(const World& world, const PixelSampler& sampler,
+    double threshold, double time_budget, int threads, std::vector<int>* samples,
+    CheckpointWriter* checkpoints) const {
+    auto start = std::chrono::steady_clock::now();
+    int tile_columns = (horizontal_ + kConvergenceTileSize - 1) / kConvergenceTileSize,
+        tile_rows = (vertical_ + kConvergenceTileSize - 1) / kConvergenceTileSize,
+        tiles = tile_columns * tile_rows,
+        pixels = horizontal_ * vertical_;
+    // the samples taken so far, the running mean of the luminance of each
+    // pixel's samples and the sum of squared differences from it (Welford's
+    // method), carried on from the checkpoint if it has the same camera and
+    // sampling
+    ConvergenceState state {};
+    FilteredSums sums { sampler, horizontal_, vertical_ };
+    std::uint64_t key = ConvergenceKey(transform_, field_of_view_, sampler);
+    if (checkpoints != nullptr && checkpoints->Resume(state) && state.key == key &&
+            state.width == horizontal_ && state.height == vertical_ &&
+            static_cast<int>(state.taken.size()) == tiles &&
+            std::all_of(state.taken.begin(), state.taken.end(),
+                [&sampler](std::int32_t n) { return n >= 0 && n <= sampler.Samples(); })) {
+        sums.Sums().swap(state.sums);
+        sums.Weights().swap(state.weights);
+    }
+    else {
+        state.key = key;
+        state.width = horizontal_;
+        state.height = vertical_;
+        state.taken.assign(tiles, 0);
+        state.means.assign(pixels, 0.0);
+        state.squares.assign(pixels, 0.0);
+    }
+    std::vector<std::int32_t>& taken = state.taken;
+    // the samples each pixel of each tile takes in this round
+    std::vector<int> batch(tiles, 0);
+
+    // Calls f(column, row) for each pixel of the tile
+    auto for_each_pixel = [&](int tile, auto f) {
+        int first_column = (tile % tile_columns) * kConvergenceTileSize,
+            first_row = (tile / tile_columns) * kConvergenceTileSize,
+            last_column = std::min(horizontal_, first_column + kConvergenceTileSize),
+            last_row = std::min(vertical_, first_row + kConvergenceTileSize);
+        for (int row = first_row; row < last_row; row++) {
+            for (int column = first_column; column < last_column; column++) {
+                f(column, row);
+            }
+        }
+    };
+    // Calls f(column, row, index, k) for each sample the tile takes in this
+    // round, where k counts the samples of the tile
+    auto for_each_sample = [&](int tile, auto f) {
+        int k { 0 };
+        for_each_pixel(tile, [&](int column, int row) {
+            for (int i = taken[tile]; i < taken[tile] + batch[tile]; i++) {
+                f(column, row, i, k++);
+            }
+        });
+    };
+    // A tile is done when it has all its samples, or the mean luminance of
+    // each of its pixels is certain enough: the half-width of its 95%
+    // confidence interval is at most the threshold
+    auto done = [&](int tile) {
+        int n = taken[tile];
+        if (n >= sampler.Samples()) {
+            return true;
+        }
+        bool converged = n > 1;
+        for_each_pixel(tile, [&](int column, int row) {
+            double variance = state.squares[row * horizontal_ + column] / (n - 1);
+            converged = converged && 1.96 * std::sqrt(variance / n) <= threshold;
+        });
+        return converged;
+    };
+
+    // Each round, the tiles that aren't done take a few more samples per
+    // pixel, stored after those of the tiles before them
+    std::vector<int> active {}, offsets {};
+    for (int tile = 0; tile < tiles; tile++) {
+        if (!done(tile)) {
+            active.push_back(tile);
+        }
+    }
+    std::vector<Colour> colours {};
+    auto trace = [&](std::size_t first, std::size_t last) {
+        double x, y;
+        for (std::size_t a = first; a < last; a++) {
+            for_each_sample(active[a], [&](int column, int row, int i, int k) {
+                sampler.Sample(column, row, i, x, y);
+                colours[offsets[a] + k] = world.ColourAt(RayThrough(column + x, row + y),
+                    world.MaxDepth());
+            });
+        }
+    };
+
+    while (!active.empty()) {
+        offsets.assign(active.size() + 1, 0);
+        for (std::size_t a = 0; a < active.size(); a++) {
+            int tile = active[a],
+                width = std::min(kConvergenceTileSize,
+                    horizontal_ - (tile % tile_columns) * kConvergenceTileSize),
+                height = std::min(kConvergenceTileSize,
+                    vertical_ - (tile / tile_columns) * kConvergenceTileSize);
+            batch[tile] = std::min((taken[tile] == 0) ? kMinConvergenceSamples : kConvergenceBatch,
+                sampler.Samples() - taken[tile]);
+            offsets[a + 1] = offsets[a] + width * height * batch[tile];
+        }
+        colours.resize(offsets.back());
+        int bands = std::max(1, std::min(threads, static_cast<int>(active.size())));
+        std::vector<std::future<void>> futures {};
+        for (int t = 1; t < bands; t++) {
+            futures.push_back(std::async(std::launch::async, trace,
+                active.size() * t / bands, active.size() * (t + 1) / bands));
+        }
+        trace(0, active.size() / bands);
+        for (auto& future: futures) {
+            future.get();
+        }
+
+        // Add the samples in the same order whatever the number of threads,
+        // then keep the tiles that aren't done
+        std::vector<int> next {};
+        double x, y;
+        for (std::size_t a = 0; a < active.size(); a++) {
+            int tile = active[a];
+            for_each_sample(tile, [&](int column, int row, int i, int k) {
+                Colour colour = colours[offsets[a] + k];
+                sampler.Sample(column, row, i, x, y);
+                sums.Add(column, row, x, y, colour);
+                int pixel = row * horizontal_ + column;
+                double luminance = Luminance(colour), delta = luminance - state.means[pixel];
+                state.means[pixel] += delta / (i + 1);
+                state.squares[pixel] += delta * (luminance - state.means[pixel]);
+            });
+            taken[tile] += batch[tile];
+            if (!done(tile)) {
+                next.push_back(tile);
+            }
+        }
+        active.swap(next);
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        bool stop = time_budget > 0 && elapsed.count() >= time_budget;
+        // Save a copy of the progress at intervals, and when stopping
+        if (checkpoints != nullptr && (active.empty() || stop || checkpoints->Due())) {
+            ConvergenceState copy { state };
+            copy.sums = sums.Sums();
+            copy.weights = sums.Weights();
+            checkpoints->Write(std::move(copy));
+        }
+        if (stop) {
+            break;
+        }
+    }
+
+    if (samples != nullptr) {
+        samples->assign(pixels, 0);
+        for (int pixel = 0; pixel < pixels; pixel++) {
+            int column = pixel % horizontal_, row = pixel / horizontal_;
+            (*samples)[pixel] = taken[(row / kConvergenceTileSize) * tile_columns +
+                column / kConvergenceTileSize];
+        }
+    }
+    return sums.Image();
+}
+
+// The distance between the pixels traced in each pass of
+// RenderProgressive(), in rows and columns; each divides the one before it
+static const int kProgressiveStrides[] { 4, 2, 1 };
+
+// Sets each pixel that hasn't been traced to the colour of the traced pixel
+// at the top left of the smallest block of a progressive pass containing it
+static const Canvas FillUntraced(const Canvas& image, const std::vector<char>& traced) {
+    Canvas filled { image };
+    int width = image.Width();
+    for (int row = 0; row < image.Height(); row++) {
+        for (int column = 0; column < width; column++) {
+            if (traced[row * width + column]) {
+                continue;
+            }
+            for (int stride: kProgressiveStrides) {
+                int r = row - row % stride, c = column - column % stride;
+                if (traced[r * width + c]) {
+                    filled[row][column] = image.At(r, c);
+                }
+            }
+        }
+    }
+    return filled;
+}
+
+const Canvas Camera::RenderProgressive(const World& world, double time_budget,
+    const PreviewCallback& preview, int threads) const {
+    auto start = std::chrono::steady_clock::now();
+    Canvas image { horizontal_, vertical_ };
+    // not std::vector<bool>, whose elements can't be set from different threads
+    std::vector<char> traced(horizontal_ * vertical_, 0);
+    std::atomic<bool> stopped { false };
+    int pass { 0 }, previous { 0 };
+    threads = std::max(1, threads);
+    for (int stride: kProgressiveStrides) {
+        pass++;
+        // Each thread traces every threads-th row of the pass, skipping the
+        // pixels traced by the pass before
+        auto trace = [&](int first) {
+            for (int row = first * stride; row < vertical_; row += threads * stride) {
+                std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+                if (stopped || (time_budget > 0 && elapsed.count() >= time_budget)) {
+                    stopped = true;
+                    return;
+                }
+                for (int column = 0; column < horizontal_; column += stride) {
+                    if (previous > 0 && row % previous == 0 && column % previous == 0) {
+                        continue;
+                    }
+                    image[row][column] = world.ColourAt(RayAt(column, row), world.MaxDepth());
+                    traced[row * horizontal_ + column] = 1;
+                }
+            }
+        };
+        std::vector<std::future<void>> bands {};
+        for (int t = 1; t < threads; t++) {
+            bands.push_back(std::async(std::launch::async, trace, t));
+        }
+        trace(0);
+        for (auto& band: bands) {
+            band.get();
+        }
+
+        if (stopped) {
+            break;
+        }
+        previous = stride;
+        if (preview && stride > 1) {
+            preview(FillUntraced(image, traced), pass);
+        }
+    }
+    Canvas result = stopped ? FillUntraced(image, traced) : image;
+    if (preview) {
+        preview(result, pass);
+    }
+    return result;
+}
+
+// The number of pixels traced in each wavefront: enough that each stage
+// has plenty of rays to trace in packets, while the queues stay small
+static const int kWavefrontBatchSize { 4096 };
+
+const Canvas Camera::RenderWavefront(const World& world, bool sort_secondary) const {
+    Canvas image { horizontal_, vertical_ };
+    Wavefront wavefront { sort_secondary };
+    std::vector<Colour> colours(kWavefrontBatchSize);
+    int pixels = horizontal_ * vertical_;
+    for (int first = 0; first < pixels; first += kWavefrontBatchSize) {
+        int size = std::min(kWavefrontBatchSize, pixels - first);
+        for (int slot = 0; slot < size; slot++) {
+            int pixel = first + slot;
+            colours[slot] = Colour::kBlack;
+            wavefront.primary.emplace_back(RayAt(pixel % horizontal_, pixel / horizontal_),
+                slot, 1.0, world.MaxDepth());
+        }
+        world.ColourAt(wavefront, colours.data());
+        for (int slot = 0; slot < size; slot++) {
+            int pixel = first + slot;
+            image[pixel / horizontal_][pixel % horizontal_] = colours[slot];
+        }
+    }
+    return image;
+}
+
 const Canvas Camera::RenderConcurrent(const World& world) const {
     std::future<Colour>** projection = new std::future<Colour>*[vertical_];
     Canvas image { horizontal_, vertical_ };
@@ -73,7 +664,7 @@ const Canvas Camera::RenderConcurrent(const World& world) const {
                 projection[row][column] = std::async(std::launch::async,
                     [&world, this, row, column] () {
                         Ray ray = RayAt(column, row);
-                        return world.ColourAt(ray);
+                        return world.ColourAt(ray, world.MaxDepth());
                     }
                 );
             }
@@ -100,4 +100,23 @@ std::ostream& operator<<(std::ostream& os, const PPMv3& ppm) {
         os << std::endl; // End of row
     }
     return os;
+}
+
+const std::string PPMv6::kVersion = "P6";
+
+std::ostream& operator<<(std::ostream& os, const PPMv6& ppm) {
+    PPMv3 levels { ppm.canvas_ };
+    os << ppm.kVersion << '\n' << ppm.canvas_.Width() << " " << ppm.canvas_.Height() << '\n'
+        << PPMv3::kMaxColourDefault << '\n';
+    std::string row(3 * ppm.canvas_.Width(), '\0');
+    for (int i = 0; i < ppm.canvas_.Height(); i++) {
+        for (int j = 0; j < ppm.canvas_.Width(); j++) {
+            Colour pixel = ppm.canvas_.At(i, j);
+            row[3 * j] = static_cast<char>(levels.normalize(pixel.Red()));
+            row[3 * j + 1] = static_cast<char>(levels.normalize(pixel.Green()));
+            row[3 * j + 2] = static_cast<char>(levels.normalize(pixel.Blue()));
+        }
+        os.write(row.data(), row.size());
+    }
+    return os;
 }
\ No newline at end of file
@@ -0,0 +1,165 @@
+#include <cstdio>    // for rename
+#include <cstring>   // for memcmp, memcpy
+#include <fstream>
+#include <iterator>
+#include "checkpoint.h"
+
+static const char kCheckpointMagic[8] { 'R', 'T', 'C', 'K', 'P', '0', '0', '1' };
+
+template <typename T>
+static void WriteArray(std::ostream& os, const T* data, std::size_t size) {
+    os.write(reinterpret_cast<const char*>(data), size * sizeof(T));
+}
+
+void ConvergenceState::Save(std::ostream& os) const {
+    std::int32_t header[3] { width, height, static_cast<std::int32_t>(taken.size()) };
+    os.write(kCheckpointMagic, sizeof(kCheckpointMagic));
+    WriteArray(os, &key, 1);
+    WriteArray(os, header, 3);
+    WriteArray(os, taken.data(), taken.size());
+    WriteArray(os, means.data(), means.size());
+    WriteArray(os, squares.data(), squares.size());
+    std::vector<double> components {};
+    components.reserve(3 * sums.size());
+    for (Colour c: sums) {
+        components.push_back(c.Red());
+        components.push_back(c.Green());
+        components.push_back(c.Blue());
+    }
+    WriteArray(os, components.data(), components.size());
+    WriteArray(os, weights.data(), weights.size());
+}
+
+bool ConvergenceState::Load(std::istream& is) {
+    std::vector<char> buffer { std::istreambuf_iterator<char>(is),
+        std::istreambuf_iterator<char>() };
+    std::size_t header_size = sizeof(kCheckpointMagic) + sizeof(std::uint64_t) +
+        3 * sizeof(std::int32_t);
+    if (buffer.size() < header_size ||
+            memcmp(buffer.data(), kCheckpointMagic, sizeof(kCheckpointMagic)) != 0) {
+        return false;
+    }
+    const char* next = buffer.data() + sizeof(kCheckpointMagic);
+    std::uint64_t saved_key {};
+    std::int32_t header[3] {};
+    memcpy(&saved_key, next, sizeof(saved_key));
+    memcpy(header, next + sizeof(saved_key), sizeof(header));
+    next += sizeof(saved_key) + sizeof(header);
+    if (header[0] < 0 || header[1] < 0 || header[2] < 0) {
+        return false;
+    }
+    std::size_t pixels = static_cast<std::size_t>(header[0]) * header[1],
+                tiles = static_cast<std::size_t>(header[2]);
+    if (buffer.size() != header_size + tiles * sizeof(std::int32_t) +
+            pixels * 6 * sizeof(double)) {
+        return false;
+    }
+
+    // a count of samples can't be negative
+    for (std::size_t tile = 0; tile < tiles; tile++) {
+        std::int32_t count {};
+        memcpy(&count, next + tile * sizeof(count), sizeof(count));
+        if (count < 0) {
+            return false;
+        }
+    }
+
+    key = saved_key;
+    width = header[0];
+    height = header[1];
+    auto read = [&next](auto& array, std::size_t size) {
+        array.resize(size);
+        memcpy(array.data(), next, size * sizeof(array[0]));
+        next += size * sizeof(array[0]);
+    };
+    read(taken, tiles);
+    read(means, pixels);
+    read(squares, pixels);
+    std::vector<double> components {};
+    read(components, 3 * pixels);
+    sums.clear();
+    for (std::size_t pixel = 0; pixel < pixels; pixel++) {
+        sums.emplace_back(components[3 * pixel], components[3 * pixel + 1],
+            components[3 * pixel + 2]);
+    }
+    read(weights, pixels);
+    return true;
+}
+
+CheckpointWriter::CheckpointWriter(const std::string& path, double interval): path_ { path },
+        interval_ { interval }, last_ { std::chrono::steady_clock::now() }, mutex_ {},
+        changed_ {}, pending_ {}, has_pending_ { false }, writing_ { false },
+        stopping_ { false }, written_ { 0 }, thread_ { &CheckpointWriter::Run, this } {}
+
+CheckpointWriter::~CheckpointWriter() {
+    {
+        std::lock_guard<std::mutex> lock { mutex_ };
+        stopping_ = true;
+    }
+    changed_.notify_all();
+    thread_.join();
+}
+
+bool CheckpointWriter::Due() const {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - last_;
+    return elapsed.count() >= interval_;
+}
+
+void CheckpointWriter::Write(ConvergenceState&& state) {
+    {
+        std::lock_guard<std::mutex> lock { mutex_ };
+        pending_ = std::move(state);
+        has_pending_ = true;
+    }
+    last_ = std::chrono::steady_clock::now();
+    changed_.notify_all();
+}
+
+void CheckpointWriter::Flush() {
+    std::unique_lock<std::mutex> lock { mutex_ };
+    changed_.wait(lock, [this] { return !has_pending_ && !writing_; });
+}
+
+int CheckpointWriter::Written() const {
+    std::lock_guard<std::mutex> lock { mutex_ };
+    return written_;
+}
+
+bool CheckpointWriter::Resume(ConvergenceState& state) const {
+    std::ifstream in { path_, std::ios::binary };
+    return in && state.Load(in);
+}
+
+void CheckpointWriter::Run() {
+    std::unique_lock<std::mutex> lock { mutex_ };
+    while (true) {
+        changed_.wait(lock, [this] { return has_pending_ || stopping_; });
+        if (!has_pending_) {
+            return;
+        }
+        ConvergenceState state { std::move(pending_) };
+        has_pending_ = false;
+        writing_ = true;
+        lock.unlock();
+
+        std::string temporary = path_ + ".tmp";
+        bool saved { false };
+        {
+            std::ofstream out { temporary, std::ios::binary | std::ios::trunc };
+            if (out) {
+                state.Save(out);
+                out.close();
+                saved = !out.fail();
+            }
+        }
+        saved = saved && std::rename(temporary.c_str(), path_.c_str()) == 0;
+        if (!saved) {
+            std::cerr << "Couldn't write checkpoint to " << path_ << std::endl;
+        }
+
+        lock.lock();
+        writing_ = false;
+        written_ += saved ? 1 : 0;
+        changed_.notify_all();
+    }
+}
\ No newline at end of file
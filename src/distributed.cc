@@ -0,0 +1,316 @@
+#include <algorithm> // for find, min
+#include <cerrno>
+#include <cstdint>
+#include <cstring>   // for strncpy
+#include <deque>
+#include <iostream>
+#include <stdexcept>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "distributed.h"
+
+struct TileAssignment {
+    std::int32_t id;
+    std::int32_t column;
+    std::int32_t row;
+    std::int32_t width;
+    std::int32_t height;
+};
+
+static const std::int32_t kNoTile { -1 };
+
+// send() is told not to raise SIGPIPE, which would otherwise kill the
+// process when a peer has gone
+bool SendAll(int socket, const void* data, std::size_t size) {
+    const char* next = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t sent = send(socket, next, size, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            return false;
+        }
+        next += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+bool ReceiveAll(int socket, void* data, std::size_t size) {
+    char* next = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t received = recv(socket, next, size, 0);
+        if (received <= 0) {
+            return false;
+        }
+        next += received;
+        size -= received;
+    }
+    return true;
+}
+
+const Canvas CoordinateWorkers(const std::vector<int>& sockets, int width, int height,
+        int tile_size) {
+    std::deque<TileAssignment> waiting {};
+    std::int32_t id { 0 };
+    for (int row = 0; row < height; row += tile_size) {
+        for (int column = 0; column < width; column += tile_size) {
+            waiting.push_back(TileAssignment { id++, column, row,
+                std::min(tile_size, width - column), std::min(tile_size, height - row) });
+        }
+    }
+    std::size_t remaining = waiting.size();
+
+    Canvas image { width, height };
+    // the tile each worker is rendering, if any, and the workers waiting
+    // for one
+    std::vector<TileAssignment> assigned(sockets.size(), TileAssignment { kNoTile, 0, 0, 0, 0 });
+    std::vector<bool> connected(sockets.size(), true);
+    std::vector<std::size_t> idle {};
+    std::vector<double> pixels {};
+
+    auto disconnect = [&](std::size_t w) {
+        connected[w] = false;
+        close(sockets[w]);
+        if (assigned[w].id != kNoTile) {
+            waiting.push_front(assigned[w]);
+            assigned[w].id = kNoTile;
+        }
+    };
+    auto assign = [&](std::size_t w) {
+        assigned[w] = waiting.front();
+        waiting.pop_front();
+        if (!SendAll(sockets[w], &assigned[w], sizeof(TileAssignment))) {
+            disconnect(w);
+        }
+    };
+
+    while (remaining > 0) {
+        // hand out tiles given back by workers that disconnected
+        while (!waiting.empty() && !idle.empty()) {
+            std::size_t w = idle.back();
+            idle.pop_back();
+            assign(w);
+        }
+
+        std::vector<pollfd> polled {};
+        std::vector<std::size_t> workers {};
+        for (std::size_t w = 0; w < sockets.size(); w++) {
+            if (connected[w] && std::find(idle.begin(), idle.end(), w) == idle.end()) {
+                polled.push_back(pollfd { sockets[w], POLLIN, 0 });
+                workers.push_back(w);
+            }
+        }
+        if (polled.empty()) {
+            throw std::runtime_error("Every worker disconnected before the image was finished");
+        }
+        if (poll(polled.data(), polled.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // disconnecting the workers lets them finish
+            for (std::size_t w = 0; w < sockets.size(); w++) {
+                if (connected[w]) {
+                    disconnect(w);
+                }
+            }
+            throw std::runtime_error("Couldn't wait for the workers");
+        }
+
+        for (std::size_t p = 0; p < polled.size(); p++) {
+            if (polled[p].revents == 0) {
+                continue;
+            }
+            std::size_t w = workers[p];
+            std::int32_t finished {};
+            if (!ReceiveAll(sockets[w], &finished, sizeof(finished))) {
+                disconnect(w);
+                continue;
+            }
+            if (finished != kNoTile) {
+                TileAssignment tile = assigned[w];
+                if (finished != tile.id) {
+                    disconnect(w);
+                    continue;
+                }
+                pixels.resize(3 * tile.width * tile.height);
+                if (!ReceiveAll(sockets[w], pixels.data(), pixels.size() * sizeof(double))) {
+                    disconnect(w);
+                    continue;
+                }
+                for (int r = 0; r < tile.height; r++) {
+                    for (int c = 0; c < tile.width; c++) {
+                        const double* rgb = &pixels[3 * (r * tile.width + c)];
+                        image[tile.row + r][tile.column + c] = Colour { rgb[0], rgb[1], rgb[2] };
+                    }
+                }
+                assigned[w].id = kNoTile;
+                remaining--;
+            }
+            if (!waiting.empty()) {
+                assign(w);
+            }
+            else {
+                idle.push_back(w);
+            }
+        }
+    }
+
+    // tell the workers the image is finished
+    TileAssignment finished { kNoTile, 0, 0, 0, 0 };
+    for (std::size_t w = 0; w < sockets.size(); w++) {
+        if (connected[w]) {
+            SendAll(sockets[w], &finished, sizeof(finished));
+            close(sockets[w]);
+        }
+    }
+    return image;
+}
+
+void RunWorker(int socket, const World& world, const Camera& camera) {
+    std::int32_t finished { kNoTile };
+    std::vector<double> pixels {};
+    if (!SendAll(socket, &finished, sizeof(finished))) {
+        return;
+    }
+    TileAssignment tile {};
+    while (ReceiveAll(socket, &tile, sizeof(tile)) && tile.id != kNoTile) {
+        Canvas region = camera.RenderRegion(world, tile.column, tile.row, tile.width,
+            tile.height);
+        pixels.clear();
+        for (int r = 0; r < tile.height; r++) {
+            for (int c = 0; c < tile.width; c++) {
+                Colour colour = region.At(r, c);
+                pixels.push_back(colour.Red());
+                pixels.push_back(colour.Green());
+                pixels.push_back(colour.Blue());
+            }
+        }
+        if (!SendAll(socket, &tile.id, sizeof(tile.id)) ||
+                !SendAll(socket, pixels.data(), pixels.size() * sizeof(double))) {
+            return;
+        }
+    }
+}
+
+// Reaps the worker processes, reporting any that failed; the coordinator
+// has already given their tiles to the others
+static void WaitForWorkers(const std::vector<pid_t>& children) {
+    for (pid_t child: children) {
+        int status { 0 };
+        if (waitpid(child, &status, 0) == child &&
+                !(WIFEXITED(status) && WEXITSTATUS(status) == 0)) {
+            std::cerr << "Worker process " << child << " failed" << std::endl;
+        }
+    }
+}
+
+const Canvas RenderWithWorkers(const World& world, const Camera& camera, int workers,
+        int tile_size) {
+    std::vector<int> sockets {};
+    std::vector<pid_t> children {};
+    for (int w = 0; w < workers; w++) {
+        int pair[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+            break;
+        }
+        pid_t child = fork();
+        if (child == 0) {
+            // the worker keeps only its own end of its own socket
+            close(pair[0]);
+            for (int s: sockets) {
+                close(s);
+            }
+            // an exception mustn't unwind into the parent's code, which
+            // would run its handlers and destructors a second time
+            try {
+                RunWorker(pair[1], world, camera);
+            }
+            catch (...) {
+                _exit(1);
+            }
+            close(pair[1]);
+            _exit(0);
+        }
+        close(pair[1]);
+        if (child < 0) {
+            close(pair[0]);
+            break;
+        }
+        sockets.push_back(pair[0]);
+        children.push_back(child);
+    }
+    if (sockets.empty()) {
+        throw std::runtime_error("Couldn't start any workers");
+    }
+
+    try {
+        Canvas image = CoordinateWorkers(sockets, camera.Horizontal(), camera.Vertical(),
+            tile_size);
+        WaitForWorkers(children);
+        return image;
+    }
+    catch (...) {
+        WaitForWorkers(children);
+        throw;
+    }
+}
+
+static sockaddr_un SocketAddress(const std::string& path) {
+    sockaddr_un address {};
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("Socket path is too long: " + path);
+    }
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    return address;
+}
+
+int ListenAt(const std::string& path, int backlog) {
+    sockaddr_un address = SocketAddress(path);
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr*>(&address),
+            sizeof(address)) != 0 || listen(listener, backlog) != 0) {
+        if (listener >= 0) {
+            close(listener);
+        }
+        throw std::runtime_error("Couldn't listen at " + path);
+    }
+    return listener;
+}
+
+int ConnectTo(const std::string& path) {
+    sockaddr_un address = SocketAddress(path);
+    int connection = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (connection < 0 || connect(connection, reinterpret_cast<sockaddr*>(&address),
+            sizeof(address)) != 0) {
+        if (connection >= 0) {
+            close(connection);
+        }
+        throw std::runtime_error("Couldn't connect to " + path);
+    }
+    return connection;
+}
+
+std::vector<int> AcceptWorkers(const std::string& path, int count) {
+    int listener = ListenAt(path, count);
+    std::vector<int> sockets {};
+    while (static_cast<int>(sockets.size()) < count) {
+        int worker = accept(listener, nullptr, nullptr);
+        if (worker >= 0) {
+            sockets.push_back(worker);
+        }
+        else if (errno != EINTR) {
+            for (int s: sockets) {
+                close(s);
+            }
+            close(listener);
+            unlink(path.c_str());
+            throw std::runtime_error("Couldn't accept workers at " + path);
+        }
+    }
+    close(listener);
+    unlink(path.c_str());
+    return sockets;
+}
\ No newline at end of file
@@ -0,0 +1,150 @@
+#include <algorithm> // for min, max, fill
+#include <atomic>
+#include <cmath>     // for cbrt, floor, round
+#include "grid.h"
+
+const double UniformGrid::kDensity = 3.0;
+const int UniformGrid::kMaxResolution = 128;
+
+static std::atomic<std::uint64_t> builds { 0 };
+
+// Each thread's record of the last ray that tested each shape of the grid it
+// last traced, so that a shape overlapping many cells is tested once per ray
+// without clearing a buffer for every ray
+struct Mailboxes {
+    std::uint64_t build;
+    std::uint32_t ray;
+    std::vector<std::uint32_t> last_ray;
+};
+
+static thread_local Mailboxes mailboxes { 0, 0, {} };
+
+int UniformGrid::CellCoordinate(double coordinate, int axis) const {
+    int cell = static_cast<int>(std::floor((coordinate - bounds_.Min().At(axis)) / cell_size_[axis]));
+    return std::min(std::max(cell, 0), resolution_[axis] - 1);
+}
+
+void UniformGrid::BuildStructure() {
+    cells_.clear();
+    build_ = ++builds;
+    resolution_ = { 1, 1, 1 };
+    if (shapes_.empty()) {
+        return;
+    }
+
+    // Pad flat bounds (e.g., a single sheet) so that every cell has a volume
+    Point min = bounds_.Min(),
+          max = bounds_.Max();
+    for (auto axis: BoundingBox::kIndices) {
+        if (max[axis] - min[axis] < kEpsilon) {
+            min[axis] -= kEpsilon;
+            max[axis] += kEpsilon;
+        }
+    }
+    bounds_ = BoundingBox { min, max };
+
+    // Choose roughly cubic cells so that there are about kDensity cells for
+    // each primitive: dense scenes get finer grids
+    double volume { 1.0 };
+    for (auto axis: BoundingBox::kIndices) {
+        volume *= max[axis] - min[axis];
+    }
+    double cells_per_unit = std::cbrt(kDensity * shapes_.size() / volume);
+    for (auto axis: BoundingBox::kIndices) {
+        double extent = max[axis] - min[axis];
+        int resolution = static_cast<int>(std::round(extent * cells_per_unit));
+        resolution_[axis] = std::min(std::max(resolution, 1), kMaxResolution);
+        cell_size_[axis] = extent / resolution_[axis];
+    }
+
+    cells_.resize(resolution_[0] * resolution_[1] * resolution_[2]);
+    for (std::size_t index = 0; index < shapes_.size(); index++) {
+        BoundingBox box = shapes_[index]->BoundsOfInParentSpace();
+        std::array<int, 3> low {}, high {};
+        for (auto axis: BoundingBox::kIndices) {
+            low[axis] = CellCoordinate(box.Min().At(axis), axis);
+            high[axis] = CellCoordinate(box.Max().At(axis), axis);
+        }
+        for (int z = low[2]; z <= high[2]; z++) {
+            for (int y = low[1]; y <= high[1]; y++) {
+                for (int x = low[0]; x <= high[0]; x++) {
+                    cells_[CellIndex(x, y, z)].push_back(index);
+                }
+            }
+        }
+    }
+}
+
+bool UniformGrid::Intersect(IntersectionList& list, const Ray& ray) const {
+    bool intersected = IntersectUnbounded(list, ray);
+
+    double tmin { -kBBInfinity }, tmax { kBBInfinity };
+    if (cells_.empty() || !bounds_.Intersects(ray, tmin, tmax)) {
+        return intersected;
+    }
+
+    // Find the cell where the ray enters the grid, then for each axis the
+    // distance to the next cell boundary (next) and the distance between
+    // boundaries (delta)
+    Point origin = ray.Origin(),
+          min = bounds_.Min();
+    Vector direction = ray.Direction();
+    std::array<int, 3> cell {}, step {};
+    std::array<double, 3> next {}, delta {};
+    for (auto axis: BoundingBox::kIndices) {
+        double d = direction.At(axis),
+               entry = origin.At(axis) + d * tmin;
+        cell[axis] = CellCoordinate(entry, axis);
+        if (d > 0) {
+            step[axis] = 1;
+            next[axis] = tmin + (min[axis] + (cell[axis] + 1) * cell_size_[axis] - entry) / d;
+            delta[axis] = cell_size_[axis] / d;
+        }
+        else if (d < 0) {
+            step[axis] = -1;
+            next[axis] = tmin + (min[axis] + cell[axis] * cell_size_[axis] - entry) / d;
+            delta[axis] = -cell_size_[axis] / d;
+        }
+        else {
+            step[axis] = 0;
+            next[axis] = kBBInfinity;
+            delta[axis] = kBBInfinity;
+        }
+    }
+
+    // A shape may overlap many cells: test it only once per ray
+    if (mailboxes.build != build_) {
+        mailboxes.build = build_;
+        mailboxes.ray = 0;
+        mailboxes.last_ray.assign(shapes_.size(), 0);
+    }
+    if (++mailboxes.ray == 0) {
+        std::fill(mailboxes.last_ray.begin(), mailboxes.last_ray.end(), 0);
+        mailboxes.ray = 1;
+    }
+    std::uint32_t ray_id = mailboxes.ray;
+    std::vector<std::uint32_t>& last_ray = mailboxes.last_ray;
+    while (true) {
+        for (int index: cells_[CellIndex(cell[0], cell[1], cell[2])]) {
+            if (last_ray[index] != ray_id) {
+                last_ray[index] = ray_id;
+                if (IntersectShape(list, ray, shapes_[index])) {
+                    intersected = true;
+                }
+            }
+        }
+        // step into the neighbouring cell along the axis whose boundary is
+        // closest
+        int axis = (next[0] < next[1]) ? ((next[0] < next[2]) ? 0 : 2)
+            : ((next[1] < next[2]) ? 1 : 2);
+        if (next[axis] > tmax) {
+            break;
+        }
+        cell[axis] += step[axis];
+        if (cell[axis] < 0 || cell[axis] >= resolution_[axis]) {
+            break;
+        }
+        next[axis] += delta[axis];
+    }
+    return intersected;
+}
\ No newline at end of file
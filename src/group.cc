@@ -1,11 +1,35 @@
 #include <stdexcept>
+#include <cmath> // for isfinite
+#include <cstring> // for memcpy
+#include <fstream>
+#include <iterator>
+#include <typeinfo>
 #include "group.h"
 
+const double ShapeGroup::kTraversalCost = 1.0;
+const double ShapeGroup::kIntersectionCost = 1.0;
+const double ShapeGroup::kMaxRefitDegradation = 1.5;
+
+// Identifies a file containing a cached hierarchy (see DivideAndSave())
+static const char kHierarchyMagic[8] { 'R', 'T', 'B', 'V', 'H', '0', '0', '1' };
+// Marks the start of a subgroup in an encoded hierarchy
+static const std::int32_t kSubgroupMarker { -1 };
+
 void ShapeGroup::Add(Shape* s) {
     s->Parent(this);
     shapes_.push_back(s);
     // update parent bounding box after adding shape
     bbox_ = BoundsOf().Transform(transform_);
+    blocks_.Clear();
+}
+
+void ShapeGroup::Add(const std::vector<Shape*>& shapes) {
+    for (auto s: shapes) {
+        s->Parent(this);
+        shapes_.push_back(s);
+    }
+    bbox_ = BoundsOf().Transform(transform_);
+    blocks_.Clear();
 }
 
 ShapeGroup& ShapeGroup::operator<<(Shape *s) {
@@ -50,15 +74,23 @@ const std::array<std::vector<Shape *>, 2> ShapeGroup::Partition() {
     return partitions;
 }
 
-void ShapeGroup::AddSubgroup(std::vector<Shape *> shapes) {
-    // Creates a new subgroup and adds each shape to it, then adds the subgroup
-    // to the group
+ShapeGroup* ShapeGroup::NewSubgroup(const std::vector<Shape *>& shapes) {
+    // Creates a new subgroup owned by the group containing the given shapes,
+    // but doesn't add it to the group
     ShapeGroup* subgroup = new ShapeGroup();
     subgroups_.push_back(subgroup);
     for (auto s: shapes) {
-        subgroup->Add(s);
+        s->Parent(subgroup);
+        subgroup->shapes_.push_back(s);
     }
-    Add(subgroup);
+    subgroup->bbox_ = subgroup->BoundsOf().Transform(subgroup->transform_);
+    return subgroup;
+}
+
+void ShapeGroup::AddSubgroup(std::vector<Shape *> shapes) {
+    // Creates a new subgroup and adds each shape to it, then adds the subgroup
+    // to the group
+    Add(NewSubgroup(shapes));
 }
 
 Shape* ShapeGroup::operator[](int i) {
@@ -75,9 +107,29 @@ bool ShapeGroup::operator==(const Shape& s) const {
 
 bool ShapeGroup::Intersect(IntersectionList& list, const Ray& ray) const {
     bool intersected { false };
+    bool count = TraversalStatistics::Enabled();
+    if (count) {
+        TraversalStatistics::CountGroupVisit(this);
+    }
+    if (undivided_.load(std::memory_order_acquire)) {
+        // Divide the group the first time a ray enters it
+        if (!bbox_.Intersects(ray)) {
+            return false;
+        }
+        const_cast<ShapeGroup*>(this)->DivideOnDemand();
+    }
+    // Transforming the ray doesn't change the distance to a point along it,
+    // so groups entirely beyond the closest hit so far can be skipped
     Ray local_ray = ray.Transform(inverse_transform_);
-    if (BoundsOf().Intersects(local_ray)) {
+    double tmin { -kBBInfinity }, tmax = list.CullDistance();
+    if (BoundsOf().Intersects(local_ray, tmin, tmax)) {
+        if (blocks_.Built()) {
+            return blocks_.Intersect(list, local_ray);
+        }
         for (auto s: shapes_) {
+            if (count) {
+                TraversalStatistics::CountShapeTest(s);
+            }
             if (s->Intersect(list, local_ray)) {
                 intersected = true;
             }
@@ -86,6 +138,42 @@ bool ShapeGroup::Intersect(IntersectionList& list, const Ray& ray) const {
     return intersected;
 }
 
+LaneMask ShapeGroup::IntersectPacket(IntersectionList* lists, const RayPacket& packet,
+        LaneMask mask) const {
+    // Counting the traversal and dividing on demand are done per ray
+    if (TraversalStatistics::Enabled() || undivided_.load(std::memory_order_acquire)) {
+        return Shape::IntersectPacket(lists, packet, mask);
+    }
+    RayPacket local_packet = packet.Transform(inverse_transform_);
+    double tmin[kMaxPacketSize], tmax[kMaxPacketSize];
+    for (int lane = 0; lane < local_packet.Size(); lane++) {
+        tmin[lane] = -kBBInfinity;
+        tmax[lane] = lists[lane].CullDistance();
+    }
+    mask &= BoundsOf().Intersects(local_packet, tmin, tmax);
+    LaneMask intersected { 0 };
+    if (LaneCount(mask) == 1) {
+        // The other rays missed: the packet is no longer coherent, so follow
+        // the remaining ray on its own
+        int lane { 0 };
+        while (!(mask & (1u << lane))) {
+            lane++;
+        }
+        Ray local_ray = local_packet.At(lane);
+        for (auto s: shapes_) {
+            if (s->Intersect(lists[lane], local_ray)) {
+                intersected = mask;
+            }
+        }
+    }
+    else if (mask) {
+        for (auto s: shapes_) {
+            intersected |= s->IntersectPacket(lists, local_packet, mask);
+        }
+    }
+    return intersected;
+}
+
 Vector ShapeGroup::LocalNormalAt(const Point &object_point) const {
     throw std::runtime_error("Can't call LocalNormalAt() on a group!");
 }
@@ -102,6 +190,7 @@ void ShapeGroup::Divide(int threshold) {
     // The threshold indicates the minimum number of children a group can have
     // before it will be divided; a group with fewer children than the threshold
     // will not be split, but the children themselves may be
+    undivided_ = false;
     if (threshold <= Size()) {
         auto partitions = Partition();
         if (partitions[0].size() > 0) {
@@ -114,4 +203,411 @@ void ShapeGroup::Divide(int threshold) {
     for (auto s: shapes_) {
         s->Divide(threshold);
     }
+    threshold_ = threshold;
+    build_cost_ = Cost();
+    lazy_ = false;
+    blocks_.Build(shapes_);
+}
+
+bool ShapeGroup::IsSubgroup(const Shape* s) const {
+    // True if the shape is a subgroup created (and owned) by Divide()
+    for (auto g: subgroups_) {
+        if (g == s) {
+            return true;
+        }
+    }
+    return false;
+}
+
+double ShapeGroup::Cost() const {
+    // Surface area heuristic: the cost of traversing the group plus the cost
+    // of each child weighted by the probability that a ray hitting the group
+    // also hits the child, i.e., the ratio of their surface areas
+    double area = BoundsOf().SurfaceArea(),
+           cost = kTraversalCost;
+    for (auto s: shapes_) {
+        double child_cost { kIntersectionCost },
+               child_area = s->BoundsOfInParentSpace().SurfaceArea(),
+               probability { 1.0 };
+        if (s->IsGroup()) {
+            child_cost = static_cast<const ShapeGroup*>(s)->Cost();
+        }
+        if (std::isfinite(area) && area > 0 && std::isfinite(child_area)) {
+            probability = child_area / area;
+        }
+        cost += probability * child_cost;
+    }
+    return cost;
+}
+
+void ShapeGroup::RefitBounds() {
+    // Propagate the bounds of any transformed children up the hierarchy,
+    // deepest groups first, without changing its structure
+    for (auto s: shapes_) {
+        if (s->IsGroup()) {
+            static_cast<ShapeGroup*>(s)->RefitBounds();
+        }
+    }
+    bbox_ = BoundsOf().Transform(transform_);
+    // the blocks hold copies of the children's transforms
+    if (blocks_.Built()) {
+        blocks_.Build(shapes_);
+    }
+}
+
+void ShapeGroup::Collapse() {
+    // Undo Divide(): move the children of the subgroups back into this group
+    // and discard the subgroups
+    std::vector<Shape*> children {};
+    for (auto s: shapes_) {
+        if (s->IsGroup()) {
+            static_cast<ShapeGroup*>(s)->Collapse();
+        }
+        if (IsSubgroup(s)) {
+            ShapeGroup* group = static_cast<ShapeGroup*>(s);
+            for (auto child: group->shapes_) {
+                children.push_back(child);
+            }
+            group->shapes_.clear();
+        }
+        else {
+            children.push_back(s);
+        }
+    }
+    for (auto s: subgroups_) {
+        delete s;
+    }
+    subgroups_.clear();
+    shapes_.clear();
+    blocks_.Clear();
+    undivided_ = false;
+    // Re-parent the children directly rather than calling Add(), which
+    // recomputes the bounding box after every child
+    for (auto s: children) {
+        s->Parent(this);
+        shapes_.push_back(s);
+    }
+    bbox_ = BoundsOf().Transform(transform_);
+}
+
+bool ShapeGroup::Refit(double max_degradation) {
+    // Update the bounds of the hierarchy after its children have been
+    // transformed, e.g., between the frames of an animation; if the children
+    // have moved so much that the hierarchy's cost has degraded past the
+    // given factor, rebuild the hierarchy instead. Returns true if the
+    // hierarchy was rebuilt.
+    RefitBounds();
+    if (threshold_ > 0 && Cost() > build_cost_ * max_degradation) {
+        Collapse();
+        if (lazy_) {
+            DivideLazily(threshold_);
+        }
+        else {
+            Divide(threshold_);
+        }
+        return true;
+    }
+    return false;
+}
+
+std::size_t ShapeGroup::Memory() const {
+    return sizeof(ShapeGroup) + HeapMemory() +
+        (shapes_.capacity() + subgroups_.capacity()) * sizeof(Shape*) +
+        blocks_.Memory();
+}
+
+void ShapeGroup::CollectStatistics(HierarchyStatistics& stats, std::size_t depth) const {
+    if (stats.groups_by_depth.size() <= depth) {
+        stats.groups_by_depth.resize(depth + 1, 0);
+        stats.unsplit_by_depth.resize(depth + 1, 0);
+    }
+    stats.groups++;
+    stats.groups_by_depth[depth]++;
+    if (undivided_) {
+        stats.undivided++;
+    }
+    stats.memory += Memory();
+
+    std::size_t primitives { 0 };
+    bool leaf { true };
+    for (auto s: shapes_) {
+        if (s->IsGroup()) {
+            leaf = false;
+            static_cast<const ShapeGroup*>(s)->CollectStatistics(stats, depth + 1);
+        }
+        else {
+            primitives++;
+        }
+    }
+    stats.primitives += primitives;
+    if (leaf) {
+        stats.leaf_sizes[primitives]++;
+    }
+    else if (subgroups_.size() > 0) {
+        stats.unsplit_by_depth[depth] += primitives;
+    }
+}
+
+const HierarchyStatistics ShapeGroup::Statistics() const {
+    HierarchyStatistics stats {};
+    CollectStatistics(stats, 0);
+    stats.cost = Cost();
+    return stats;
+}
+
+std::ostream& operator<<(std::ostream& os, const HierarchyStatistics& stats) {
+    os << "groups: " << stats.groups << std::endl
+       << "primitives: " << stats.primitives << std::endl
+       << "SAH cost: " << stats.cost << std::endl
+       << "memory (bytes): " << stats.memory << std::endl
+       << "undivided groups: " << stats.undivided << std::endl
+       << "depth\tgroups\tunsplit" << std::endl;
+    for (std::size_t depth = 0; depth < stats.groups_by_depth.size(); depth++) {
+        os << depth << '\t' << stats.groups_by_depth[depth] << '\t'
+           << stats.unsplit_by_depth[depth] << std::endl;
+    }
+    os << "leaf size\tleaves" << std::endl;
+    for (auto& entry: stats.leaf_sizes) {
+        os << entry.first << "\t\t" << entry.second << std::endl;
+    }
+    return os;
+}
+
+// 64-bit FNV-1a hash, see http://www.isthe.com/chongo/tech/comp/fnv/
+static const std::uint64_t kFNVOffsetBasis { 14695981039346656037ULL };
+static const std::uint64_t kFNVPrime { 1099511628211ULL };
+
+static void HashBytes(std::uint64_t& hash, const void* data, std::size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= kFNVPrime;
+    }
+}
+
+static void HashDouble(std::uint64_t& hash, double d) {
+    HashBytes(hash, &d, sizeof(d));
+}
+
+std::uint64_t ShapeGroup::Hash(int threshold) const {
+    // Hash the type, transform and bounds of each child, in order: if any
+    // of them change, so would the hierarchy Divide() builds
+    std::uint64_t hash { kFNVOffsetBasis };
+    std::uint64_t size { shapes_.size() };
+    HashBytes(hash, &threshold, sizeof(threshold));
+    HashBytes(hash, &size, sizeof(size));
+    for (auto s: shapes_) {
+        const char* type = typeid(*s).name();
+        HashBytes(hash, type, strlen(type));
+        const Matrix& transform = s->Transform();
+        for (int row = 0; row < transform.Nrows(); row++) {
+            for (int column = 0; column < transform.Ncolumns(); column++) {
+                HashDouble(hash, transform.At(row, column));
+            }
+        }
+        BoundingBox box = s->BoundsOf();
+        for (auto index: BoundingBox::kIndices) {
+            HashDouble(hash, box.Min().At(index));
+            HashDouble(hash, box.Max().At(index));
+        }
+    }
+    return hash;
+}
+
+void ShapeGroup::Encode(std::vector<std::int32_t>& words,
+        const std::map<const Shape*, std::int32_t>& indices) const {
+    // Each group is written as the number of its children followed by an
+    // entry per child: either the index of the child in the undivided group,
+    // or a marker followed by the encoding of a subgroup
+    words.push_back(static_cast<std::int32_t>(shapes_.size()));
+    for (auto s: shapes_) {
+        if (IsSubgroup(s)) {
+            words.push_back(kSubgroupMarker);
+            static_cast<const ShapeGroup*>(s)->Encode(words, indices);
+        }
+        else {
+            words.push_back(indices.at(s));
+        }
+    }
+}
+
+static bool IsValidEncoding(const std::vector<std::int32_t>& words,
+        std::size_t& position, std::vector<bool>& used) {
+    // Checks that an encoding written by ShapeGroup::Encode() is complete and
+    // refers to each child of the undivided group exactly once
+    if (position >= words.size()) {
+        return false;
+    }
+    std::int32_t size = words[position++];
+    for (std::int32_t i = 0; i < size; i++) {
+        if (position >= words.size()) {
+            return false;
+        }
+        std::int32_t word = words[position++];
+        if (word == kSubgroupMarker) {
+            if (!IsValidEncoding(words, position, used)) {
+                return false;
+            }
+        }
+        else if (word >= 0 && static_cast<std::size_t>(word) < used.size() && !used[word]) {
+            used[word] = true;
+        }
+        else {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ShapeGroup::Decode(const std::vector<std::int32_t>& words, std::size_t& position,
+        const std::vector<Shape*>& primitives, int threshold) {
+    // Rebuilds the group from a valid encoding written by Encode()
+    std::int32_t size = words[position++];
+    for (std::int32_t i = 0; i < size; i++) {
+        std::int32_t word = words[position++];
+        if (word == kSubgroupMarker) {
+            ShapeGroup* subgroup = new ShapeGroup();
+            subgroups_.push_back(subgroup);
+            subgroup->Parent(this);
+            shapes_.push_back(subgroup);
+            subgroup->Decode(words, position, primitives, threshold);
+        }
+        else {
+            Shape* s = primitives[word];
+            s->Parent(this);
+            shapes_.push_back(s);
+            // nested groups that weren't created by Divide() are divided
+            // separately, as Divide() would have
+            s->Divide(threshold);
+        }
+    }
+    bbox_ = BoundsOf().Transform(transform_);
+    threshold_ = threshold;
+    build_cost_ = Cost();
+    lazy_ = false;
+    blocks_.Build(shapes_);
+}
+
+void ShapeGroup::DivideAndSave(int threshold, std::ostream& os) {
+    // Divides the group and writes the resulting hierarchy to the stream, so
+    // that LoadDivided() can rebuild it without repeating the work. The
+    // format is native-endian binary: a magic number, a hash of the undivided
+    // group and the length of the encoded hierarchy, then the encoding itself.
+    Collapse();
+    std::uint64_t hash = Hash(threshold);
+    std::map<const Shape*, std::int32_t> indices {};
+    for (std::size_t i = 0; i < shapes_.size(); i++) {
+        indices[shapes_[i]] = static_cast<std::int32_t>(i);
+    }
+
+    Divide(threshold);
+
+    std::vector<std::int32_t> words {};
+    Encode(words, indices);
+    std::uint64_t size { words.size() };
+    os.write(kHierarchyMagic, sizeof(kHierarchyMagic));
+    os.write(reinterpret_cast<const char*>(&hash), sizeof(hash));
+    os.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    os.write(reinterpret_cast<const char*>(words.data()), size * sizeof(std::int32_t));
+}
+
+bool ShapeGroup::LoadDivided(int threshold, std::istream& is) {
+    // Divides the group using a hierarchy written by DivideAndSave(); the
+    // group is left undivided and false is returned if the hierarchy was
+    // saved for different children or is corrupt
+    Collapse();
+    std::vector<char> buffer { std::istreambuf_iterator<char>(is),
+        std::istreambuf_iterator<char>() };
+    std::size_t header = sizeof(kHierarchyMagic) + 2 * sizeof(std::uint64_t);
+    if (buffer.size() < header ||
+            memcmp(buffer.data(), kHierarchyMagic, sizeof(kHierarchyMagic)) != 0) {
+        return false;
+    }
+    std::uint64_t hash {}, size {};
+    memcpy(&hash, buffer.data() + sizeof(kHierarchyMagic), sizeof(hash));
+    memcpy(&size, buffer.data() + sizeof(kHierarchyMagic) + sizeof(hash), sizeof(size));
+    if (hash != Hash(threshold) || buffer.size() != header + size * sizeof(std::int32_t)) {
+        return false;
+    }
+    std::vector<std::int32_t> words(size);
+    memcpy(words.data(), buffer.data() + header, size * sizeof(std::int32_t));
+
+    std::vector<bool> used(shapes_.size(), false);
+    std::size_t position { 0 };
+    if (!IsValidEncoding(words, position, used) || position != words.size()) {
+        return false;
+    }
+    for (bool u: used) {
+        if (!u) {
+            return false;
+        }
+    }
+
+    std::vector<Shape*> primitives { shapes_ };
+    shapes_.clear();
+    position = 0;
+    Decode(words, position, primitives, threshold);
+    return true;
+}
+
+bool ShapeGroup::Divide(int threshold, const std::string& cache_path) {
+    // Divides the group, reusing the hierarchy cached in the given file if
+    // the group's children haven't changed since it was written; otherwise
+    // the group is divided as usual and the cache is rewritten. Returns true
+    // if the cached hierarchy was used.
+    std::ifstream in { cache_path, std::ios::binary };
+    if (in && LoadDivided(threshold, in)) {
+        return true;
+    }
+    in.close();
+    std::ofstream out { cache_path, std::ios::binary | std::ios::trunc };
+    if (out) {
+        DivideAndSave(threshold, out);
+    }
+    else {
+        Divide(threshold);
+    }
+    return false;
+}
+
+void ShapeGroup::DivideLazily(int threshold) {
+    // Like Divide(), but only the top level of the hierarchy is built now;
+    // each subgroup is divided the first time a ray enters it, so parts of
+    // the scene that are never seen are never divided
+    threshold_ = threshold;
+    undivided_ = true;
+    DivideOnDemand();
+    // the cost of the top level, which only falls as rays divide the rest,
+    // so that Refit() only rebuilds once the children have moved
+    build_cost_ = Cost();
+    lazy_ = true;
+}
+
+void ShapeGroup::DivideOnDemand() {
+    // Divide one level of the group, leaving its subgroups to be divided on
+    // demand in turn. Rays may be entering the group on other threads: wait
+    // for any thread that got here first, and leave the group's own bounding
+    // box alone since the group's parent may be reading it.
+    std::lock_guard<std::mutex> lock { divide_mutex_ };
+    if (!undivided_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    if (threshold_ <= Size()) {
+        auto partitions = Partition();
+        for (auto& partition: partitions) {
+            if (partition.size() > 0) {
+                shapes_.push_back(NewSubgroup(partition));
+                shapes_.back()->Parent(this);
+            }
+        }
+    }
+    for (auto s: shapes_) {
+        if (s->IsGroup()) {
+            ShapeGroup* group = static_cast<ShapeGroup*>(s);
+            group->threshold_ = threshold_;
+            group->undivided_.store(true, std::memory_order_relaxed);
+        }
+    }
+    blocks_.Build(shapes_);
+    undivided_.store(false, std::memory_order_release);
 }
\ No newline at end of file
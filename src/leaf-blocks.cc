@@ -0,0 +1,214 @@
+#include <algorithm> // for min, max
+#include <cmath>     // for sqrt
+#include "leaf-blocks.h"
+#include "sphere.h"
+#include "cube.h"
+
+// The kernels work on this many primitives at a time, keeping their
+// intermediate results on the stack
+static const std::size_t kChunkSize { 16 };
+
+static void AddInverse(std::array<std::vector<double>, 12>& inverse, const AffineTransform& m) {
+    for (int row = 0; row < 3; row++) {
+        for (int column = 0; column < 4; column++) {
+            inverse[row * 4 + column].push_back(m.At(row, column));
+        }
+    }
+}
+
+static std::size_t InverseMemory(const std::array<std::vector<double>, 12>& inverse) {
+    std::size_t memory { 0 };
+    for (auto& row: inverse) {
+        memory += row.capacity() * sizeof(double);
+    }
+    return memory;
+}
+
+void SphereBlock::Add(const Sphere* s) {
+    shapes_.push_back(s);
+    AddInverse(inverse_, s->InverseTransform());
+    Point centre = s->Origin();
+    centre_x_.push_back(centre.X());
+    centre_y_.push_back(centre.Y());
+    centre_z_.push_back(centre.Z());
+    radius_squared_.push_back(s->Radius() * s->Radius());
+}
+
+void SphereBlock::Clear() {
+    shapes_.clear();
+    for (auto& row: inverse_) {
+        row.clear();
+    }
+    centre_x_.clear();
+    centre_y_.clear();
+    centre_z_.clear();
+    radius_squared_.clear();
+}
+
+std::size_t SphereBlock::Memory() const {
+    return shapes_.capacity() * sizeof(const Shape*) + InverseMemory(inverse_) +
+        (centre_x_.capacity() + centre_y_.capacity() + centre_z_.capacity() +
+            radius_squared_.capacity()) * sizeof(double);
+}
+
+bool SphereBlock::Intersect(IntersectionList& list, const Ray& ray) const {
+    // The same calculation as Sphere::Intersect() for each sphere, with the
+    // operations in the same order so that the results are identical
+    const Point& origin = ray.Origin();
+    const Vector& direction = ray.Direction();
+    double ox = origin.X(), oy = origin.Y(), oz = origin.Z(),
+           dx = direction.X(), dy = direction.Y(), dz = direction.Z();
+    const double* m[12];
+    for (int k = 0; k < 12; k++) {
+        m[k] = inverse_[k].data();
+    }
+
+    bool intersected { false };
+    double discriminant[kChunkSize], t1[kChunkSize], t2[kChunkSize];
+    for (std::size_t first = 0; first < shapes_.size(); first += kChunkSize) {
+        std::size_t size = std::min(kChunkSize, shapes_.size() - first);
+        for (std::size_t i = 0; i < size; i++) {
+            std::size_t s = first + i;
+            double x = m[0][s] * ox + m[1][s] * oy + m[2][s] * oz + m[3][s] - centre_x_[s],
+                   y = m[4][s] * ox + m[5][s] * oy + m[6][s] * oz + m[7][s] - centre_y_[s],
+                   z = m[8][s] * ox + m[9][s] * oy + m[10][s] * oz + m[11][s] - centre_z_[s],
+                   u = m[0][s] * dx + m[1][s] * dy + m[2][s] * dz,
+                   v = m[4][s] * dx + m[5][s] * dy + m[6][s] * dz,
+                   w = m[8][s] * dx + m[9][s] * dy + m[10][s] * dz;
+            double a = u * u + v * v + w * w,
+                   b = 2 * (u * x + v * y + w * z),
+                   c = (x * x + y * y + z * z) - radius_squared_[s],
+                   d = b * b - 4 * a * c,
+                   root = std::sqrt(std::max(d, 0.0)),
+                   q = -0.5 * ((b > 0) ? (b + root) : (b - root));
+            discriminant[i] = d;
+            t1[i] = (d == 0) ? -0.5 * b / a : q / a;
+            t2[i] = (d == 0) ? t1[i] : c / q;
+        }
+        for (std::size_t i = 0; i < size; i++) {
+            if (discriminant[i] >= 0) {
+                list.Add(t1[i], shapes_[first + i]);
+                list.Add(t2[i], shapes_[first + i]);
+                intersected = true;
+            }
+        }
+    }
+    return intersected;
+}
+
+void CubeBlock::Add(const Cube* c) {
+    shapes_.push_back(c);
+    AddInverse(inverse_, c->InverseTransform());
+}
+
+void CubeBlock::Clear() {
+    shapes_.clear();
+    for (auto& row: inverse_) {
+        row.clear();
+    }
+}
+
+std::size_t CubeBlock::Memory() const {
+    return shapes_.capacity() * sizeof(const Shape*) + InverseMemory(inverse_);
+}
+
+// The slab test of BoundingBox::Intersects() for one axis of the unit cube
+static inline void CubeSlab(double origin, double inverse, double& tmin, double& tmax) {
+    bool negative = inverse < 0;
+    double near = ((negative ? 1.0 : -1.0) - origin) * inverse,
+           far = ((negative ? -1.0 : 1.0) - origin) * inverse;
+    tmin = (near > tmin) ? near : tmin;
+    tmax = (far < tmax) ? far : tmax;
+}
+
+bool CubeBlock::Intersect(IntersectionList& list, const Ray& ray) const {
+    // The same calculation as Cube::Intersect() for each cube
+    const Point& origin = ray.Origin();
+    const Vector& direction = ray.Direction();
+    double ox = origin.X(), oy = origin.Y(), oz = origin.Z(),
+           dx = direction.X(), dy = direction.Y(), dz = direction.Z();
+    const double* m[12];
+    for (int k = 0; k < 12; k++) {
+        m[k] = inverse_[k].data();
+    }
+
+    bool intersected { false };
+    double entry[kChunkSize], exit[kChunkSize];
+    for (std::size_t first = 0; first < shapes_.size(); first += kChunkSize) {
+        std::size_t size = std::min(kChunkSize, shapes_.size() - first);
+        for (std::size_t i = 0; i < size; i++) {
+            std::size_t s = first + i;
+            double x = m[0][s] * ox + m[1][s] * oy + m[2][s] * oz + m[3][s],
+                   y = m[4][s] * ox + m[5][s] * oy + m[6][s] * oz + m[7][s],
+                   z = m[8][s] * ox + m[9][s] * oy + m[10][s] * oz + m[11][s],
+                   u = m[0][s] * dx + m[1][s] * dy + m[2][s] * dz,
+                   v = m[4][s] * dx + m[5][s] * dy + m[6][s] * dz,
+                   w = m[8][s] * dx + m[9][s] * dy + m[10][s] * dz;
+            double tmin { -kBBInfinity }, tmax { kBBInfinity };
+            CubeSlab(x, 1.0 / u, tmin, tmax);
+            CubeSlab(y, 1.0 / v, tmin, tmax);
+            CubeSlab(z, 1.0 / w, tmin, tmax);
+            entry[i] = tmin;
+            exit[i] = tmax;
+        }
+        for (std::size_t i = 0; i < size; i++) {
+            if (entry[i] <= exit[i]) {
+                list.Add(entry[i], shapes_[first + i]);
+                list.Add(exit[i], shapes_[first + i]);
+                intersected = true;
+            }
+        }
+    }
+    return intersected;
+}
+
+void LeafBlocks::Build(const std::vector<Shape*>& shapes) {
+    Clear();
+    for (auto s: shapes) {
+        switch (s->Type()) {
+            case PrimitiveType::kSphere:
+                spheres_.Add(static_cast<const Sphere*>(s));
+                break;
+            case PrimitiveType::kCube:
+                cubes_.Add(static_cast<const Cube*>(s));
+                break;
+            default:
+                others_.push_back(s);
+        }
+    }
+    built_ = true;
+}
+
+void LeafBlocks::Clear() {
+    spheres_.Clear();
+    cubes_.Clear();
+    others_.clear();
+    built_ = false;
+}
+
+std::size_t LeafBlocks::Memory() const {
+    return spheres_.Memory() + cubes_.Memory() + others_.capacity() * sizeof(const Shape*);
+}
+
+bool LeafBlocks::Intersect(IntersectionList& list, const Ray& ray) const {
+    bool intersected { false };
+    bool count = TraversalStatistics::Enabled();
+    if (count) {
+        TraversalStatistics::CountPrimitiveTests(spheres_.Size() + cubes_.Size());
+    }
+    if (spheres_.Size() > 0 && spheres_.Intersect(list, ray)) {
+        intersected = true;
+    }
+    if (cubes_.Size() > 0 && cubes_.Intersect(list, ray)) {
+        intersected = true;
+    }
+    for (auto s: others_) {
+        if (count) {
+            TraversalStatistics::CountShapeTest(s);
+        }
+        if (s->Intersect(list, ray)) {
+            intersected = true;
+        }
+    }
+    return intersected;
+}
\ No newline at end of file
@@ -1,10 +1,36 @@
 #include "material.h"
 
 #include <cmath>
+#include <stdexcept>
 
 #include "utils.h"
 #include "pattern.h"
 
+bool Material::Identical(const Material& m) const {
+    Colour a = surface_, b = m.surface_;
+    return a.Red() == b.Red() && a.Green() == b.Green() && a.Blue() == b.Blue()
+        && pattern_ == m.pattern_
+        && ambient_ == m.ambient_
+        && diffuse_ == m.diffuse_
+        && specular_ == m.specular_
+        && shininess_ == m.shininess_
+        && reflectivity_ == m.reflectivity_
+        && transparency_ == m.transparency_
+        && refractive_index_ == m.refractive_index_
+        && casts_shadow_ == m.casts_shadow_;
+}
+
+std::size_t Material::Hash() const {
+    Colour c = surface_;
+    std::hash<double> h {};
+    std::size_t hash = std::hash<const Pattern*>{}(pattern_);
+    for (double d: { c.Red(), c.Green(), c.Blue(), ambient_, diffuse_, specular_,
+            shininess_, reflectivity_, transparency_, refractive_index_ }) {
+        hash = hash * 31 + h(d);
+    }
+    return hash * 2 + (casts_shadow_ ? 1 : 0);
+}
+
 bool Material::operator==(const Material& m) const {
     bool pattern_exists = PatternExists(),
          m_pattern_exists = m.PatternExists();
@@ -71,4 +97,69 @@ Colour Material::ApplyLightAt(const Shape* object, const Light& light, const Poi
     }
 
     return ambient + diffuse + specular;
+}
+
+const MaterialIndex MaterialTable::kDefault = 0;
+const MaterialIndex MaterialTable::kChunkSize = 1024;
+const MaterialIndex MaterialTable::kMaxChunks = 4096;
+
+MaterialTable::MaterialTable(): chunks_ { new std::atomic<Material*>[kMaxChunks] }, size_ { 0 },
+        index_ {}, mutex_ {} {
+    for (MaterialIndex chunk = 0; chunk < kMaxChunks; chunk++) {
+        chunks_[chunk].store(nullptr, std::memory_order_relaxed);
+    }
+    Intern(Material());
+}
+
+MaterialTable::~MaterialTable() {
+    for (MaterialIndex chunk = 0; chunk < kMaxChunks; chunk++) {
+        delete[] chunks_[chunk].load(std::memory_order_relaxed);
+    }
+}
+
+MaterialTable& MaterialTable::Shared() {
+    static MaterialTable table {};
+    return table;
+}
+
+MaterialIndex MaterialTable::Intern(const Material& m) {
+    std::size_t hash = m.Hash();
+    std::lock_guard<std::mutex> lock { mutex_ };
+    auto range = index_.equal_range(hash);
+    for (auto it = range.first; it != range.second; it++) {
+        if (At(it->second).Identical(m)) {
+            return it->second;
+        }
+    }
+    if (size_ == static_cast<std::size_t>(kChunkSize) * kMaxChunks) {
+        throw std::length_error("Too many materials");
+    }
+    MaterialIndex index = static_cast<MaterialIndex>(size_);
+    std::atomic<Material*>& chunk = chunks_[index / kChunkSize];
+    Material* entries = chunk.load(std::memory_order_relaxed);
+    if (entries == nullptr) {
+        entries = new Material[kChunkSize];
+        entries[0] = m;
+        // publish the chunk once its first entry is written
+        chunk.store(entries, std::memory_order_release);
+    }
+    else {
+        entries[index % kChunkSize] = m;
+    }
+    size_++;
+    index_.emplace(hash, index);
+    return index;
+}
+
+std::size_t MaterialTable::Size() {
+    std::lock_guard<std::mutex> lock { mutex_ };
+    return size_;
+}
+
+std::size_t MaterialTable::Memory() {
+    // the chunks allocated, not counting the table of chunks
+    std::lock_guard<std::mutex> lock { mutex_ };
+    std::size_t chunks = (size_ + kChunkSize - 1) / kChunkSize;
+    return chunks * kChunkSize * sizeof(Material) +
+        index_.size() * (sizeof(std::size_t) + sizeof(MaterialIndex));
 }
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include "octree.h"
+
+const int Octree::kMaxDepth = 10;
+const int Octree::kMaxLeafSize = 8;
+
+void Octree::BuildNode(int node, const std::vector<int>& shapes, int depth) {
+    if (shapes.size() <= kMaxLeafSize || depth >= kMaxDepth) {
+        nodes_[node].shapes = shapes;
+        return;
+    }
+
+    // Find the bounds of each octant: bit 0 of the octant's index selects the
+    // upper half of the node along the x axis, bit 1 along y and bit 2 along z
+    Point min = nodes_[node].box.Min(),
+          max = nodes_[node].box.Max();
+    std::vector<BoundingBox> octants {};
+    for (int octant = 0; octant < 8; octant++) {
+        Point low = min,
+              high = max;
+        for (auto axis: BoundingBox::kIndices) {
+            double centre = (min[axis] + max[axis]) / 2;
+            if (octant & (1 << axis)) {
+                low[axis] = centre;
+            }
+            else {
+                high[axis] = centre;
+            }
+        }
+        octants.push_back(BoundingBox { low, high });
+    }
+
+    std::array<std::vector<int>, 8> contents {};
+    std::vector<int> straddling {};
+    for (int index: shapes) {
+        BoundingBox box = shapes_[index]->BoundsOfInParentSpace();
+        bool contained { false };
+        for (int octant = 0; octant < 8; octant++) {
+            if (octants[octant].Contains(box)) {
+                contents[octant].push_back(index);
+                contained = true;
+                break;
+            }
+        }
+        if (!contained) {
+            straddling.push_back(index);
+        }
+    }
+    nodes_[node].shapes = straddling;
+
+    for (int octant = 0; octant < 8; octant++) {
+        if (contents[octant].empty()) {
+            continue;
+        }
+        // don't hold references into nodes_ here: adding a node may move them
+        int child = nodes_.size();
+        Node n { octants[octant], {}, {} };
+        n.children.fill(-1);
+        nodes_.push_back(n);
+        nodes_[node].children[octant] = child;
+        BuildNode(child, contents[octant], depth + 1);
+    }
+}
+
+void Octree::BuildStructure() {
+    nodes_.clear();
+    if (shapes_.empty()) {
+        return;
+    }
+    Node root { bounds_, {}, {} };
+    root.children.fill(-1);
+    nodes_.push_back(root);
+    std::vector<int> shapes {};
+    for (std::size_t index = 0; index < shapes_.size(); index++) {
+        shapes.push_back(index);
+    }
+    BuildNode(0, shapes, 0);
+}
+
+bool Octree::IntersectNode(IntersectionList& list, const Ray& ray, int node) const {
+    const Node& n = nodes_[node];
+    if (!n.box.Intersects(ray)) {
+        return false;
+    }
+    bool intersected { false };
+    for (int index: n.shapes) {
+        if (IntersectShape(list, ray, shapes_[index])) {
+            intersected = true;
+        }
+    }
+    for (int child: n.children) {
+        if (child >= 0 && IntersectNode(list, ray, child)) {
+            intersected = true;
+        }
+    }
+    return intersected;
+}
+
+bool Octree::Intersect(IntersectionList& list, const Ray& ray) const {
+    bool intersected = IntersectUnbounded(list, ray);
+    if (!nodes_.empty() && IntersectNode(list, ray, 0)) {
+        intersected = true;
+    }
+    return intersected;
+}
\ No newline at end of file
@@ -17,6 +17,27 @@ bool Plane::Intersect(IntersectionList& list, const Ray& world_ray) const {
     return false;
 }
 
+LaneMask Plane::IntersectPacket(IntersectionList* lists, const RayPacket& world_packet,
+        LaneMask mask) const {
+    RayPacket packet = world_packet.Transform(inverse_transform_);
+    const int size = packet.Size();
+    const double *origin_y = packet.OriginY(), *direction_y = packet.DirectionY();
+    double distance[kMaxPacketSize];
+    for (int lane = 0; lane < size; lane++) {
+        distance[lane] = -origin_y[lane] / direction_y[lane];
+    }
+
+    LaneMask intersected { 0 };
+    for (int lane = 0; lane < size; lane++) {
+        LaneMask bit = 1u << lane;
+        if ((mask & bit) && std::fabs(direction_y[lane]) >= kEpsilon) {
+            lists[lane].Add(distance[lane], this);
+            intersected |= bit;
+        }
+    }
+    return intersected;
+}
+
 bool Plane::operator==(const Shape& s) const {
     const Plane* other = dynamic_cast<const Plane*>(&s);
     if (other == nullptr) { // Shape is not an Plane?
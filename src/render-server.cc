@@ -0,0 +1,203 @@
+#include <algorithm> // for max
+#include <cerrno>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "render-server.h"
+#include "distributed.h"
+#include "transformations.h"
+
+// The longest request line a server reads
+static const std::size_t kMaxRequestLength { 4096 };
+
+// The largest image a request may ask for, on each side and in all
+static const int kMaxImageSize { 16384 };
+static const long long kMaxImagePixels { 1 << 24 };
+
+// Parses a comma-separated list of count numbers, throwing
+// std::invalid_argument if the value isn't one
+static std::vector<double> ParseNumbers(const std::string& key, const std::string& value,
+        std::size_t count) {
+    std::vector<double> numbers {};
+    std::istringstream list { value };
+    std::string number {};
+    while (std::getline(list, number, ',')) {
+        std::size_t parsed { 0 };
+        try {
+            numbers.push_back(std::stod(number, &parsed));
+        }
+        catch (const std::exception&) {
+            parsed = 0;
+        }
+        if (parsed == 0 || parsed != number.size()) {
+            break;
+        }
+    }
+    // getline doesn't return the empty number after a trailing comma
+    if (numbers.size() != count || list || value.back() == ',') {
+        throw std::invalid_argument("Invalid value for " + key + ": " + value);
+    }
+    return numbers;
+}
+
+// As ParseNumbers(), but the numbers must be integers
+static std::vector<int> ParseIntegers(const std::string& key, const std::string& value,
+        std::size_t count) {
+    std::vector<int> integers {};
+    for (double number: ParseNumbers(key, value, count)) {
+        if (number != std::floor(number) || std::fabs(number) > std::numeric_limits<int>::max()) {
+            throw std::invalid_argument("Invalid value for " + key + ": " + value);
+        }
+        integers.push_back(static_cast<int>(number));
+    }
+    return integers;
+}
+
+RenderRequest::RenderRequest(const Camera& camera): width { camera.Horizontal() },
+    height { camera.Vertical() }, field_of_view { camera.FieldOfView() }, has_view { false },
+    from { 0, 0, 0 }, to { 0, 0, 0 }, up { 0, 1, 0 }, has_crop { false }, crop_column { 0 },
+    crop_row { 0 }, crop_width { camera.Horizontal() }, crop_height { camera.Vertical() } {}
+
+void RenderRequest::Parse(const std::string& line) {
+    std::istringstream words { line };
+    std::string word {};
+    if (!(words >> word) || word != "render") {
+        throw std::invalid_argument("Expected a render request");
+    }
+    RenderRequest request { *this };
+    while (words >> word) {
+        std::size_t equals = word.find('=');
+        if (equals == std::string::npos) {
+            throw std::invalid_argument("Expected key=value: " + word);
+        }
+        std::string key = word.substr(0, equals), value = word.substr(equals + 1);
+        if (key == "width" || key == "height") {
+            int size = ParseIntegers(key, value, 1)[0];
+            if (size < 1 || size > kMaxImageSize) {
+                throw std::invalid_argument("Invalid value for " + key + ": " + value);
+            }
+            (key == "width" ? request.width : request.height) = size;
+        }
+        else if (key == "fov") {
+            request.field_of_view = ParseNumbers(key, value, 1)[0];
+            if (request.field_of_view <= 0 || request.field_of_view >= M_PI) {
+                throw std::invalid_argument("Invalid value for fov: " + value);
+            }
+        }
+        else if (key == "from" || key == "to" || key == "up") {
+            std::vector<double> xyz = ParseNumbers(key, value, 3);
+            if (key == "from") {
+                request.from = Point { xyz[0], xyz[1], xyz[2] };
+            }
+            else if (key == "to") {
+                request.to = Point { xyz[0], xyz[1], xyz[2] };
+            }
+            else {
+                request.up = Vector { xyz[0], xyz[1], xyz[2] };
+            }
+            request.has_view = true;
+        }
+        else if (key == "crop") {
+            std::vector<int> crop = ParseIntegers(key, value, 4);
+            request.crop_column = crop[0];
+            request.crop_row = crop[1];
+            request.crop_width = crop[2];
+            request.crop_height = crop[3];
+            request.has_crop = true;
+        }
+        else {
+            throw std::invalid_argument("Unknown key: " + key);
+        }
+    }
+    if (static_cast<long long>(request.width) * request.height > kMaxImagePixels) {
+        throw std::invalid_argument("Image too large: " + std::to_string(request.width) + "x" +
+            std::to_string(request.height));
+    }
+    if (!request.has_crop) {
+        request.crop_width = request.width;
+        request.crop_height = request.height;
+    }
+    *this = request;
+}
+
+const Camera RenderRequest::MakeCamera(const Camera& camera) const {
+    Camera made { width, height, field_of_view };
+    made.SetTransform(has_view ? ViewTransform { from, to, up } : camera.Transform());
+    return made;
+}
+
+RenderServer::RenderServer(const World& world, const Camera& camera, const std::string& path,
+        int threads): world_ { world }, camera_ { camera }, path_ { path },
+        threads_ { std::max(1, threads) }, listener_ { ListenAt(path, 1) }, frames_ { 0 } {}
+
+RenderServer::~RenderServer() {
+    close(listener_);
+    unlink(path_.c_str());
+}
+
+const Canvas RenderServer::Render(const std::string& line) const {
+    RenderRequest request { camera_ };
+    request.Parse(line);
+    Camera camera = request.MakeCamera(camera_);
+    return camera.RenderRegion(world_, request.crop_column, request.crop_row,
+        request.crop_width, request.crop_height, threads_);
+}
+
+// Reads up to the end of a line, or of the stream
+static std::string ReceiveLine(int socket) {
+    std::string line {};
+    char c {};
+    while (line.size() < kMaxRequestLength && ReceiveAll(socket, &c, 1) && c != '\n') {
+        line.push_back(c);
+    }
+    return line;
+}
+
+void RenderServer::Serve() {
+    while (true) {
+        int client = accept(listener_, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Couldn't accept clients at " + path_);
+        }
+        std::string line = ReceiveLine(client);
+        if (line == "stop") {
+            close(client);
+            return;
+        }
+        std::ostringstream reply {};
+        try {
+            reply << PPMv3 { Render(line) };
+            frames_++;
+        }
+        catch (const std::exception& e) {
+            reply.str("");
+            reply << "error: " << e.what() << '\n';
+        }
+        std::string bytes = reply.str();
+        SendAll(client, bytes.data(), bytes.size());
+        close(client);
+    }
+}
+
+std::string RequestRender(const std::string& path, const std::string& line) {
+    int server = ConnectTo(path);
+    std::string request = line + '\n';
+    std::string reply {};
+    if (SendAll(server, request.data(), request.size())) {
+        char buffer[4096];
+        ssize_t received {};
+        while ((received = recv(server, buffer, sizeof(buffer), 0)) > 0 ||
+                (received < 0 && errno == EINTR)) {
+            reply.append(buffer, std::max<ssize_t>(received, 0));
+        }
+    }
+    close(server);
+    return reply;
+}
\ No newline at end of file
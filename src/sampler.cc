@@ -0,0 +1,168 @@
+#include <algorithm> // for max
+#include <cmath>     // for abs, ceil, floor, sqrt
+#include <stdexcept>
+#include "sampler.h"
+
+PixelSampler::PixelSampler(int samples, SamplePattern pattern, PixelFilter filter,
+        std::uint32_t seed): samples_ { samples }, pattern_ { pattern }, filter_ { filter },
+        seed_ { seed } {
+    if (samples_ < 1) {
+        throw std::invalid_argument("A pixel needs at least one sample");
+    }
+}
+
+// Mixes the bits of n so that nearby inputs give unrelated outputs (the
+// "lowbias32" integer hash)
+static std::uint32_t Hash(std::uint32_t n) {
+    n ^= n >> 16;
+    n *= 0x7feb352d;
+    n ^= n >> 15;
+    n *= 0x846ca68b;
+    n ^= n >> 16;
+    return n;
+}
+
+static std::uint32_t Hash(std::uint32_t a, std::uint32_t b, std::uint32_t c, std::uint32_t d) {
+    return Hash(Hash(Hash(Hash(a) ^ b) ^ c) ^ d);
+}
+
+// The top 24 bits of n as a fraction in [0, 1)
+static double ToUnit(std::uint32_t n) {
+    return (n >> 8) * (1.0 / (1 << 24));
+}
+
+// The digits of n in the given base, reversed after the radix point
+static double RadicalInverse(std::uint32_t n, std::uint32_t base) {
+    double inverse_base = 1.0 / base, scale = inverse_base, result { 0 };
+    for (; n > 0; n /= base) {
+        result += (n % base) * scale;
+        scale *= inverse_base;
+    }
+    return result;
+}
+
+static std::uint32_t ReverseBits(std::uint32_t n) {
+    n = (n << 16) | (n >> 16);
+    n = ((n & 0x00ff00ff) << 8) | ((n & 0xff00ff00) >> 8);
+    n = ((n & 0x0f0f0f0f) << 4) | ((n & 0xf0f0f0f0) >> 4);
+    n = ((n & 0x33333333) << 2) | ((n & 0xcccccccc) >> 2);
+    n = ((n & 0x55555555) << 1) | ((n & 0xaaaaaaaa) >> 1);
+    return n;
+}
+
+// The second dimension of the Sobol sequence, as 32 fraction bits; with the
+// first (the bits of n reversed) each power of two of points is stratified
+// over every grid of that many cells
+static std::uint32_t Sobol2(std::uint32_t n) {
+    std::uint32_t result { 0 };
+    for (std::uint32_t v = 1u << 31; n > 0; n >>= 1, v ^= v >> 1) {
+        if (n & 1) {
+            result ^= v;
+        }
+    }
+    return result;
+}
+
+void PixelSampler::Sample(int pixel_x, int pixel_y, int index, double& x, double& y) const {
+    std::uint32_t px = static_cast<std::uint32_t>(pixel_x),
+                  py = static_cast<std::uint32_t>(pixel_y),
+                  i = static_cast<std::uint32_t>(index);
+    switch (pattern_) {
+        case SamplePattern::kRandom:
+            x = ToUnit(Hash(seed_, px, py, 2 * i));
+            y = ToUnit(Hash(seed_, px, py, 2 * i + 1));
+            break;
+        case SamplePattern::kStratified: {
+            // A grid of at least as many cells as samples, the cells visited
+            // in a per-pixel random order
+            int columns = static_cast<int>(std::ceil(std::sqrt(samples_))),
+                rows = (samples_ + columns - 1) / columns;
+            int cell = static_cast<int>((index + Hash(seed_, px, py, 0)) % (columns * rows));
+            x = (cell % columns + ToUnit(Hash(seed_, px, py, 2 * i + 1))) / columns;
+            y = (cell / columns + ToUnit(Hash(seed_, px, py, 2 * i + 2))) / rows;
+            break;
+        }
+        case SamplePattern::kHalton: {
+            // Shift the points by a per-pixel offset, wrapping around the
+            // pixel (a Cranley-Patterson rotation)
+            x = RadicalInverse(i, 2) + ToUnit(Hash(seed_, px, py, 0));
+            y = RadicalInverse(i, 3) + ToUnit(Hash(seed_, px, py, 1));
+            x -= std::floor(x);
+            y -= std::floor(y);
+            break;
+        }
+        case SamplePattern::kSobol:
+            // Flip the same bits of every point of the pixel (a random digit
+            // scramble), which keeps the points stratified
+            x = ToUnit(ReverseBits(i) ^ Hash(seed_, px, py, 0));
+            y = ToUnit(Sobol2(i) ^ Hash(seed_, px, py, 1));
+            break;
+    }
+}
+
+double PixelSampler::Radius() const {
+    switch (filter_) {
+        case PixelFilter::kTent:
+            return 1.0;
+        case PixelFilter::kMitchell:
+            return 2.0;
+        default:
+            return 0.5;
+    }
+}
+
+// The Mitchell-Netravali filter with B = C = 1/3 along one axis
+static double Mitchell(double x) {
+    const double b = 1.0 / 3, c = 1.0 / 3;
+    x = std::abs(x);
+    if (x < 1) {
+        return ((12 - 9 * b - 6 * c) * x * x * x + (-18 + 12 * b + 6 * c) * x * x +
+            (6 - 2 * b)) / 6;
+    }
+    if (x < 2) {
+        return ((-b - 6 * c) * x * x * x + (6 * b + 30 * c) * x * x +
+            (-12 * b - 48 * c) * x + (8 * b + 24 * c)) / 6;
+    }
+    return 0;
+}
+
+double PixelSampler::Weight(double dx, double dy) const {
+    switch (filter_) {
+        case PixelFilter::kTent:
+            return std::max(0.0, 1 - std::abs(dx)) * std::max(0.0, 1 - std::abs(dy));
+        case PixelFilter::kMitchell:
+            return Mitchell(dx) * Mitchell(dy);
+        default:
+            // a sample on the edge between two pixels counts for one of them
+            return (dx >= -0.5 && dx < 0.5 && dy >= -0.5 && dy < 0.5) ? 1.0 : 0.0;
+    }
+}
+
+SamplePattern PixelSampler::ParsePattern(const std::string& name) {
+    if (name == "random") {
+        return SamplePattern::kRandom;
+    }
+    if (name == "stratified") {
+        return SamplePattern::kStratified;
+    }
+    if (name == "halton") {
+        return SamplePattern::kHalton;
+    }
+    if (name == "sobol") {
+        return SamplePattern::kSobol;
+    }
+    throw std::invalid_argument("Unknown sample pattern: " + name);
+}
+
+PixelFilter PixelSampler::ParseFilter(const std::string& name) {
+    if (name == "box") {
+        return PixelFilter::kBox;
+    }
+    if (name == "tent") {
+        return PixelFilter::kTent;
+    }
+    if (name == "mitchell") {
+        return PixelFilter::kMitchell;
+    }
+    throw std::invalid_argument("Unknown pixel filter: " + name);
+}
\ No newline at end of file
@@ -0,0 +1,401 @@
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include "scene-file.h"
+#include "sphere.h"
+#include "plane.h"
+#include "cube.h"
+#include "cylinder.h"
+#include "cone.h"
+#include "hemisphere.h"
+#include "group.h"
+
+static const YamlNode& Required(const YamlNode& node, const std::string& key) {
+    const YamlNode* value = node.Find(key);
+    if (value == nullptr) {
+        node.Fail("Expected " + key);
+    }
+    return *value;
+}
+
+// Throws std::invalid_argument unless every key of the mapping is allowed
+static void CheckKeys(const YamlNode& node, std::initializer_list<const char*> allowed) {
+    for (const auto& entry: node.entries) {
+        bool found { false };
+        for (const char* key: allowed) {
+            found = found || entry.first == key;
+        }
+        if (!found) {
+            entry.second.Fail("Unknown key: " + entry.first);
+        }
+    }
+}
+
+static int Integer(const YamlNode& node) {
+    double number = node.Number();
+    if (number != std::floor(number) || std::fabs(number) > std::numeric_limits<int>::max()) {
+        node.Fail("Expected a whole number");
+    }
+    return static_cast<int>(number);
+}
+
+static std::array<double, 3> Triple(const YamlNode& node) {
+    if (!node.IsSequence() || node.items.size() != 3) {
+        node.Fail("Expected a list of three numbers");
+    }
+    return std::array<double, 3> { node.items[0].Number(), node.items[1].Number(),
+        node.items[2].Number() };
+}
+
+static Colour ToColour(const YamlNode& node) {
+    std::array<double, 3> rgb = Triple(node);
+    return Colour { rgb[0], rgb[1], rgb[2] };
+}
+
+static Point ToPoint(const YamlNode& node) {
+    std::array<double, 3> xyz = Triple(node);
+    return Point { xyz[0], xyz[1], xyz[2] };
+}
+
+static Vector ToVector(const YamlNode& node) {
+    std::array<double, 3> xyz = Triple(node);
+    return Vector { xyz[0], xyz[1], xyz[2] };
+}
+
+void SceneFile::Load(std::istream& is) {
+    YamlReader reader { is };
+    YamlNode entry {};
+    while (reader.Next(entry)) {
+        if (entry.Find("add") != nullptr) {
+            Add(entry);
+        }
+        else if (entry.Find("define") != nullptr) {
+            Define(entry);
+        }
+        else {
+            entry.Fail("Expected add or define");
+        }
+    }
+}
+
+void SceneFile::Load(const std::string& path) {
+    std::ifstream file { path };
+    if (!file) {
+        throw std::runtime_error("Couldn't open " + path);
+    }
+    Load(file);
+}
+
+const Camera& SceneFile::SceneCamera() const {
+    if (!camera_) {
+        throw std::runtime_error("The scene has no camera");
+    }
+    return *camera_;
+}
+
+void SceneFile::Add(const YamlNode& entry) {
+    const std::string& type = Required(entry, "add").text;
+    if (type == "camera") {
+        CheckKeys(entry, { "add", "width", "height", "field-of-view", "from", "to", "up" });
+        int width = Integer(Required(entry, "width")),
+            height = Integer(Required(entry, "height"));
+        double field_of_view = Required(entry, "field-of-view").Number();
+        if (width < 1 || height < 1) {
+            entry.Fail("The camera's width and height must be positive");
+        }
+        camera_.reset(new Camera { width, height, field_of_view });
+        camera_->SetTransform(ViewTransform { ToPoint(Required(entry, "from")),
+            ToPoint(Required(entry, "to")), ToVector(Required(entry, "up")) });
+    }
+    else if (type == "light") {
+        CheckKeys(entry, { "add", "at", "intensity" });
+        lights_.emplace_back(ToPoint(Required(entry, "at")),
+            ToColour(Required(entry, "intensity")));
+        world_.Add(&lights_.back());
+    }
+    else {
+        entry_materials_.clear();
+        world_.Add(MakeShape(entry, nullptr));
+    }
+}
+
+// A definition that extends another starts with the other's entries, so
+// that its own replace them. A transform's references to others are
+// expanded here, so that a definition can't refer to itself
+void SceneFile::Define(const YamlNode& entry) {
+    CheckKeys(entry, { "define", "extend", "value" });
+    const YamlNode& name = Required(entry, "define");
+    if (!name.IsScalar()) {
+        name.Fail("Expected a name");
+    }
+    YamlNode value = Required(entry, "value");
+    const YamlNode* extend = entry.Find("extend");
+    if (extend != nullptr) {
+        const YamlNode& base = Definition(*extend);
+        if (!base.IsMapping() || !value.IsMapping()) {
+            extend->Fail("Only materials can be extended");
+        }
+        YamlNode merged = base;
+        merged.entries.insert(merged.entries.end(), value.entries.begin(), value.entries.end());
+        merged.line = value.line;
+        value = merged;
+    }
+    else if (value.IsSequence()) {
+        YamlNode expanded { YamlNode::Kind::kSequence, value.line };
+        for (const YamlNode& step: value.items) {
+            if (!step.IsScalar()) {
+                expanded.items.push_back(step);
+                continue;
+            }
+            const YamlNode& other = TransformDefinition(step);
+            expanded.items.insert(expanded.items.end(), other.items.begin(), other.items.end());
+        }
+        value = expanded;
+    }
+    definitions_[name.text] = value;
+    named_materials_.erase(name.text);
+}
+
+const YamlNode& SceneFile::Definition(const YamlNode& name) const {
+    auto found = definitions_.find(name.text);
+    if (!name.IsScalar() || found == definitions_.end()) {
+        name.Fail("Unknown definition: " + name.text);
+    }
+    return found->second;
+}
+
+const YamlNode& SceneFile::TransformDefinition(const YamlNode& name) const {
+    const YamlNode& definition = Definition(name);
+    if (!definition.IsSequence()) {
+        name.Fail("Expected a transform: " + name.text);
+    }
+    return definition;
+}
+
+Shape* SceneFile::MakeShape(const YamlNode& node, const YamlNode* inherited) {
+    if (!node.IsMapping()) {
+        node.Fail("Expected a shape");
+    }
+    const std::string& type = Required(node, "add").text;
+    const YamlNode* material = node.Find("material");
+    if (material == nullptr) {
+        material = inherited;
+    }
+    Shape* shape { nullptr };
+    if (type == "group") {
+        CheckKeys(node, { "add", "material", "transform", "children" });
+        ShapeGroup* group = objects_.Make<ShapeGroup>();
+        const YamlNode& children = Required(node, "children");
+        if (!children.IsSequence()) {
+            children.Fail("Expected a list of shapes");
+        }
+        std::vector<Shape*> shapes {};
+        for (const YamlNode& child: children.items) {
+            shapes.push_back(MakeShape(child, material));
+        }
+        group->Add(shapes);
+        shape = group;
+    }
+    else {
+        if (type == "sphere") {
+            shape = objects_.Make<Sphere>();
+        }
+        else if (type == "plane") {
+            shape = objects_.Make<Plane>();
+        }
+        else if (type == "cube") {
+            shape = objects_.Make<Cube>();
+        }
+        else if (type == "hemisphere") {
+            shape = objects_.Make<Hemisphere>();
+        }
+        else if (type == "cylinder" || type == "cone") {
+            CheckKeys(node, { "add", "material", "transform", "min", "max", "closed" });
+            const YamlNode* min = node.Find("min");
+            const YamlNode* max = node.Find("max");
+            const YamlNode* closed = node.Find("closed");
+            double infinity = std::numeric_limits<double>::infinity(),
+                   minimum = min != nullptr ? min->Number() : -infinity,
+                   maximum = max != nullptr ? max->Number() : infinity;
+            bool capped = closed != nullptr && closed->Boolean();
+            shape = type == "cylinder" ?
+                static_cast<Shape*>(objects_.Make<Cylinder>(minimum, maximum, capped)) :
+                static_cast<Shape*>(objects_.Make<Cone>(minimum, maximum, capped));
+        }
+        else {
+            node.Fail("Unknown shape: " + type);
+        }
+        if (type != "cylinder" && type != "cone") {
+            CheckKeys(node, { "add", "material", "transform" });
+        }
+        if (material != nullptr) {
+            shape->SetMaterial(MakeMaterial(*material));
+        }
+    }
+    const YamlNode* transform = node.Find("transform");
+    if (transform != nullptr) {
+        Transformation t {};
+        ApplyTransform(t, *transform);
+        shape->SetTransform(t);
+    }
+    shapes_++;
+    return shape;
+}
+
+const Material& SceneFile::MakeMaterial(const YamlNode& node) {
+    if (node.IsScalar()) {
+        auto made = named_materials_.find(node.text);
+        if (made != named_materials_.end()) {
+            return made->second;
+        }
+    }
+    else {
+        auto made = entry_materials_.find(&node);
+        if (made != entry_materials_.end()) {
+            return made->second;
+        }
+    }
+    const YamlNode& entries = node.IsScalar() ? Definition(node) : node;
+    if (!entries.IsMapping()) {
+        node.Fail("Expected a material");
+    }
+    Material material {};
+    for (const auto& entry: entries.entries) {
+        const std::string& key = entry.first;
+        const YamlNode& value = entry.second;
+        if (key == "color") {
+            material.Surface(ToColour(value));
+        }
+        else if (key == "ambient") {
+            material.Ambient(value.Number());
+        }
+        else if (key == "diffuse") {
+            material.Diffuse(value.Number());
+        }
+        else if (key == "specular") {
+            material.Specular(value.Number());
+        }
+        else if (key == "shininess") {
+            material.Shininess(value.Number());
+        }
+        else if (key == "reflective") {
+            material.Reflectivity(value.Number());
+        }
+        else if (key == "transparency") {
+            material.Transparency(value.Number());
+        }
+        else if (key == "refractive-index") {
+            material.RefractiveIndex(value.Number());
+        }
+        else if (key == "shadow") {
+            material.CastsShadow(value.Boolean());
+        }
+        else if (key == "pattern") {
+            material.SurfacePattern(MakePattern(value));
+        }
+        else {
+            value.Fail("Unknown key: " + key);
+        }
+    }
+    if (node.IsScalar()) {
+        return named_materials_[node.text] = material;
+    }
+    return entry_materials_[&node] = material;
+}
+
+Pattern* SceneFile::MakePattern(const YamlNode& node) {
+    if (!node.IsMapping()) {
+        node.Fail("Expected a pattern");
+    }
+    CheckKeys(node, { "type", "colors", "transform" });
+    const YamlNode& colours = Required(node, "colors");
+    if (!colours.IsSequence() || colours.items.size() != 2) {
+        colours.Fail("Expected two colours");
+    }
+    // each colour may be a pattern of its own
+    const Pattern* ab[2] {};
+    for (int i = 0; i < 2; i++) {
+        const YamlNode& colour = colours.items[i];
+        ab[i] = colour.IsMapping() ? MakePattern(colour) :
+            objects_.Make<SolidPattern>(ToColour(colour));
+    }
+    const std::string& type = Required(node, "type").text;
+    Pattern* pattern { nullptr };
+    if (type == "stripes") {
+        pattern = objects_.Make<StripePattern>(ab[0], ab[1]);
+    }
+    else if (type == "gradient") {
+        pattern = objects_.Make<GradientPattern>(ab[0], ab[1]);
+    }
+    else if (type == "rings") {
+        pattern = objects_.Make<RingPattern>(ab[0], ab[1]);
+    }
+    else if (type == "checkers") {
+        pattern = objects_.Make<CheckerPattern>(ab[0], ab[1]);
+    }
+    else {
+        node.Fail("Unknown pattern: " + type);
+    }
+    const YamlNode* transform = node.Find("transform");
+    if (transform != nullptr) {
+        Transformation t {};
+        ApplyTransform(t, *transform);
+        pattern->SetTransform(t);
+    }
+    return pattern;
+}
+
+void SceneFile::ApplyTransform(Transformation& transform, const YamlNode& node) const {
+    if (node.IsScalar()) {
+        ApplyTransform(transform, TransformDefinition(node));
+        return;
+    }
+    if (!node.IsSequence()) {
+        node.Fail("Expected a transform");
+    }
+    for (const YamlNode& step: node.items) {
+        if (step.IsScalar()) {
+            ApplyTransform(transform, TransformDefinition(step));
+            continue;
+        }
+        if (!step.IsSequence() || step.items.empty()) {
+            step.Fail("Expected a transformation");
+        }
+        const std::string& name = step.items[0].text;
+        std::vector<double> arguments {};
+        for (std::size_t i = 1; i < step.items.size(); i++) {
+            arguments.push_back(step.items[i].Number());
+        }
+        std::size_t expected = name == "translate" || name == "scale" ? 3
+            : name == "rotate-x" || name == "rotate-y" || name == "rotate-z" ? 1
+            : name == "shear" ? 6 : 0;
+        if (expected == 0) {
+            step.Fail("Unknown transformation: " + name);
+        }
+        if (arguments.size() != expected) {
+            step.Fail("Expected " + std::to_string(expected) + " numbers for " + name);
+        }
+        const double* a = arguments.data();
+        if (name == "translate") {
+            transform.Translate(a[0], a[1], a[2]);
+        }
+        else if (name == "scale") {
+            transform.Scale(a[0], a[1], a[2]);
+        }
+        else if (name == "rotate-x") {
+            transform.RotateX(a[0]);
+        }
+        else if (name == "rotate-y") {
+            transform.RotateY(a[0]);
+        }
+        else if (name == "rotate-z") {
+            transform.RotateZ(a[0]);
+        }
+        else {
+            transform.Shear(a[0], a[1], a[2], a[3], a[4], a[5]);
+        }
+    }
+}
\ No newline at end of file
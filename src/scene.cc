@@ -0,0 +1,45 @@
+#include <algorithm> // for max
+#include <cstdint>   // for uintptr_t
+#include "scene.h"
+
+const std::size_t Scene::kDefaultBlockSize = 1 << 16;
+
+void* Scene::Allocate(std::size_t size, std::size_t alignment) {
+    char* start { nullptr };
+    if (next_ != nullptr) {
+        std::uintptr_t address = reinterpret_cast<std::uintptr_t>(next_),
+                       aligned = (address + alignment - 1) & ~(alignment - 1);
+        start = next_ + (aligned - address);
+    }
+    if (start == nullptr || start > end_ || size > static_cast<std::size_t>(end_ - start)) {
+        // Start a new block; an object bigger than a block gets one of its
+        // own. Blocks from operator new are suitably aligned for any type.
+        std::size_t block_size = std::max(block_size_, size);
+        char* block = static_cast<char*>(::operator new(block_size));
+        blocks_.push_back(block);
+        reserved_ += block_size;
+        peak_ = std::max(peak_, reserved_);
+        start = block;
+        end_ = block + block_size;
+    }
+    next_ = start + size;
+    used_ += size;
+    return start;
+}
+
+void Scene::Clear() {
+    // destroy the objects in the reverse of the order they were made, since
+    // later objects (e.g., groups) may refer to earlier ones
+    for (auto it = destructors_.rbegin(); it != destructors_.rend(); it++) {
+        it->destroy(it->object);
+    }
+    destructors_.clear();
+    for (auto block: blocks_) {
+        ::operator delete(block);
+    }
+    blocks_.clear();
+    next_ = end_ = nullptr;
+    objects_ = 0;
+    used_ = 0;
+    reserved_ = 0;
+}
\ No newline at end of file
@@ -1,8 +1,68 @@
+#include <cstdint> // for uintptr_t
 #include "shape.h"
 #include "group.h"
 
 const double Shape::kEpsilon = 1e-5;
 
+std::atomic<bool> TraversalStatistics::enabled_ { false };
+std::atomic<unsigned long long> TraversalStatistics::rays_ { 0 };
+std::atomic<unsigned long long> TraversalStatistics::groups_visited_ { 0 };
+std::atomic<unsigned long long> TraversalStatistics::primitives_tested_ { 0 };
+std::atomic<unsigned long long> TraversalStatistics::rays_pruned_ { 0 };
+std::atomic<unsigned long long> TraversalStatistics::cache_misses_ { 0 };
+const int TraversalStatistics::kSimulatedCacheLines = 512; // 32 KiB
+
+// The line held by each slot of this thread's simulated cache
+static thread_local std::uintptr_t simulated_cache[TraversalStatistics::kSimulatedCacheLines];
+
+void TraversalStatistics::Reset() {
+    rays_ = 0;
+    groups_visited_ = 0;
+    primitives_tested_ = 0;
+    rays_pruned_ = 0;
+    cache_misses_ = 0;
+}
+
+void TraversalStatistics::CountAccess(const void* object) {
+    // Line 0 is never an object's, so an empty slot never matches
+    std::uintptr_t line = reinterpret_cast<std::uintptr_t>(object) / 64;
+    std::uintptr_t& slot = simulated_cache[line % kSimulatedCacheLines];
+    if (slot != line) {
+        slot = line;
+        cache_misses_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void TraversalStatistics::CountShapeTest(const Shape* s) {
+    // Groups count their own visits
+    if (!s->IsGroup()) {
+        primitives_tested_.fetch_add(1, std::memory_order_relaxed);
+        CountAccess(s);
+    }
+}
+
+void TraversalStatistics::Report(std::ostream& os) {
+    unsigned long long rays = Rays();
+    double per_ray = (rays > 0) ? 1.0 / rays : 0;
+    os << "rays traced: " << rays << std::endl
+       << "groups visited per ray: " << GroupsVisited() * per_ray << std::endl
+       << "primitives tested per ray: " << PrimitivesTested() * per_ray << std::endl
+       << "secondary rays pruned: " << RaysPruned() << std::endl
+       << "simulated cache misses per ray: " << CacheMisses() * per_ray << std::endl;
+}
+
+LaneMask Shape::IntersectPacket(IntersectionList* lists, const RayPacket& packet,
+        LaneMask mask) const {
+    LaneMask intersected { 0 };
+    for (int lane = 0; lane < packet.Size(); lane++) {
+        LaneMask bit = 1u << lane;
+        if ((mask & bit) && Intersect(lists[lane], packet.At(lane))) {
+            intersected |= bit;
+        }
+    }
+    return intersected;
+}
+
 Vector Shape::NormalAt(const Point &world_point) const {
     // convert world_point into point in object space
     Point object_point = ConvertWorldPointToObjectSpace(world_point);
@@ -15,7 +75,7 @@ Vector Shape::NormalAt(const Point &world_point) const {
 Colour Shape::ApplyLightAt(const Light& light, const Point& point,
         const Vector& eye_vector, const Vector& normal_vector, bool in_shadow) const
 {
-    return material_.ApplyLightAt(this, light, point, eye_vector, normal_vector, in_shadow);
+    return ShapeMaterial().ApplyLightAt(this, light, point, eye_vector, normal_vector, in_shadow);
 }
 
 const Point Shape::ConvertWorldPointToObjectSpace(const Point& world_point) const {
@@ -23,13 +83,13 @@ const Point Shape::ConvertWorldPointToObjectSpace(const Point& world_point) cons
     // object space; apply parent transformations first
     Point object_point = (parent_ != nullptr) ? parent_->ConvertWorldPointToObjectSpace(world_point)
         : world_point;
-    return transform_.Inverse() * object_point;
+    return inverse_transform_ * object_point;
 }
 
 const Vector Shape::ConvertObjectNormalToWorldSpace(const Vector& object_normal) const {
     // Recursively transpose transformations for object normal to convert it to
     // world space
-    Vector world_normal = transform_.Inverse().Transpose() * object_normal;
+    Vector world_normal = inverse_transform_.TransposeMultiply(object_normal);
     // hack to mitigate the effect of any translation operation on the w element
     world_normal[world_normal.kW] = 0.0;
     world_normal = world_normal.Normalize();
@@ -67,6 +127,35 @@ Intersection& Intersection::operator=(const Intersection& i) {
     return *this;
 }
 
+bool MediumStack::Contains(const Shape* s) const {
+    for (int k = 0; k < size_; k++) {
+        if (objects_[k] == s) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MediumStack::Cross(const Shape* s) {
+    // Search from the innermost object, which is usually the one being left
+    for (int k = size_ - 1; k >= 0; k--) {
+        if (objects_[k] == s) {
+            for (int m = k; m < size_ - 1; m++) {
+                objects_[m] = objects_[m + 1];
+            }
+            size_--;
+            return;
+        }
+    }
+    if (size_ < kMaxMediumDepth) {
+        objects_[size_++] = s;
+    }
+}
+
+double MediumStack::RefractiveIndex() const {
+    return (size_ == 0) ? 1.0 : objects_[size_ - 1]->ShapeMaterial().RefractiveIndex();
+}
+
 const double IntersectionComputation::kEpsilon = 1e-5;
 
 IntersectionComputation::IntersectionComputation(const Intersection& i, const Ray& r,
@@ -76,79 +165,82 @@ IntersectionComputation::IntersectionComputation(const Intersection& i, const Ra
         point_ { r.Position(i.Distance()) },
         eye_vector_ { -r.Direction() },
         normal_vector_ { i.Object()->NormalAt(point_) },
-        inside_ { false } {
+        inside_ { false },
+        xs_ { xs },
+        medium_ {},
+        medium_known_ { false },
+        n1_ { 1.0 },
+        n2_ { 1.0 } {
     if (Vector::DotProduct(normal_vector_, eye_vector_) < 0) {
         inside_ = true;
         normal_vector_ = -normal_vector_;
     }
-    over_point_ = point_ + normal_vector_ * IntersectionComputation::kEpsilon;
-    under_point_ = point_ - normal_vector_ * IntersectionComputation::kEpsilon;
-    reflection_vector_ = Vector::Reflect(r.Direction(), normal_vector_);
-
-    // Determine refractive indices
-    IntersectionList* intersections = xs;
 
-    auto free_fn = [xs, &intersections] () {
-        if (xs == nullptr && intersections != nullptr) {
-            // free allocated memory
-            delete intersections;
-        }
-    };
-
-    try
-    {
-        if (intersections == nullptr) {
-            // If no intersection list was given, just add the given intersection
-            intersections = new IntersectionList();
-            intersections->Add(i);
-        }
-
-        std::list<const Shape *> objects {};
-        for (const Intersection* to_test: *intersections) {
-            if (i == to_test) {
-                if (objects.size() == 0) {
-                    // this is the first intersection encountered
-                    n1_ = 1.0;
-                }
-                else {
-                    n1_ = objects.back()->ShapeMaterial().RefractiveIndex();
-                }
-            }
-
-            bool found { false };
-            const Shape *to_test_object = to_test->Object();
-            for (auto e: objects) {
-                if (to_test_object == e) {
-                    found = true;
-                    break;
-                }
-            }
+    // Only light refracted through a transparent object depends on the
+    // refractive indices, so don't look for them otherwise until asked
+    if (object_->ShapeMaterial().Transparency() > 0) {
+        FindMedium();
+    }
+}
 
-            if (found) {
-                objects.remove(to_test_object);
-            }
-            else {
-                objects.push_back(to_test_object);
-            }
+IntersectionComputation::IntersectionComputation(const Intersection& i, const Ray& r,
+    const MediumStack& medium): IntersectionComputation { i, r } {
+    medium_ = medium;
+    medium_known_ = true;
+    FindRefractiveIndices();
+}
 
-            if (i == to_test) {
-                if (objects.size() == 0) {
-                    // this is the last intersection encountered
-                    n2_ = 1.0;
-                }
-                else {
-                    n2_ = objects.back()->ShapeMaterial().RefractiveIndex();
-                }
+void IntersectionComputation::FindMedium() const {
+    // Walk the intersections up to the hit, entering and leaving the
+    // objects they belong to. The hit may belong to the list, which is
+    // sorted as it is walked, so compare with a copy. If no list was given,
+    // the ray is outside every object.
+    medium_ = MediumStack {};
+    if (xs_ != nullptr) {
+        const Intersection hit { distance_, object_ };
+        for (const Intersection* to_test: *xs_) {
+            if (hit == to_test) {
                 break;
             }
+            medium_.Cross(to_test->Object());
         }
+    }
+    medium_known_ = true;
+    FindRefractiveIndices();
+}
+
+void IntersectionComputation::FindRefractiveIndices() const {
+    n1_ = medium_.RefractiveIndex();
+    MediumStack beyond { medium_ };
+    beyond.Cross(object_);
+    n2_ = beyond.RefractiveIndex();
+}
+
+const double IntersectionComputation::N1() const {
+    if (!medium_known_) {
+        FindMedium();
+    }
+    return n1_;
+}
 
-        free_fn();
+const double IntersectionComputation::N2() const {
+    if (!medium_known_) {
+        FindMedium();
     }
-    catch(const std::exception& e)
-    {
-        free_fn();
+    return n2_;
+}
+
+const MediumStack* IntersectionComputation::ReflectedMedium() const {
+    return medium_known_ ? &medium_ : nullptr;
+}
+
+const MediumStack IntersectionComputation::RefractedMedium() const {
+    if (!medium_known_) {
+        FindMedium();
     }
+    MediumStack beyond { medium_ };
+    beyond.Cross(object_);
+    return beyond;
 }
 
 const double IntersectionComputation::Reflectance() const {
@@ -158,10 +250,11 @@ const double IntersectionComputation::Reflectance() const {
     // Find the cosine of the angle between the eye and normal vectors
     // This is cos(Θi) from Snell's Law.
     double cos = Vector::DotProduct(eye_vector_, normal_vector_);
+    double n1 = N1(), n2 = N2();
 
     // Total internal reflection occurs only if n1 > n2
-    if (n1_ > n2_) {
-        double n = n1_ / n2_;
+    if (n1 > n2) {
+        double n = n1 / n2;
         double sin_t_squared = n*n * (1.0 - cos * cos);
         if (sin_t_squared > 1.0) {
             return 1.0;
@@ -170,15 +263,63 @@ const double IntersectionComputation::Reflectance() const {
         cos = std::sqrt(1.0 - sin_t_squared);
     }
 
-    double r0 = (n1_ - n2_) / (n1_ + n2_);
+    double r0 = (n1 - n2) / (n1 + n2);
     r0 *= r0;
 
     return r0 + (1 - r0) * (std::pow(1 - cos, 5));
 }
 
-IntersectionList::~IntersectionList() {
-    for(auto i: list_) {
-        delete i;
+// The storage returned by the lists a thread has destroyed; enough to supply
+// the lists it has alive at once (e.g., one per level of recursion)
+static const std::size_t kMaxPooledStorage { 64 };
+static thread_local std::vector<std::vector<Intersection>> storage_pool {};
+
+IntersectionList::Storage IntersectionList::TakeStorage() {
+    if (storage_pool.empty()) {
+        return Storage {};
+    }
+    Storage storage { std::move(storage_pool.back()) };
+    storage_pool.pop_back();
+    return storage;
+}
+
+void IntersectionList::ReturnStorage(Storage& storage) {
+    if (storage.capacity() > 0 && storage_pool.size() < kMaxPooledStorage) {
+        storage.clear();
+        if (storage_pool.capacity() == 0) {
+            storage_pool.reserve(kMaxPooledStorage);
+        }
+        storage_pool.push_back(std::move(storage));
+    }
+}
+
+void IntersectionList::Sort() {
+    if (sorted_) {
+        return;
+    }
+    // Insertion sort: it is stable, so that intersections at the same
+    // distance stay in the order they were added, and it doesn't allocate
+    for (std::size_t i = 1; i < list_.size(); i++) {
+        Intersection x = list_[i];
+        std::size_t j = i;
+        for (; j > 0 && x.Distance() < list_[j - 1].Distance(); j--) {
+            list_[j] = list_[j - 1];
+        }
+        list_[j] = x;
+    }
+    sorted_ = true;
+    // The hits are the first nonnegative intersections in the sorted list
+    hit_ = shadow_hit_ = -1;
+    for (std::size_t i = 0; i < list_.size() && shadow_hit_ < 0; i++) {
+        const Intersection& x = list_[i];
+        if (x.Distance() >= 0) {
+            if (hit_ < 0) {
+                hit_ = i;
+            }
+            if (x.Object()->ShapeMaterial().CastsShadow()) {
+                shadow_hit_ = i;
+            }
+        }
     }
 }
 
@@ -187,35 +328,36 @@ const Intersection* IntersectionList::operator[](unsigned int index) {
     if (index >= list_.size()) {
         throw std::out_of_range("Index does not exist in list");
     }
-    unsigned int n = 0;
-    auto it = list_.begin();
-    while (n++ != index && it != list_.end()) {
-        it++;
-    }
-    return *it;
+    Sort();
+    return &list_[index];
 }
 
 void IntersectionList::Add(const Intersection* i) {
-    list_.insert(i);
-    if (i->Distance() >= 0) {
-        if (!hit_ || i->Distance() < hit_->Distance()) {
-            hit_ = i;
+    Add(*i);
+    delete i;
+}
+
+void IntersectionList::Add(double d, const Shape* s) {
+    int index = list_.size();
+    if (sorted_ && index > 0 && d < list_.back().Distance()) {
+        sorted_ = false;
+    }
+    list_.emplace_back(d, s);
+    if (d >= 0) {
+        if (hit_ < 0 || d < list_[hit_].Distance()) {
+            hit_ = index;
         }
         // This object will also be the hit for shadows only if it casts
         // shadows
-        if ((!shadow_hit_ || i->Distance() < shadow_hit_->Distance()) &&
-                i->Object()->ShapeMaterial().CastsShadow()) {
-            shadow_hit_ = i;
+        if ((shadow_hit_ < 0 || d < list_[shadow_hit_].Distance()) &&
+                s->ShapeMaterial().CastsShadow()) {
+            shadow_hit_ = index;
         }
     }
 }
 
-void IntersectionList::Add(double d, const Shape* s) {
-    Add(new Intersection(d, s));
-}
-
 void IntersectionList::Add(const Intersection& i) {
-    Add(new Intersection(i.Distance(), i.Object()));
+    Add(i.Distance(), i.Object());
 }
 
 IntersectionList& IntersectionList::operator<<(const Intersection* i) {
@@ -229,9 +371,9 @@ IntersectionList& IntersectionList::operator<<(const Intersection& i) {
 }
 
 const Intersection* IntersectionList::Hit() const {
-    return hit_;
+    return (hit_ >= 0) ? &list_[hit_] : nullptr;
 }
 
 const Intersection* IntersectionList::ShadowHit() const {
-    return shadow_hit_;
+    return (shadow_hit_ >= 0) ? &list_[shadow_hit_] : nullptr;
 }
\ No newline at end of file
@@ -34,6 +34,48 @@ bool Sphere::Intersect(IntersectionList& list, const Ray& world_ray) const {
     return true;
 }
 
+LaneMask Sphere::IntersectPacket(IntersectionList* lists, const RayPacket& world_packet,
+        LaneMask mask) const {
+    // The same calculation as Intersect() for every lane, computing both
+    // roots whatever the discriminant so that the loop can be vectorized
+    RayPacket packet = world_packet.Transform(inverse_transform_);
+    const int size = packet.Size();
+    const double *origin_x = packet.OriginX(), *origin_y = packet.OriginY(), *origin_z = packet.OriginZ(),
+                 *direction_x = packet.DirectionX(), *direction_y = packet.DirectionY(),
+                 *direction_z = packet.DirectionZ();
+    double centre_x = origin_.X(), centre_y = origin_.Y(), centre_z = origin_.Z(),
+           radius_squared = radius_ * radius_;
+    double discriminant[kMaxPacketSize], t1[kMaxPacketSize], t2[kMaxPacketSize];
+    for (int lane = 0; lane < size; lane++) {
+        double x = origin_x[lane] - centre_x,
+               y = origin_y[lane] - centre_y,
+               z = origin_z[lane] - centre_z,
+               dx = direction_x[lane],
+               dy = direction_y[lane],
+               dz = direction_z[lane];
+        double a = dx * dx + dy * dy + dz * dz,
+               b = 2 * (dx * x + dy * y + dz * z),
+               c = (x * x + y * y + z * z) - radius_squared,
+               d = b * b - 4 * a * c,
+               root = std::sqrt(std::max(d, 0.0)),
+               q = -0.5 * ((b > 0) ? (b + root) : (b - root));
+        discriminant[lane] = d;
+        t1[lane] = (d == 0) ? -0.5 * b / a : q / a;
+        t2[lane] = (d == 0) ? t1[lane] : c / q;
+    }
+
+    LaneMask intersected { 0 };
+    for (int lane = 0; lane < size; lane++) {
+        LaneMask bit = 1u << lane;
+        if ((mask & bit) && discriminant[lane] >= 0) {
+            lists[lane].Add(t1[lane], this);
+            lists[lane].Add(t2[lane], this);
+            intersected |= bit;
+        }
+    }
+    return intersected;
+}
+
 bool Sphere::operator==(const Shape& s) const {
     const Sphere* other = dynamic_cast<const Sphere*>(&s);
     if (other == nullptr) { // Shape is not a Sphere?
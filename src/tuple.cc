@@ -8,7 +8,7 @@ Tuple::Tuple(std::size_t n, const double* src) : size_ { n } {
     if (n < 0) {
         throw std::invalid_argument("Tuple size must be > 0");
     }
-    elements_ = new double[n];
+    Allocate(n);
     for (int i = 0; i < n; i++) {
         elements_[i] = src[i];
     }
@@ -18,13 +18,13 @@ Tuple::Tuple(std::size_t n): size_ { n } {
     if (n < 0) {
         throw std::invalid_argument("Tuple size must be > 0");
     }
-    elements_ = new double[n];
+    Allocate(n);
     // initialize all values to zero
     memset(elements_, 0, n * sizeof(double));
 }
 
 Tuple::Tuple(const Tuple& t): size_ { t.size_ } {
-    elements_ = new double[size_];
+    Allocate(size_);
     for (int i = 0; i < size_; i++) {
         elements_[i] = t.elements_[i];
     }
@@ -123,13 +123,15 @@ Tuple& Tuple::operator=(const Tuple& t) {
     if (*this == t) {
         return *this;
     }
-    double* old = elements_;
-    elements_ = new double[t.size_];
-    size_ = t.size_;
+    if (size_ != t.size_) {
+        double* elements = (t.size_ <= kInlineSize) ? inline_ : new double[t.size_];
+        Release();
+        elements_ = elements;
+        size_ = t.size_;
+    }
     for (int i = 0; i < size_; i++) {
         elements_[i] = t.elements_[i];
     }
-    delete[] old;
     return *this;
 }
 
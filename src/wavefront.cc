@@ -0,0 +1,57 @@
+#include <algorithm> // for min, max, sort
+#include "wavefront.h"
+
+// The bits per axis of a quantised origin
+static const int kMortonBits { 10 };
+
+// Spreads the low ten bits of n out to every third bit
+static std::uint64_t SpreadBits(std::uint64_t n) {
+    n &= 0x3ff;
+    n = (n | (n << 16)) & 0x030000ff;
+    n = (n | (n << 8)) & 0x0300f00f;
+    n = (n | (n << 4)) & 0x030c30c3;
+    n = (n | (n << 2)) & 0x09249249;
+    return n;
+}
+
+std::uint64_t Wavefront::MortonKey(const Ray& ray, const double* min, const double* max) {
+    const double cells = (1 << kMortonBits) - 1;
+    std::uint64_t morton { 0 }, octant { 0 };
+    for (int axis = 0; axis < 3; axis++) {
+        double extent = max[axis] - min[axis];
+        double position = (extent > 0) ? (ray.Origin().At(axis) - min[axis]) / extent : 0;
+        std::uint64_t cell = static_cast<std::uint64_t>(position * cells);
+        morton |= SpreadBits(cell) << (2 - axis);
+        octant = (octant << 1) | ((ray.Direction().At(axis) < 0) ? 1 : 0);
+    }
+    return (octant << (3 * kMortonBits)) | morton;
+}
+
+void Wavefront::Sort(std::vector<WavefrontRay>& rays) {
+    if (rays.size() < 2) {
+        return;
+    }
+    double min[3], max[3];
+    for (int axis = 0; axis < 3; axis++) {
+        min[axis] = max[axis] = rays[0].ray.Origin().At(axis);
+    }
+    for (auto& r: rays) {
+        for (int axis = 0; axis < 3; axis++) {
+            min[axis] = std::min(min[axis], r.ray.Origin().At(axis));
+            max[axis] = std::max(max[axis], r.ray.Origin().At(axis));
+        }
+    }
+
+    keys.clear();
+    for (std::size_t i = 0; i < rays.size(); i++) {
+        keys.emplace_back(MortonKey(rays[i].ray, min, max), static_cast<std::uint32_t>(i));
+    }
+    // ties keep the order the rays were queued in
+    std::sort(keys.begin(), keys.end());
+
+    sorted.clear();
+    for (auto& key: keys) {
+        sorted.push_back(rays[key.second]);
+    }
+    rays.swap(sorted);
+}
\ No newline at end of file
@@ -1,4 +1,12 @@
+#include <map>
+#include <string>
+#include <typeinfo>
+#ifdef __GNUG__
+#include <cxxabi.h>
+#include <cstdlib>
+#endif
 #include "world.h"
+#include "group.h"
 
 const int World::kMaxReflections = 5;
 
@@ -40,48 +48,299 @@ bool World::Contains(const Light* light) const {
     return it != lights_.end();
 }
 
+static std::string TypeName(const Shape* s) {
+    const char* name = typeid(*s).name();
+#ifdef __GNUG__
+    int status { 0 };
+    char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+    if (status == 0) {
+        std::string result { demangled };
+        std::free(demangled);
+        return result;
+    }
+#endif
+    return name;
+}
+
+struct ShapeMemory {
+    std::size_t count;
+    std::size_t bytes;
+};
+
+static void CollectMemory(const Shape* s, std::map<std::string, ShapeMemory>& memory) {
+    ShapeMemory& m = memory[TypeName(s)];
+    m.count++;
+    m.bytes += s->Memory();
+    if (s->IsGroup()) {
+        for (auto child: static_cast<const ShapeGroup*>(s)->Children()) {
+            CollectMemory(child, memory);
+        }
+    }
+}
+
+void World::MemoryReport(std::ostream& os) const {
+    std::map<std::string, ShapeMemory> memory {};
+    for (auto object: objects_) {
+        CollectMemory(object, memory);
+    }
+    std::size_t count { 0 }, bytes { 0 };
+    os << "type\tshapes\tbytes\tbytes per shape" << std::endl;
+    for (auto& entry: memory) {
+        const ShapeMemory& m = entry.second;
+        os << entry.first << '\t' << m.count << '\t' << m.bytes << '\t'
+           << m.bytes / m.count << std::endl;
+        count += m.count;
+        bytes += m.bytes;
+    }
+    os << "total\t" << count << '\t' << bytes << '\t'
+       << ((count > 0) ? bytes / count : 0) << std::endl;
+    MaterialTable& materials = MaterialTable::Shared();
+    os << "materials\t" << materials.Size() << '\t' << materials.Memory() << std::endl;
+}
+
 IntersectionList World::Intersect(const Ray& ray) const {
     IntersectionList xs {};
+    Intersect(xs, ray);
+    return xs;
+}
+
+void World::Intersect(IntersectionList& xs, const Ray& ray) const {
+    bool count = TraversalStatistics::Enabled();
+    if (count) {
+        TraversalStatistics::CountRay();
+    }
+    if (accelerator_ != nullptr) {
+        accelerator_->Intersect(xs, ray);
+        return;
+    }
     std::set<const Shape *>::iterator it = objects_.begin(),
                                       end = objects_.end();
     while (it != end) {
+        if (count) {
+            TraversalStatistics::CountShapeTest(*it);
+        }
         (*it)->Intersect(xs, ray);
         it++;
     }
-    return xs;
 }
 
-const Colour World::ColourAt(const IntersectionComputation& ic, const int max_depth) const {
+void World::Intersect(IntersectionList* lists, const RayPacket& packet) const {
+    // Accelerators and the traversal statistics work one ray at a time
+    if (accelerator_ != nullptr || TraversalStatistics::Enabled()) {
+        for (int lane = 0; lane < packet.Size(); lane++) {
+            Intersect(lists[lane], packet.At(lane));
+        }
+        return;
+    }
+    for (auto object: objects_) {
+        object->IntersectPacket(lists, packet, packet.Mask());
+    }
+}
+
+void World::SetAccelerator(Accelerator* accelerator) {
+    // Use the given structure to find intersections instead of testing every
+    // object; it is built from the objects in the world now, so set it after
+    // adding them. Pass nullptr to test every object again.
+    if (accelerator != nullptr) {
+        std::vector<const Shape*> objects { objects_.begin(), objects_.end() };
+        accelerator->Build(objects);
+    }
+    accelerator_ = accelerator;
+}
+
+const Colour World::ColourAt(const IntersectionComputation& ic, const int max_depth,
+    double weight) const {
     Colour colour {};
+    const Point point = ic.OverPoint();
     for (const Light* light: lights_) {
-        Point point = ic.OverPoint();
         bool in_shadow = light->CastsShadow() ? InShadow(point, light) : false;
         colour += ic.Object()->ApplyLightAt(*light, point, ic.EyeVector(), ic.NormalVector(), in_shadow);
     }
-    Colour reflected = ReflectedColour(ic, max_depth);
-    Colour refracted = RefractedColour(ic, max_depth);
 
     // Apply Schlick approximation if the material is both transparent and
-    // reflective
-    const Material m = ic.Object()->ShapeMaterial();
+    // reflective; the reflected and refracted rays then contribute only
+    // their share of the colour
+    const Material& m = ic.Object()->ShapeMaterial();
     if (m.Reflectivity() > 0 && m.Transparency() > 0) {
         double reflectance = ic.Reflectance();
+        Colour reflected = ReflectedColour(ic, max_depth, weight * reflectance);
+        Colour refracted = RefractedColour(ic, max_depth, weight * (1 - reflectance));
         return colour + reflected * reflectance + refracted * (1 - reflectance);
     }
+    Colour reflected = ReflectedColour(ic, max_depth, weight);
+    Colour refracted = RefractedColour(ic, max_depth, weight);
     return colour + reflected + refracted;
 }
 
 const Colour World::ColourAt(const Ray& ray, const int max_depth) const {
+    return ColourAt(ray, max_depth, nullptr, 1.0);
+}
+
+const Colour World::ColourAt(const Ray& ray, const int max_depth, const Shape** object) const {
+    return ColourAt(ray, max_depth, nullptr, 1.0, object);
+}
+
+const Colour World::ColourAt(const Ray& ray, const int max_depth,
+    const MediumStack* medium, double weight, const Shape** object) const {
     Colour colour = Colour::kBlack; // black: default if there is no hit
     IntersectionList xs = Intersect(ray);
     const Intersection* hit = xs.Hit();
-    if (hit) {
+    if (object != nullptr) {
+        *object = hit ? hit->Object() : nullptr;
+    }
+    if (hit && medium != nullptr) {
+        // The objects the ray is inside of are known from its path so far
+        const IntersectionComputation ic { *hit, ray, *medium };
+        colour += ColourAt(ic, max_depth, weight);
+    }
+    else if (hit) {
         const IntersectionComputation ic { *hit, ray, &xs };
-        colour += ColourAt(ic, max_depth);
+        colour += ColourAt(ic, max_depth, weight);
     }
     return colour;
 }
 
+void World::ColourAt(const RayPacket& packet, Colour* colours, const int max_depth) const {
+    // Only the intersections are found for the whole packet: shading,
+    // shadows and secondary rays are traced one ray at a time
+    IntersectionList lists[kMaxPacketSize];
+    Intersect(lists, packet);
+    for (int lane = 0; lane < packet.Size(); lane++) {
+        colours[lane] = Colour::kBlack;
+        const Intersection* hit = lists[lane].Hit();
+        if (hit) {
+            const IntersectionComputation ic { *hit, packet.At(lane), &lists[lane] };
+            colours[lane] += ColourAt(ic, max_depth);
+        }
+    }
+}
+
+void World::ColourAt(Wavefront& wavefront, Colour* colours) const {
+    wavefront.tracing.swap(wavefront.primary);
+    TraceStage(wavefront, colours);
+    while (!wavefront.reflected.empty() || !wavefront.refracted.empty()) {
+        for (auto queue: { &wavefront.reflected, &wavefront.refracted }) {
+            wavefront.tracing.swap(*queue);
+            if (wavefront.sort_secondary) {
+                wavefront.Sort(wavefront.tracing);
+            }
+            TraceStage(wavefront, colours);
+        }
+    }
+}
+
+void World::TraceStage(Wavefront& wavefront, Colour* colours) const {
+    const std::vector<WavefrontRay>& rays = wavefront.tracing;
+    for (std::size_t first = 0; first < rays.size(); first += kMaxPacketSize) {
+        RayPacket packet {};
+        for (std::size_t i = first; i < rays.size() && packet.Add(rays[i].ray); i++) {}
+        IntersectionList lists[kMaxPacketSize];
+        Intersect(lists, packet);
+        for (int lane = 0; lane < packet.Size(); lane++) {
+            const Intersection* hit = lists[lane].Hit();
+            if (!hit) {
+                continue;
+            }
+            const WavefrontRay& ray = rays[first + lane];
+            if (ray.medium_known) {
+                const IntersectionComputation ic { *hit, ray.ray, ray.medium };
+                Shade(ic, ray, wavefront, colours);
+            }
+            else {
+                const IntersectionComputation ic { *hit, ray.ray, &lists[lane] };
+                Shade(ic, ray, wavefront, colours);
+            }
+        }
+    }
+    wavefront.tracing.clear();
+    TraceShadows(wavefront, colours);
+}
+
+void World::Shade(const IntersectionComputation& ic, const WavefrontRay& ray,
+    Wavefront& wavefront, Colour* colours) const {
+    // The same as ColourAt(ic, ...), ReflectedColour() and RefractedColour(),
+    // but lights that cast shadows and the reflected and refracted rays are
+    // queued rather than followed
+    const Point point = ic.OverPoint();
+    for (const Light* light: lights_) {
+        if (!light->CastsShadow()) {
+            colours[ray.slot] += ic.Object()->ApplyLightAt(*light, point,
+                ic.EyeVector(), ic.NormalVector(), false) * ray.weight;
+            continue;
+        }
+        Vector v = light->Position() - point;
+        wavefront.shadow.emplace_back(Ray { point, v.Normalize() }, v.Magnitude(),
+            light, ic, point, ray.slot, ray.weight);
+    }
+    if (ray.depth <= 0) {
+        return;
+    }
+
+    const Material& m = ic.Object()->ShapeMaterial();
+    double reflectivity = m.Reflectivity(), transparency = m.Transparency();
+    bool fresnel = reflectivity > 0 && transparency > 0;
+    double reflectance = fresnel ? ic.Reflectance() : 1.0;
+
+    if (!simple_floating_point_compare(reflectivity, 0)) {
+        double weight = ray.weight * reflectance * reflectivity;
+        if (weight < min_contribution_) {
+            if (TraversalStatistics::Enabled()) {
+                TraversalStatistics::CountPrunedRay();
+            }
+        }
+        else {
+            Ray reflected { ic.OverPoint(), ic.ReflectionVector() };
+            const MediumStack* medium = ic.ReflectedMedium();
+            if (medium != nullptr) {
+                wavefront.reflected.emplace_back(reflected, ray.slot, weight, ray.depth - 1, *medium);
+            }
+            else {
+                wavefront.reflected.emplace_back(reflected, ray.slot, weight, ray.depth - 1);
+            }
+        }
+    }
+
+    if (simple_floating_point_compare(transparency, 0)) {
+        return;
+    }
+    double n_ratio = ic.N1() / ic.N2();
+    double cos_i = Vector::DotProduct(ic.EyeVector(), ic.NormalVector());
+    double sin_t_squared = n_ratio*n_ratio * (1 - cos_i*cos_i);
+    if (sin_t_squared > 1) {
+        return;
+    }
+    double weight = ray.weight * (fresnel ? 1 - reflectance : 1.0) * transparency;
+    if (weight < min_contribution_) {
+        if (TraversalStatistics::Enabled()) {
+            TraversalStatistics::CountPrunedRay();
+        }
+        return;
+    }
+    double cos_t = std::sqrt(1.0 - sin_t_squared);
+    Vector direction = ic.NormalVector() * (n_ratio * cos_i - cos_t) - ic.EyeVector() * n_ratio;
+    wavefront.refracted.emplace_back(Ray { ic.UnderPoint(), direction }, ray.slot, weight,
+        ray.depth - 1, ic.RefractedMedium());
+}
+
+void World::TraceShadows(Wavefront& wavefront, Colour* colours) const {
+    // As InShadow(), for a packet of shadow rays at a time
+    const std::vector<ShadowRay>& rays = wavefront.shadow;
+    for (std::size_t first = 0; first < rays.size(); first += kMaxPacketSize) {
+        RayPacket packet {};
+        for (std::size_t i = first; i < rays.size() && packet.Add(rays[i].ray); i++) {}
+        IntersectionList lists[kMaxPacketSize];
+        Intersect(lists, packet);
+        for (int lane = 0; lane < packet.Size(); lane++) {
+            const ShadowRay& ray = rays[first + lane];
+            const Intersection* hit = lists[lane].ShadowHit();
+            bool in_shadow = hit && hit->Distance() < ray.distance;
+            colours[ray.slot] += ray.object->ApplyLightAt(*ray.light, ray.point,
+                ray.eye_vector, ray.normal_vector, in_shadow) * ray.weight;
+        }
+    }
+    wavefront.shadow.clear();
+}
+
 bool World::InShadow(const Point& point, const Light* light) const {
     Vector v = light->Position() - point;
     double distance = v.Magnitude();
@@ -108,7 +367,8 @@ bool World::InShadow(const Point& point) const {
     return result;
 }
 
-const Colour World::ReflectedColour(const IntersectionComputation& ic, const int max_depth) const {
+const Colour World::ReflectedColour(const IntersectionComputation& ic, const int max_depth,
+    double weight) const {
     if (max_depth <= 0) {
         // Go no further processing reflections
         return Colour::kBlack;
@@ -119,18 +379,36 @@ const Colour World::ReflectedColour(const IntersectionComputation& ic, const int
         return Colour::kBlack;
     }
 
+    // Skip the ray if it would add too little to the image
+    weight *= reflectivity;
+    if (weight < min_contribution_) {
+        if (TraversalStatistics::Enabled()) {
+            TraversalStatistics::CountPrunedRay();
+        }
+        return Colour::kBlack;
+    }
+
     Ray reflected_ray { ic.OverPoint(), ic.ReflectionVector() };
-    // Reduce max_depth to prevent endless recursion of reflected rays
-    const Colour colour = ColourAt(reflected_ray, max_depth - 1);
+    // Reduce max_depth to prevent endless recursion of reflected rays. The
+    // reflected ray stays in the medium the ray arrived through, if known.
+    const Colour colour = ColourAt(reflected_ray, max_depth - 1, ic.ReflectedMedium(), weight);
     return colour * reflectivity;
 }
 
-const Colour World::RefractedColour(const IntersectionComputation& ic, const int max_depth) const {
+const Colour World::RefractedColour(const IntersectionComputation& ic, const int max_depth,
+    double weight) const {
     // Snell's Law: given two angles, the angle of the incoming ray (Θi) and
     // the angle of the refracted ray (Θt), then sin(Θi)/sin(Θt) = n2/n1, where
     // n1,n2 are the refractive indices of the materials on either side of the
     // ray-object intersection.
 
+    // Return black for opaque objects and at the maximum depth, before
+    // finding the refractive indices
+    double transparency = ic.Object()->ShapeMaterial().Transparency();
+    if (max_depth == 0 || simple_floating_point_compare(transparency, 0)) {
+        return Colour::kBlack;
+    }
+
     // The ratio of n1/n2
     double n_ratio = ic.N1() / ic.N2();
 
@@ -141,11 +419,17 @@ const Colour World::RefractedColour(const IntersectionComputation& ic, const int
     // sin(Θ)^2 + cos(Θ)^2 = 1
     double sin_t_squared = n_ratio*n_ratio * (1 - cos_i*cos_i);
 
-    double transparency = ic.Object()->ShapeMaterial().Transparency();
+    // Return black for total internal reflection
+    if (sin_t_squared > 1) {
+        return Colour::kBlack;
+    }
 
-    // Return black for these cases:
-    if (sin_t_squared > 1 || max_depth == 0 ||
-            simple_floating_point_compare(transparency, 0)) {
+    // Skip the ray if it would add too little to the image
+    weight *= transparency;
+    if (weight < min_contribution_) {
+        if (TraversalStatistics::Enabled()) {
+            TraversalStatistics::CountPrunedRay();
+        }
         return Colour::kBlack;
     }
 
@@ -160,6 +444,8 @@ const Colour World::RefractedColour(const IntersectionComputation& ic, const int
     Ray refracted_ray { ic.UnderPoint(), direction };
 
     // Find the colour of the refracted ray and multiply by the transparency
-    // of the material to account for its opacity
-    return ColourAt(refracted_ray, max_depth - 1) * transparency;
+    // of the material to account for its opacity. The refracted ray has
+    // entered or left the object.
+    const MediumStack medium = ic.RefractedMedium();
+    return ColourAt(refracted_ray, max_depth - 1, &medium, weight) * transparency;
 }
\ No newline at end of file
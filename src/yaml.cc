@@ -0,0 +1,423 @@
+#include <cstdlib>   // for strtod
+#include <stdexcept>
+#include "yaml.h"
+
+const YamlNode* YamlNode::Find(const std::string& key) const {
+    const YamlNode* found { nullptr };
+    for (const auto& entry: entries) {
+        if (entry.first == key) {
+            found = &entry.second;
+        }
+    }
+    return found;
+}
+
+double YamlNode::Number() const {
+    if (IsScalar() && !text.empty()) {
+        char* end { nullptr };
+        double number = std::strtod(text.c_str(), &end);
+        if (*end == '\0') {
+            return number;
+        }
+    }
+    Fail("Expected a number");
+}
+
+bool YamlNode::Boolean() const {
+    if (IsScalar()) {
+        if (text == "true" || text == "yes") {
+            return true;
+        }
+        if (text == "false" || text == "no") {
+            return false;
+        }
+    }
+    Fail("Expected true or false");
+}
+
+void YamlNode::Fail(const std::string& message) const {
+    throw std::invalid_argument("Line " + std::to_string(line) + ": " + message);
+}
+
+// Whether a quote at the position opens a quoted scalar rather than being
+// part of a plain one, e.g. "it's"
+static bool OpensQuote(const std::string& line, std::size_t position) {
+    if (position == 0) {
+        return true;
+    }
+    char before = line[position - 1];
+    return before == ' ' || before == '[' || before == '{' || before == ',' ||
+        before == ':' || before == '-';
+}
+
+// Reads lines until one has something other than a comment, leaving
+// position_ at its first character
+bool YamlReader::NextLine() {
+    has_line_ = false;
+    std::string line {};
+    while (std::getline(is_, line)) {
+        number_++;
+        // strip the comment, which starts at a # at the start of the line or
+        // after a space, outside quotes
+        char quote { '\0' };
+        std::size_t end = line.size();
+        for (std::size_t i = 0; i < line.size(); i++) {
+            char c = line[i];
+            if (quote != '\0') {
+                if (c == '\\' && quote == '"') {
+                    i++;
+                }
+                else if (c == quote) {
+                    quote = '\0';
+                }
+            }
+            else if ((c == '"' || c == '\'') && OpensQuote(line, i)) {
+                quote = c;
+            }
+            else if (c == '#' && (i == 0 || line[i - 1] == ' ' || line[i - 1] == '\t')) {
+                end = i;
+                break;
+            }
+        }
+        while (end > 0 && (line[end - 1] == ' ' || line[end - 1] == '\t' ||
+                line[end - 1] == '\r')) {
+            end--;
+        }
+        line.resize(end);
+        std::size_t indent = line.find_first_not_of(' ');
+        if (indent == std::string::npos || line == "---") {
+            continue;
+        }
+        if (line[indent] == '\t') {
+            line_ = line;
+            position_ = indent;
+            Fail("Tabs can't be used for indentation");
+        }
+        if (line == "...") {
+            return false;
+        }
+        line_ = line;
+        position_ = indent;
+        has_line_ = true;
+        return true;
+    }
+    return false;
+}
+
+bool YamlReader::AtDash() const {
+    return !AtEnd() && Current() == '-' &&
+        (position_ + 1 == line_.size() || line_[position_ + 1] == ' ');
+}
+
+// Whether the rest of the line is a block mapping entry, key: value
+bool YamlReader::AtKey() const {
+    if (AtEnd() || Current() == '[' || Current() == '{') {
+        return false;
+    }
+    std::size_t i = position_;
+    if (Current() == '"' || Current() == '\'') {
+        char quote = Current();
+        for (i++; i < line_.size() && line_[i] != quote; i++) {
+            if (line_[i] == '\\' && quote == '"') {
+                i++;
+            }
+        }
+        i = line_.find_first_not_of(' ', i + 1);
+        return i != std::string::npos && line_[i] == ':';
+    }
+    for (; i < line_.size(); i++) {
+        if (line_[i] == ':' && (i + 1 == line_.size() || line_[i + 1] == ' ')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void YamlReader::SkipSpaces() {
+    while (!AtEnd() && Current() == ' ') {
+        position_++;
+    }
+}
+
+// Within a flow collection, line breaks are spaces
+void YamlReader::SkipFlowSpace() {
+    SkipSpaces();
+    while (AtEnd()) {
+        if (!NextLine()) {
+            Fail("Unterminated [ or {");
+        }
+        SkipSpaces();
+    }
+}
+
+void YamlReader::Fail(const std::string& message) const {
+    throw std::invalid_argument("Line " + std::to_string(number_) + ": " + message);
+}
+
+// Parses the value starting at position_, whose column it takes as its
+// indentation, and the lines below it that are indented further
+YamlNode YamlReader::ParseBlock() {
+    if (AtDash()) {
+        return ParseBlockSequence();
+    }
+    if (AtKey()) {
+        return ParseBlockMapping();
+    }
+    return ParseInline();
+}
+
+YamlNode YamlReader::ParseBlockSequence() {
+    std::size_t column = position_;
+    YamlNode sequence { YamlNode::Kind::kSequence, number_ };
+    while (has_line_ && position_ == column && AtDash()) {
+        sequence.items.push_back(ParseSequenceItem(column));
+    }
+    if (has_line_ && position_ > column) {
+        Fail("Unexpected indentation");
+    }
+    return sequence;
+}
+
+// Parses the item after the dash at position_; its value may start on the
+// same line, e.g. "- add: camera", where it is indented to where it starts
+YamlNode YamlReader::ParseSequenceItem(std::size_t column) {
+    int line = number_;
+    position_++;
+    SkipSpaces();
+    if (!AtEnd()) {
+        return ParseBlock();
+    }
+    if (NextLine() && position_ > column) {
+        return ParseBlock();
+    }
+    return YamlNode { YamlNode::Kind::kNull, line };
+}
+
+YamlNode YamlReader::ParseBlockMapping() {
+    std::size_t column = position_;
+    YamlNode mapping { YamlNode::Kind::kMapping, number_ };
+    while (has_line_ && position_ == column) {
+        if (!AtKey()) {
+            Fail("Expected key: value");
+        }
+        int line = number_;
+        std::string key {};
+        if (Current() == '"' || Current() == '\'') {
+            key = ParseQuoted().text;
+            SkipSpaces();
+        }
+        else {
+            std::size_t colon = position_;
+            while (!(line_[colon] == ':' && (colon + 1 == line_.size() ||
+                    line_[colon + 1] == ' '))) {
+                colon++;
+            }
+            key = line_.substr(position_, colon - position_);
+            key.erase(key.find_last_not_of(' ') + 1);
+            position_ = colon;
+        }
+        position_++; // past the colon
+        SkipSpaces();
+        if (!AtEnd()) {
+            mapping.entries.emplace_back(key, ParseInline());
+        }
+        // the value is on the following lines, indented further, or a
+        // sequence at the same indentation
+        else if (NextLine() && (position_ > column || (position_ == column && AtDash()))) {
+            mapping.entries.emplace_back(key, ParseBlock());
+        }
+        else {
+            mapping.entries.emplace_back(key, YamlNode { YamlNode::Kind::kNull, line });
+        }
+    }
+    if (has_line_ && position_ > column) {
+        Fail("Unexpected indentation");
+    }
+    return mapping;
+}
+
+// Parses a value that ends on the line it starts on, unless it is a flow
+// collection, and moves on to the next line
+YamlNode YamlReader::ParseInline() {
+    YamlNode value = Current() == '[' || Current() == '{' || Current() == '"' ||
+        Current() == '\'' ? ParseFlow() : ParsePlain(false);
+    ExpectLineEnd();
+    NextLine();
+    return value;
+}
+
+void YamlReader::ExpectLineEnd() {
+    SkipSpaces();
+    if (!AtEnd()) {
+        Fail("Unexpected text: " + line_.substr(position_));
+    }
+}
+
+YamlNode YamlReader::ParseFlow() {
+    SkipFlowSpace();
+    int line = number_;
+    if (Current() == '[') {
+        position_++;
+        YamlNode sequence { YamlNode::Kind::kSequence, line };
+        SkipFlowSpace();
+        while (Current() != ']') {
+            sequence.items.push_back(ParseFlow());
+            SkipFlowSpace();
+            if (Current() == ',') {
+                position_++;
+                SkipFlowSpace();
+            }
+            else if (Current() != ']') {
+                Fail("Expected , or ]");
+            }
+        }
+        position_++;
+        return sequence;
+    }
+    if (Current() == '{') {
+        position_++;
+        YamlNode mapping { YamlNode::Kind::kMapping, line };
+        SkipFlowSpace();
+        while (Current() != '}') {
+            YamlNode key = ParseFlow();
+            if (!key.IsScalar()) {
+                Fail("Expected a key");
+            }
+            SkipFlowSpace();
+            if (Current() != ':') {
+                Fail("Expected :");
+            }
+            position_++;
+            mapping.entries.emplace_back(key.text, ParseFlow());
+            SkipFlowSpace();
+            if (Current() == ',') {
+                position_++;
+                SkipFlowSpace();
+            }
+            else if (Current() != '}') {
+                Fail("Expected , or }");
+            }
+        }
+        position_++;
+        return mapping;
+    }
+    if (Current() == '"' || Current() == '\'') {
+        return ParseQuoted();
+    }
+    return ParsePlain(true);
+}
+
+YamlNode YamlReader::ParseQuoted() {
+    YamlNode scalar { YamlNode::Kind::kScalar, number_ };
+    char quote = Current();
+    for (position_++; !AtEnd(); position_++) {
+        char c = Current();
+        if (c == quote) {
+            // '' is a quote within single quotes
+            if (quote == '\'' && position_ + 1 < line_.size() && line_[position_ + 1] == '\'') {
+                scalar.text.push_back('\'');
+                position_++;
+                continue;
+            }
+            position_++;
+            return scalar;
+        }
+        if (c == '\\' && quote == '"' && position_ + 1 < line_.size()) {
+            c = line_[++position_];
+            switch (c) {
+                case 'n': c = '\n'; break;
+                case 't': c = '\t'; break;
+                case '"': case '\\': case '/': break;
+                default: Fail(std::string { "Unknown escape: \\" } + c);
+            }
+        }
+        scalar.text.push_back(c);
+    }
+    Fail("Unterminated string");
+}
+
+// A plain scalar runs to the end of the line or, in a flow collection, to
+// the next , ] } or ": "
+YamlNode YamlReader::ParsePlain(bool flow) {
+    YamlNode scalar { YamlNode::Kind::kScalar, number_ };
+    std::size_t start = position_;
+    for (; !AtEnd(); position_++) {
+        char c = Current();
+        if (flow && (c == ',' || c == ']' || c == '}' || (c == ':' &&
+                (position_ + 1 == line_.size() || line_[position_ + 1] == ' ')))) {
+            break;
+        }
+    }
+    scalar.text = line_.substr(start, position_ - start);
+    scalar.text.erase(scalar.text.find_last_not_of(' ') + 1);
+    if (scalar.text.empty() || scalar.text == "~" || scalar.text == "null") {
+        scalar.kind = YamlNode::Kind::kNull;
+        scalar.text.clear();
+    }
+    return scalar;
+}
+
+bool YamlReader::Next(YamlNode& item) {
+    if (state_ == State::kStart) {
+        if (!NextLine()) {
+            state_ = State::kDone;
+            return false;
+        }
+        column_ = position_;
+        if (AtDash()) {
+            state_ = State::kBlock;
+        }
+        else if (Current() == '[') {
+            state_ = State::kFlow;
+            position_++;
+        }
+        else {
+            Fail("Expected a list");
+        }
+    }
+    if (state_ == State::kBlock) {
+        if (!has_line_) {
+            state_ = State::kDone;
+            return false;
+        }
+        if (position_ != column_ || !AtDash()) {
+            Fail("Expected a list item");
+        }
+        item = ParseSequenceItem(column_);
+        return true;
+    }
+    if (state_ == State::kFlow) {
+        SkipFlowSpace();
+        if (Current() == ']') {
+            position_++;
+            ExpectLineEnd();
+            if (NextLine()) {
+                Fail("Unexpected text after the list");
+            }
+            state_ = State::kDone;
+            return false;
+        }
+        item = ParseFlow();
+        SkipFlowSpace();
+        if (Current() == ',') {
+            position_++;
+        }
+        else if (Current() != ']') {
+            Fail("Expected , or ]");
+        }
+        return true;
+    }
+    return false;
+}
+
+YamlNode YamlReader::Document() {
+    if (state_ != State::kStart || !NextLine()) {
+        return YamlNode {};
+    }
+    state_ = State::kDone;
+    YamlNode document = ParseBlock();
+    if (has_line_) {
+        Fail("Unexpected text");
+    }
+    return document;
+}
\ No newline at end of file
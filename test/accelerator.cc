@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "accelerator.h"
+#include "grid.h"
+#include "octree.h"
+
+#include "sphere.h"
+#include "plane.h"
+#include "group.h"
+#include "transformations.h"
+
+// The tests every structure must pass; see test/grid.cc and test/octree.cc
+// for those of each structure
+template <typename T>
+class AcceleratorTest: public testing::Test {
+    protected:
+        std::vector<Sphere> spheres_;
+        std::vector<const Shape*> objects_ {};
+
+        void SetUp() override {
+            // a 4*4*4 cube of spheres
+            spheres_.resize(64);
+            for (std::size_t i = 0; i < spheres_.size(); i++) {
+                spheres_[i].SetTransform(
+                    Transformation().Translate(3 * (i % 4), 3 * ((i / 4) % 4), 3 * (i / 16))
+                );
+                objects_.push_back(&spheres_[i]);
+            }
+        }
+};
+
+using Structures = testing::Types<UniformGrid, Octree>;
+TYPED_TEST_SUITE(AcceleratorTest, Structures);
+
+TYPED_TEST(AcceleratorTest, IntersectingARayWithTheStructure) {
+    TypeParam structure {};
+    structure.Build(this->objects_);
+
+    // along a row of four spheres, from outside the structure
+    Ray r { Point { -5, 3, 3 }, Vector { 1, 0, 0 } };
+    IntersectionList xs {};
+    ASSERT_TRUE(structure.Intersect(xs, r));
+    ASSERT_EQ(xs.Size(), 8);
+    ASSERT_EQ(xs.Hit()->Object(), &this->spheres_[20]);
+    ASSERT_DOUBLE_EQ(xs.Hit()->Distance(), 4);
+
+    // intersections behind the ray's origin are also included
+    Ray inside { Point { 4.5, 3, 3 }, Vector { -1, 0, 0 } };
+    IntersectionList ys {};
+    ASSERT_TRUE(structure.Intersect(ys, inside));
+    ASSERT_EQ(ys.Size(), 8);
+    ASSERT_EQ(ys.Hit()->Object(), &this->spheres_[21]);
+
+    Ray miss { Point { 1.5, 1.5, -5 }, Vector { 0, 0, 1 } };
+    IntersectionList zs {};
+    ASSERT_FALSE(structure.Intersect(zs, miss));
+    ASSERT_EQ(zs.Size(), 0);
+}
+
+TYPED_TEST(AcceleratorTest, IntersectingAShapeThatOverlapsSeveralRegions) {
+    Sphere big {};
+    big.SetTransform(Transformation().Scale(4).Translate(4.5, 4.5, 4.5));
+    this->objects_.push_back(&big);
+    TypeParam structure {};
+    structure.Build(this->objects_);
+
+    Ray r { Point { 4.5, 4.5, -10 }, Vector { 0, 0, 1 } };
+    // the big sphere is only tested once by each ray
+    for (int ray = 0; ray < 2; ray++) {
+        IntersectionList xs {};
+        ASSERT_TRUE(structure.Intersect(xs, r));
+        int count { 0 };
+        for (auto i: xs) {
+            if (i->Object() == &big) {
+                count++;
+            }
+        }
+        ASSERT_EQ(count, 2);
+    }
+}
+
+TYPED_TEST(AcceleratorTest, IntersectingWithSeveralStructuresInTurn) {
+    std::vector<const Shape*> row { this->objects_.begin(), this->objects_.begin() + 4 };
+    TypeParam whole {}, part {};
+    whole.Build(this->objects_);
+    part.Build(row);
+
+    Ray r { Point { -5, 0, 0 }, Vector { 1, 0, 0 } };
+    for (int ray = 0; ray < 2; ray++) {
+        IntersectionList xs {}, ys {};
+        ASSERT_TRUE(whole.Intersect(xs, r));
+        ASSERT_EQ(xs.Size(), 8);
+        ASSERT_TRUE(part.Intersect(ys, r));
+        ASSERT_EQ(ys.Size(), 8);
+    }
+
+    // rebuilding a structure from fewer shapes
+    whole.Build(row);
+    IntersectionList zs {};
+    ASSERT_TRUE(whole.Intersect(zs, r));
+    ASSERT_EQ(zs.Size(), 8);
+}
+
+TYPED_TEST(AcceleratorTest, IntersectingUnboundedShapesAndGroups) {
+    Plane floor {};
+    floor.SetTransform(Transformation().Translate(0, -2, 0));
+    ShapeGroup group {}, transformed {};
+    Sphere s1 {}, s2 {};
+    group << &s1;
+    transformed << &s2;
+    transformed.SetTransform(Transformation().Translate(20, 0, 0));
+    std::vector<const Shape*> objects { &floor, &group, &transformed };
+
+    TypeParam structure {};
+    structure.Build(objects);
+    // the group is replaced by its child, but the transformed group is not
+    ASSERT_EQ(structure.NShapes(), 3);
+
+    Ray r { Point { 0, 5, 0 }, Vector { 0, -1, 0 } };
+    IntersectionList xs {};
+    ASSERT_TRUE(structure.Intersect(xs, r));
+    ASSERT_EQ(xs.Size(), 3);
+    ASSERT_EQ(xs.Hit()->Object(), &s1);
+
+    Ray r2 { Point { 20, 5, 0 }, Vector { 0, -1, 0 } };
+    IntersectionList ys {};
+    ASSERT_TRUE(structure.Intersect(ys, r2));
+    ASSERT_EQ(ys.Size(), 3);
+    ASSERT_EQ(ys.Hit()->Object(), &s2);
+}
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include "allocations.h"
+
+#include "camera.h"
+#include "world.h"
+#include "chapter-07-scene.h"
+
+TEST(AllocationsTest, CountingAllocations) {
+    ASSERT_TRUE(AllocationCounter::Enabled());
+    AllocationCounter::Reset();
+    // called directly, as the compiler may leave out new expressions whose
+    // results aren't used
+    void* i = ::operator new(sizeof(int));
+    void* d = ::operator new[](8 * sizeof(double));
+    ASSERT_EQ(AllocationCounter::Count(), 2);
+    ASSERT_EQ(AllocationCounter::Bytes(), sizeof(int) + 8 * sizeof(double));
+    ::operator delete(i);
+    ::operator delete[](d);
+    ASSERT_EQ(AllocationCounter::Count(), 2);
+}
+
+// The scene rendered by scripts/challenges/chapter-07-scene.cc
+class Chapter7SceneTest: public testing::Test {
+    protected:
+        Sphere floor_ {}, left_wall_ {}, right_wall_ {};
+        Sphere large_ {}, smaller_ {}, smallest_ {};
+        Light light_ { WorldLight(1) };
+        World world_ {};
+
+        void SetUp() override {
+            floor_.SetTransform(Transformation().Scale(10, 0.01, 10));
+            left_wall_.SetTransform(
+                Transformation().Scale(10, 0.01, 10).RotateX(M_PI / 2)
+                .RotateY(-M_PI / 4).Translate(0, 0, 5)
+            );
+            right_wall_.SetTransform(
+                Transformation().Scale(10, 0.01, 10).RotateX(M_PI / 2)
+                .RotateY(M_PI / 4).Translate(0, 0, 5)
+            );
+            for (Sphere* s: { &floor_, &left_wall_, &right_wall_ }) {
+                s->SetMaterial(FloorMaterial());
+            }
+            // Sphere's copy constructor doesn't copy the transform or material
+            large_.SetTransform(LargeSphere(1).Transform());
+            large_.SetMaterial(LargeSphere(1).ShapeMaterial());
+            smaller_.SetTransform(SmallerSphere(1).Transform());
+            smaller_.SetMaterial(SmallerSphere(1).ShapeMaterial());
+            smallest_.SetTransform(SmallestSphere(1).Transform());
+            smallest_.SetMaterial(SmallestSphere(1).ShapeMaterial());
+            for (Sphere* s: { &floor_, &left_wall_, &right_wall_, &large_, &smaller_, &smallest_ }) {
+                world_.Add(s);
+            }
+            world_.Add(&light_);
+        }
+};
+
+TEST_F(Chapter7SceneTest, RenderingWithoutAllocatingPerPixel) {
+    Camera camera { 100, 50, M_PI / 3 };
+    camera.SetTransform(CameraTransform(1));
+    Colour colour {};
+    int lit { 0 };
+
+    // warm up: the first rays fill the pools that later rays reuse
+    for (int column = 0; column < camera.Horizontal(); column++) {
+        colour = world_.ColourAt(camera.RayAt(column, camera.Vertical() / 2));
+    }
+
+    AllocationCounter::Reset();
+    for (int row = 0; row < camera.Vertical(); row++) {
+        for (int column = 0; column < camera.Horizontal(); column++) {
+            colour = world_.ColourAt(camera.RayAt(column, row));
+            if (colour != Colour::kBlack) {
+                lit++;
+            }
+        }
+    }
+    ASSERT_EQ(AllocationCounter::Count(), 0);
+    // make sure the scene was actually rendered
+    ASSERT_GT(lit, camera.Horizontal() * camera.Vertical() / 2);
+}
\ No newline at end of file
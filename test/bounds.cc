@@ -344,4 +344,47 @@ TEST(BoundsTest, SplittingAZWideCube) {
     ASSERT_EQ(partition[0].Max(), Point(5, 3, 2));
     ASSERT_EQ(partition[1].Min(), Point(-1, -2, 2));
     ASSERT_EQ(partition[1].Max(), Point(5, 3, 7));
+}
+
+TEST(BoundsTest, FindingTheSurfaceAreaOfABox) {
+    BoundingBox box { Point { -1, -2, -3 }, Point { 1, 2, 3 } };
+    ASSERT_DOUBLE_EQ(box.SurfaceArea(), 2 * (2*4 + 4*6 + 6*2));
+}
+
+TEST(BoundsTest, FindingTheSurfaceAreaOfEmptyAndUnboundedBoxes) {
+    BoundingBox empty {},
+                unbounded { Point { -kBBInfinity, 0, -kBBInfinity }, Point { kBBInfinity, 0, kBBInfinity } };
+    ASSERT_EQ(empty.SurfaceArea(), 0);
+    ASSERT_TRUE(std::isinf(unbounded.SurfaceArea()));
+}
+
+// On a hit the interval is narrowed to where the ray is inside the box, and
+// boxes outside the given interval are missed
+TEST(BoundsTest, IntersectingABoundingBoxWithinAnInterval) {
+    BoundingBox box { Point { -1, -1, -1 }, Point { 1, 1, 1 } };
+    Ray r { Point { 0, 0, -5 }, Vector { 0, 0, 1 } };
+    double tmin { -kBBInfinity }, tmax { kBBInfinity };
+    ASSERT_TRUE(box.Intersects(r, tmin, tmax));
+    ASSERT_DOUBLE_EQ(tmin, 4);
+    ASSERT_DOUBLE_EQ(tmax, 6);
+
+    tmin = 0;
+    tmax = 3;
+    ASSERT_FALSE(box.Intersects(r, tmin, tmax));
+    tmin = 5;
+    tmax = 10;
+    ASSERT_TRUE(box.Intersects(r, tmin, tmax));
+    ASSERT_DOUBLE_EQ(tmin, 5);
+    ASSERT_DOUBLE_EQ(tmax, 6);
+}
+
+// A ray lying in the plane of a face gives NaN distances for that axis, which
+// must not turn a hit into a miss
+TEST(BoundsTest, IntersectingARayLyingInAFaceOfABoundingBox) {
+    BoundingBox box { Point { -1, -1, -1 }, Point { 1, 1, 1 } };
+    Ray r { Point { 1, 0, -5 }, Vector { 0, 0, 1 } };
+    double tmin { -kBBInfinity }, tmax { kBBInfinity };
+    ASSERT_TRUE(box.Intersects(r, tmin, tmax));
+    ASSERT_DOUBLE_EQ(tmin, 4);
+    ASSERT_DOUBLE_EQ(tmax, 6);
 }
\ No newline at end of file
@@ -1,6 +1,11 @@
 #define _USE_MATH_DEFINES // for M_PI
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <cmath>
+#include <cstdio>
+#include <limits>
+#include <sstream>
+#include <string>
 #include "camera.h"
 #include "matrix.h"
 #include "ray.h"
@@ -8,8 +13,12 @@
 #include "utils.h"
 #include "transformations.h"
 #include "sphere.h"
+#include "plane.h"
 #include "material.h"
 #include "canvas.h"
+#include "wavefront.h"
+#include "sampler.h"
+#include "checkpoint.h"
 
 /*
 Scenario: Constructing a camera
@@ -157,4 +166,459 @@ TEST(CameraTest, RenderingAWorldWithACamera) {
     ASSERT_TRUE(simple_floating_point_compare(actual.Red(), expected.Red()));
     ASSERT_TRUE(simple_floating_point_compare(actual.Green(), expected.Green()));
     ASSERT_TRUE(simple_floating_point_compare(actual.Blue(), expected.Blue()));
+}
+
+// Rendering with ray packets of each size gives the same image as rendering
+// one ray at a time; 11 pixels is not a multiple of any tile size
+TEST(CameraTest, RenderingAWorldWithRayPackets) {
+    // Set up world, see p. 92
+    World default_world {};
+
+    Point position { -10, 10, -10 };
+    Colour intensity { 1, 1, 1 };
+    Light light { position, intensity };
+    default_world.Add(&light);
+
+    Sphere sphere1 {};
+    Colour c1 { 0.8, 1.0, 0.6 };
+    Material material1 { c1, 0.1, 0.7, 0.2, 200.0 };
+    sphere1.SetMaterial(material1);
+    default_world.Add(&sphere1);
+
+    Sphere sphere2 {};
+    Matrix t2 = Transformation().Scale(0.5, 0.5, 0.5);
+    sphere2.SetTransform(t2);
+    default_world.Add(&sphere2);
+
+    Camera c { 11, 11, M_PI / 2 };
+
+    Point from { 0, 0, -5 },
+          to { 0, 0, 0 };
+    Vector up { 0, 1, 0 };
+    ViewTransform vt { from, to, up };
+    c.SetTransform(vt);
+
+    Canvas expected = c.Render(default_world);
+    for (int size: { 4, 8, 16 }) {
+        Canvas image = c.RenderPackets(default_world, size);
+        for (int row = 0; row < 11; row++) {
+            for (int column = 0; column < 11; column++) {
+                ASSERT_EQ(image.At(row, column), expected.At(row, column));
+            }
+        }
+    }
+    ASSERT_THROW(c.RenderPackets(default_world, 5), std::invalid_argument);
+}
+
+// Rendering a stage at a time gives the same image as following each ray
+// recursively, up to rounding, including reflected and refracted rays
+TEST(CameraTest, RenderingAWorldWithAWavefront) {
+    World world {};
+    Light light { Point { -10, 10, -10 }, Colour { 1, 1, 1 } };
+    world.Add(&light);
+
+    Plane floor {};
+    floor.SetTransform(Transformation().Translate(0, -1, 0));
+    floor.SetMaterial(Material().Reflectivity(0.5));
+    world.Add(&floor);
+
+    Sphere glass = GlassySphere();
+    glass.SetMaterial(Material().Transparency(0.9).RefractiveIndex(1.5).Reflectivity(0.9));
+    world.Add(&glass);
+
+    Sphere inner {};
+    inner.SetTransform(Transformation().Scale(0.5, 0.5, 0.5));
+    inner.SetMaterial(Material().Surface(Colour { 1, 0.2, 0.2 }));
+    world.Add(&inner);
+
+    Camera c { 21, 11, M_PI / 2 };
+    c.SetTransform(ViewTransform { Point { 0, 1, -5 }, Point { 0, 0, 0 }, Vector { 0, 1, 0 } });
+
+    Canvas expected = c.Render(world);
+    for (bool sort_secondary: { true, false }) {
+        Canvas image = c.RenderWavefront(world, sort_secondary);
+        for (int row = 0; row < 11; row++) {
+            for (int column = 0; column < 21; column++) {
+                Colour a = image.At(row, column), b = expected.At(row, column);
+                ASSERT_NEAR(a.Red(), b.Red(), 1e-9);
+                ASSERT_NEAR(a.Green(), b.Green(), 1e-9);
+                ASSERT_NEAR(a.Blue(), b.Blue(), 1e-9);
+            }
+        }
+    }
+}
+
+// Secondary rays are ordered by the octant of their direction, then by the
+// position of their origin along a Morton curve
+TEST(CameraTest, SortingSecondaryRaysForCoherence) {
+    Wavefront wavefront {};
+    std::vector<WavefrontRay> rays {};
+    rays.emplace_back(Ray { Point { 1, 1, 1 }, Vector { 0, 1, 0 } }, 0, 1.0, 1);
+    rays.emplace_back(Ray { Point { 0, 0, 0 }, Vector { 0, -1, 0 } }, 1, 1.0, 1);
+    rays.emplace_back(Ray { Point { 0, 0, 0 }, Vector { 0, 1, 0 } }, 2, 1.0, 1);
+    rays.emplace_back(Ray { Point { 1, 0, 0 }, Vector { 0, 1, 0 } }, 3, 1.0, 1);
+    rays.emplace_back(Ray { Point { 0, 1, 0 }, Vector { 0, 1, 0 } }, 4, 1.0, 1);
+    wavefront.Sort(rays);
+    std::vector<int> expected { 2, 4, 3, 0, 1 };
+    for (int i = 0; i < rays.size(); i++) {
+        ASSERT_EQ(expected[i], rays[i].slot);
+    }
+}
+
+// Only the pixels on the edge of the sphere are refined: the background
+// corner takes one ray, the edge more, and none more than the limit
+TEST(CameraTest, RenderingAWorldAdaptively) {
+    // Set up world, see p. 92
+    World default_world {};
+
+    Point position { -10, 10, -10 };
+    Colour intensity { 1, 1, 1 };
+    Light light { position, intensity };
+    default_world.Add(&light);
+
+    Sphere sphere1 {};
+    Colour c1 { 0.8, 1.0, 0.6 };
+    Material material1 { c1, 0.1, 0.7, 0.2, 200.0 };
+    sphere1.SetMaterial(material1);
+    default_world.Add(&sphere1);
+
+    Camera c { 11, 11, M_PI / 2 };
+    c.SetTransform(ViewTransform { Point { 0, 0, -5 }, Point { 0, 0, 0 }, Vector { 0, 1, 0 } });
+
+    Ray centre = c.RayThrough(5.5, 5.5), expected = c.RayAt(5, 5);
+    ASSERT_EQ(expected.Origin(), centre.Origin());
+    ASSERT_EQ(expected.Direction(), centre.Direction());
+
+    std::vector<int> samples {};
+    Canvas image = c.RenderAdaptive(default_world, 9, &samples);
+    ASSERT_EQ(121, samples.size());
+    ASSERT_EQ(1, samples[0]);
+    ASSERT_EQ(c.Render(default_world).At(0, 0), image.At(0, 0));
+    int refined { 0 };
+    for (int n: samples) {
+        ASSERT_GE(n, 1);
+        ASSERT_LE(n, 9);
+        refined += (n > 1) ? 1 : 0;
+    }
+    ASSERT_GT(refined, 0);
+    ASSERT_LT(refined, 121);
+}
+
+// Each pattern places its samples within the pixel, the same way each time;
+// four Sobol or stratified samples put one in each quarter of the pixel
+TEST(CameraTest, PlacingSamplesWithinAPixel) {
+    for (auto pattern: { SamplePattern::kRandom, SamplePattern::kStratified,
+            SamplePattern::kHalton, SamplePattern::kSobol }) {
+        PixelSampler sampler { 4, pattern };
+        int quarters[4] = { 0, 0, 0, 0 };
+        for (int i = 0; i < 4; i++) {
+            double x, y, again_x, again_y;
+            sampler.Sample(3, 7, i, x, y);
+            sampler.Sample(3, 7, i, again_x, again_y);
+            ASSERT_EQ(x, again_x);
+            ASSERT_EQ(y, again_y);
+            ASSERT_TRUE(x >= 0 && x < 1 && y >= 0 && y < 1);
+            quarters[(x < 0.5 ? 0 : 1) + (y < 0.5 ? 0 : 2)]++;
+        }
+        if (pattern == SamplePattern::kStratified || pattern == SamplePattern::kSobol) {
+            for (int q = 0; q < 4; q++) {
+                ASSERT_EQ(1, quarters[q]);
+            }
+        }
+    }
+    ASSERT_THROW(PixelSampler(0), std::invalid_argument);
+    ASSERT_THROW(PixelSampler::ParsePattern("jittered"), std::invalid_argument);
+}
+
+TEST(CameraTest, WeightingSamplesWithAFilter) {
+    PixelSampler box { 1, SamplePattern::kSobol, PixelFilter::kBox },
+                 tent { 1, SamplePattern::kSobol, PixelFilter::kTent },
+                 mitchell { 1, SamplePattern::kSobol, PixelFilter::kMitchell };
+    ASSERT_EQ(0.5, box.Radius());
+    ASSERT_EQ(1.0, box.Weight(0.2, -0.4));
+    ASSERT_EQ(0.0, box.Weight(0.5, 0));
+    ASSERT_EQ(1.0, tent.Radius());
+    ASSERT_DOUBLE_EQ(0.25, tent.Weight(0.5, -0.5));
+    ASSERT_EQ(0.0, tent.Weight(1.0, 0));
+    ASSERT_EQ(2.0, mitchell.Radius());
+    ASSERT_DOUBLE_EQ(64.0 / 81, mitchell.Weight(0, 0));
+    ASSERT_LT(mitchell.Weight(1.5, 0), 0);
+    ASSERT_EQ(0.0, mitchell.Weight(2.0, 0));
+}
+
+// The image doesn't depend on the number of threads, and pixels that see
+// only the background are the background colour whatever the filter
+TEST(CameraTest, RenderingAWorldWithManySamples) {
+    // Set up world, see p. 92
+    World default_world {};
+
+    Point position { -10, 10, -10 };
+    Colour intensity { 1, 1, 1 };
+    Light light { position, intensity };
+    default_world.Add(&light);
+
+    Sphere sphere1 {};
+    Colour c1 { 0.8, 1.0, 0.6 };
+    Material material1 { c1, 0.1, 0.7, 0.2, 200.0 };
+    sphere1.SetMaterial(material1);
+    default_world.Add(&sphere1);
+
+    Camera c { 11, 11, M_PI / 2 };
+    c.SetTransform(ViewTransform { Point { 0, 0, -5 }, Point { 0, 0, 0 }, Vector { 0, 1, 0 } });
+
+    for (auto filter: { PixelFilter::kBox, PixelFilter::kTent, PixelFilter::kMitchell }) {
+        PixelSampler sampler { 8, SamplePattern::kHalton, filter };
+        Canvas image = c.RenderMultisample(default_world, sampler, 1),
+               threaded = c.RenderMultisample(default_world, sampler, 3);
+        for (int row = 0; row < 11; row++) {
+            for (int column = 0; column < 11; column++) {
+                ASSERT_EQ(image.At(row, column), threaded.At(row, column));
+            }
+        }
+        ASSERT_EQ(Colour::kBlack, image.At(0, 0));
+    }
+}
+
+// Tiles that see only the background converge after the first round, those
+// on the edge of the sphere take more samples, and a time budget stops the
+// rendering after the round that uses it up
+TEST(CameraTest, RenderingAWorldUntilItConverges) {
+    // Set up world, see p. 92
+    World default_world {};
+
+    Point position { -10, 10, -10 };
+    Colour intensity { 1, 1, 1 };
+    Light light { position, intensity };
+    default_world.Add(&light);
+
+    Sphere sphere1 {};
+    Colour c1 { 0.8, 1.0, 0.6 };
+    Material material1 { c1, 0.1, 0.7, 0.2, 200.0 };
+    sphere1.SetMaterial(material1);
+    default_world.Add(&sphere1);
+
+    Camera c { 11, 11, M_PI / 2 };
+    c.SetTransform(ViewTransform { Point { 0, 0, -5 }, Point { 0, 0, 0 }, Vector { 0, 1, 0 } });
+
+    PixelSampler sampler { 32, SamplePattern::kSobol, PixelFilter::kTent };
+    std::vector<int> samples {}, threaded_samples {};
+    Canvas image = c.RenderConverged(default_world, sampler, 0.01, 0, 1, &samples),
+           threaded = c.RenderConverged(default_world, sampler, 0.01, 0, 3, &threaded_samples);
+    ASSERT_EQ(samples, threaded_samples);
+    for (int row = 0; row < 11; row++) {
+        for (int column = 0; column < 11; column++) {
+            ASSERT_EQ(image.At(row, column), threaded.At(row, column));
+        }
+    }
+    ASSERT_EQ(Camera::kMinConvergenceSamples, samples[0]);
+    ASSERT_EQ(Colour::kBlack, image.At(0, 0));
+    ASSERT_EQ(32, *std::max_element(samples.begin(), samples.end()));
+
+    c.RenderConverged(default_world, sampler, 0.01, 1e-9, 1, &samples);
+    for (int n: samples) {
+        ASSERT_EQ(Camera::kMinConvergenceSamples, n);
+    }
+}
+
+// Rendering progressively traces each pixel once, giving the same image as
+// rendering it in one pass, and the earlier passes fill in the pixels they
+// haven't traced yet from the pixels they have
+TEST(CameraTest, RenderingAWorldProgressively) {
+    // Set up world, see p. 92
+    World default_world {};
+
+    Point position { -10, 10, -10 };
+    Colour intensity { 1, 1, 1 };
+    Light light { position, intensity };
+    default_world.Add(&light);
+
+    Sphere sphere1 {};
+    Colour c1 { 0.8, 1.0, 0.6 };
+    Material material1 { c1, 0.1, 0.7, 0.2, 200.0 };
+    sphere1.SetMaterial(material1);
+    default_world.Add(&sphere1);
+
+    Camera c { 11, 11, M_PI / 2 };
+    c.SetTransform(ViewTransform { Point { 0, 0, -5 }, Point { 0, 0, 0 }, Vector { 0, 1, 0 } });
+
+    Canvas expected = c.Render(default_world);
+    for (int threads: { 1, 3 }) {
+        std::vector<int> passes {};
+        Canvas image = c.RenderProgressive(default_world, 0,
+            [&](const Canvas& preview, int pass) {
+                passes.push_back(pass);
+                if (pass == 1) {
+                    ASSERT_EQ(expected.At(4, 4), preview.At(7, 6));
+                }
+                if (pass == 2) {
+                    ASSERT_EQ(expected.At(4, 6), preview.At(5, 7));
+                }
+            }, threads);
+        ASSERT_EQ(std::vector<int>({ 1, 2, 3 }), passes);
+        for (int row = 0; row < 11; row++) {
+            for (int column = 0; column < 11; column++) {
+                ASSERT_EQ(expected.At(row, column), image.At(row, column));
+            }
+        }
+    }
+
+    // with no time, nothing is traced
+    std::vector<int> passes {};
+    Canvas image = c.RenderProgressive(default_world, 1e-9,
+        [&](const Canvas& preview, int pass) { passes.push_back(pass); });
+    ASSERT_EQ(std::vector<int>({ 1 }), passes);
+    ASSERT_EQ(Colour::kBlack, image.At(5, 5));
+}
+
+TEST(CameraTest, SavingAndLoadingARenderState) {
+    ConvergenceState state {};
+    state.key = 42;
+    state.width = 2;
+    state.height = 1;
+    state.taken = { 8 };
+    state.means = { 0.5, 0.25 };
+    state.squares = { 0.1, 0 };
+    state.sums = { Colour { 1, 2, 3 }, Colour { 4, 5, 6 } };
+    state.weights = { 8, 7.5 };
+    std::stringstream saved {};
+    state.Save(saved);
+    std::string bytes = saved.str();
+
+    ConvergenceState loaded {};
+    ASSERT_TRUE(loaded.Load(saved));
+    ASSERT_EQ(42, loaded.key);
+    ASSERT_EQ(2, loaded.width);
+    ASSERT_EQ(1, loaded.height);
+    ASSERT_EQ(state.taken, loaded.taken);
+    ASSERT_EQ(state.means, loaded.means);
+    ASSERT_EQ(state.squares, loaded.squares);
+    ASSERT_EQ(Colour(4, 5, 6), loaded.sums[1]);
+    ASSERT_EQ(state.weights, loaded.weights);
+
+    // a truncated state isn't loaded
+    std::stringstream truncated { bytes.substr(0, bytes.size() - 1) };
+    ASSERT_FALSE(loaded.Load(truncated));
+
+    // nor is one with a negative count of samples
+    state.taken = { -8 };
+    std::stringstream negative {};
+    state.Save(negative);
+    ASSERT_FALSE(loaded.Load(negative));
+    ASSERT_EQ(8, loaded.taken[0]);
+}
+
+// A render stopped early and carried on from its checkpoint gives the same
+// image as one that wasn't stopped
+TEST(CameraTest, ResumingARenderFromACheckpoint) {
+    // Set up world, see p. 92
+    World default_world {};
+
+    Point position { -10, 10, -10 };
+    Colour intensity { 1, 1, 1 };
+    Light light { position, intensity };
+    default_world.Add(&light);
+
+    Sphere sphere1 {};
+    Colour c1 { 0.8, 1.0, 0.6 };
+    Material material1 { c1, 0.1, 0.7, 0.2, 200.0 };
+    sphere1.SetMaterial(material1);
+    default_world.Add(&sphere1);
+
+    Camera c { 11, 11, M_PI / 2 };
+    c.SetTransform(ViewTransform { Point { 0, 0, -5 }, Point { 0, 0, 0 }, Vector { 0, 1, 0 } });
+
+    PixelSampler sampler { 32, SamplePattern::kSobol, PixelFilter::kTent };
+    std::vector<int> expected_samples {}, samples {};
+    Canvas expected = c.RenderConverged(default_world, sampler, 0.01, 0, 1, &expected_samples);
+
+    std::string path = testing::TempDir() + "camera-checkpoint.bin";
+    std::remove(path.c_str());
+    {
+        CheckpointWriter checkpoints { path, 1000 };
+        c.RenderConverged(default_world, sampler, 0.01, 1e-9, 1, &samples, &checkpoints);
+        checkpoints.Flush();
+        ASSERT_EQ(1, checkpoints.Written());
+    }
+    CheckpointWriter checkpoints { path, 1000 };
+    Canvas image = c.RenderConverged(default_world, sampler, 0.01, 0, 2, &samples, &checkpoints);
+    checkpoints.Flush();
+    ASSERT_EQ(expected_samples, samples);
+    for (int row = 0; row < 11; row++) {
+        for (int column = 0; column < 11; column++) {
+            ASSERT_EQ(expected.At(row, column), image.At(row, column));
+        }
+    }
+
+    // the finished checkpoint isn't used by a render taking fewer samples,
+    // which are placed differently
+    PixelSampler fewer { 16, SamplePattern::kSobol, PixelFilter::kTent };
+    std::vector<int> fresh_samples {}, resumed_samples {};
+    Canvas fresh = c.RenderConverged(default_world, fewer, 0.01, 0, 1, &fresh_samples);
+    ASSERT_NE(expected_samples, fresh_samples);
+    Canvas resumed = c.RenderConverged(default_world, fewer, 0.01, 0, 1, &resumed_samples,
+        &checkpoints);
+    checkpoints.Flush();
+    std::remove(path.c_str());
+    ASSERT_EQ(fresh_samples, resumed_samples);
+    for (int row = 0; row < 11; row++) {
+        for (int column = 0; column < 11; column++) {
+            ASSERT_EQ(fresh.At(row, column), resumed.At(row, column));
+        }
+    }
+}
+
+// The rays of a tile are those RayAt() makes for each of its pixels, in rows
+TEST(CameraTest, ConstructingTheRaysOfATile) {
+    Camera c { 201, 101, M_PI / 2 };
+    c.SetTransform(Transformation().Translate(0, -2, 5).RotateY(M_PI / 4));
+    RayPacket packet {};
+    c.AddTile(packet, 99, 49, 4, 2);
+    ASSERT_EQ(8, packet.Size());
+    for (int lane = 0; lane < 8; lane++) {
+        Ray expected = c.RayAt(99 + lane % 4, 49 + lane / 4), actual = packet.At(lane);
+        ASSERT_EQ(expected.Origin(), actual.Origin());
+        ASSERT_EQ(expected.Direction(), actual.Direction());
+        ASSERT_DOUBLE_EQ(expected.InverseDirection(0), packet.InverseDirectionX()[lane]);
+    }
+}
+
+TEST(CameraTest, RenderingARegionOfAWorld) {
+    // Set up world, see p. 92
+    World default_world {};
+
+    Point position { -10, 10, -10 };
+    Colour intensity { 1, 1, 1 };
+    Light light { position, intensity };
+    default_world.Add(&light);
+
+    Sphere sphere1 {};
+    Colour c1 { 0.8, 1.0, 0.6 };
+    Material material1 { c1, 0.1, 0.7, 0.2, 200.0 };
+    sphere1.SetMaterial(material1);
+    default_world.Add(&sphere1);
+
+    Camera c { 11, 11, M_PI / 2 };
+    c.SetTransform(ViewTransform { Point { 0, 0, -5 }, Point { 0, 0, 0 }, Vector { 0, 1, 0 } });
+
+    Canvas expected = c.Render(default_world);
+    Canvas region = c.RenderRegion(default_world, 3, 5, 6, 4);
+    ASSERT_EQ(6, region.Width());
+    ASSERT_EQ(4, region.Height());
+    for (int row = 0; row < 4; row++) {
+        for (int column = 0; column < 6; column++) {
+            ASSERT_EQ(expected.At(5 + row, 3 + column), region.At(row, column));
+        }
+    }
+    // threads taking tiles in turn render the same pixels
+    Canvas tiled = c.RenderRegion(default_world, 0, 0, 11, 11, 3, 2);
+    for (int row = 0; row < 11; row++) {
+        for (int column = 0; column < 11; column++) {
+            ASSERT_EQ(expected.At(row, column), tiled.At(row, column));
+        }
+    }
+    ASSERT_THROW(c.RenderRegion(default_world, 8, 0, 4, 4), std::invalid_argument);
+    ASSERT_THROW(c.RenderRegion(default_world, 0, 0, 4, 4, 2, 0), std::invalid_argument);
+    ASSERT_THROW(c.RenderRegion(default_world, 0, -1, 4, 4), std::invalid_argument);
+    ASSERT_THROW(c.RenderRegion(default_world, 8, 0, std::numeric_limits<int>::max(), 4),
+        std::invalid_argument);
 }
\ No newline at end of file
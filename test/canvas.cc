@@ -205,4 +205,17 @@ TEST(CanvasTest, ConfirmingPPMFileEndsWithNewline) {
     os << ppm;
     std::string ppm_file = os.str();
     ASSERT_EQ(ppm_file[ppm_file.length() - 1], '\n');
+}
+
+TEST(CanvasTest, ConstructingABinaryPPM) {
+    Canvas c { 2, 2 };
+    c[0][1] = Colour { 1.5, 0, 0.5 };
+    c[1][0] = Colour { -0.5, 0.2, 1 };
+    std::ostringstream os;
+    os << PPMv6 { c };
+    std::string expected { "P6\n2 2\n255\n" };
+    for (int level: { 0, 0, 0, 255, 0, 128, 0, 51, 255, 0, 0, 0 }) {
+        expected.push_back(static_cast<char>(level));
+    }
+    ASSERT_EQ(expected, os.str());
 }
\ No newline at end of file
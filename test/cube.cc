@@ -153,4 +153,24 @@ TEST(CubeTest, ACubeHasABoundingBox) {
           max { 1, 1, 1 };
     ASSERT_EQ(min, box.Min());
     ASSERT_EQ(max, box.Max());
+}
+
+TEST(CubeTest, IntersectingARayPacketWithACube) {
+    Cube c {};
+    RayPacket packet {};
+    packet.Add(Ray { Point { 5, 0.5, 0 }, Vector { -1, 0, 0 } });
+    packet.Add(Ray { Point { -2, 0, 0 }, Vector { 0.2673, 0.5345, 0.8018 } });
+    packet.Add(Ray { Point { 0, 0.5, 0 }, Vector { 0, 0, 1 } });
+    packet.Add(Ray { Point { 2, 2, 0 }, Vector { 0, 0, 1 } });
+
+    IntersectionList lists[kMaxPacketSize];
+    ASSERT_EQ(c.IntersectPacket(lists, packet, packet.Mask()), 0x5);
+    ASSERT_EQ(lists[0].Size(), 2);
+    ASSERT_DOUBLE_EQ(lists[0][0]->Distance(), 4);
+    ASSERT_DOUBLE_EQ(lists[0][1]->Distance(), 6);
+    ASSERT_EQ(lists[1].Size(), 0);
+    ASSERT_EQ(lists[2].Size(), 2);
+    ASSERT_DOUBLE_EQ(lists[2][0]->Distance(), -1);
+    ASSERT_DOUBLE_EQ(lists[2][1]->Distance(), 1);
+    ASSERT_EQ(lists[3].Size(), 0);
 }
\ No newline at end of file
@@ -0,0 +1,125 @@
+#define _USE_MATH_DEFINES // for M_PI
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "distributed.h"
+#include "camera.h"
+#include "canvas.h"
+#include "world.h"
+#include "sphere.h"
+#include "material.h"
+#include "transformations.h"
+
+class DistributedTest: public testing::Test {
+    protected:
+        World default_world {};
+        Light light { Point { -10, 10, -10 }, Colour { 1, 1, 1 } };
+        Sphere sphere1 {};
+        Camera c { 11, 11, M_PI / 2 };
+
+        void SetUp() override {
+            // Set up world, see p. 92
+            default_world.Add(&light);
+            sphere1.SetMaterial(Material { Colour { 0.8, 1.0, 0.6 }, 0.1, 0.7, 0.2, 200.0 });
+            default_world.Add(&sphere1);
+            c.SetTransform(ViewTransform { Point { 0, 0, -5 }, Point { 0, 0, 0 },
+                Vector { 0, 1, 0 } });
+        }
+
+        void ExpectRendered(const Canvas& image) {
+            Canvas expected = c.Render(default_world);
+            ASSERT_EQ(expected.Width(), image.Width());
+            ASSERT_EQ(expected.Height(), image.Height());
+            for (int row = 0; row < 11; row++) {
+                for (int column = 0; column < 11; column++) {
+                    ASSERT_EQ(expected.At(row, column), image.At(row, column));
+                }
+            }
+        }
+};
+
+TEST_F(DistributedTest, RenderingWithWorkerProcesses) {
+    ExpectRendered(RenderWithWorkers(default_world, c, 3, 4));
+    // more workers than tiles
+    ExpectRendered(RenderWithWorkers(default_world, c, 3, 8));
+}
+
+TEST_F(DistributedTest, RenderingWithWorkersThatConnect) {
+    std::string path = testing::TempDir() + "distributed-test-" + std::to_string(getpid());
+    std::vector<std::thread> workers {};
+    for (int w = 0; w < 2; w++) {
+        workers.emplace_back([&] {
+            // wait for the coordinator to listen
+            int socket { -1 };
+            while (socket < 0) {
+                try {
+                    socket = ConnectTo(path);
+                }
+                catch (const std::runtime_error&) {
+                    usleep(1000);
+                }
+            }
+            RunWorker(socket, default_world, c);
+            close(socket);
+        });
+    }
+    std::vector<int> sockets = AcceptWorkers(path, 2);
+    Canvas image = CoordinateWorkers(sockets, c.Horizontal(), c.Vertical(), 4);
+    for (std::thread& worker: workers) {
+        worker.join();
+    }
+    ExpectRendered(image);
+    ASSERT_NE(0, access(path.c_str(), F_OK));
+}
+
+TEST_F(DistributedTest, ReassigningTheTileOfAWorkerThatDisconnects) {
+    int quitter[2], worker[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, quitter));
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, worker));
+    std::thread quitting { [&] {
+        // ask for a tile, then leave without rendering it
+        std::int32_t first { -1 }, tile[5] {};
+        send(quitter[1], &first, sizeof(first), 0);
+        recv(quitter[1], tile, sizeof(tile), MSG_WAITALL);
+        close(quitter[1]);
+    } };
+    std::thread working { [&] {
+        RunWorker(worker[1], default_world, c);
+        close(worker[1]);
+    } };
+    Canvas image = CoordinateWorkers({ quitter[0], worker[0] }, c.Horizontal(), c.Vertical(), 4);
+    quitting.join();
+    working.join();
+    ExpectRendered(image);
+}
+
+TEST_F(DistributedTest, LosingEveryWorker) {
+    int quitter[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, quitter));
+    close(quitter[1]);
+    ASSERT_THROW(CoordinateWorkers({ quitter[0] }, 11, 11, 4), std::runtime_error);
+}
+
+// A shape whose intersections fail, as a worker's rendering might
+class FailingShape: public TestShape {
+    public:
+        bool Intersect(IntersectionList& list, const Ray& ray) const override {
+            throw std::runtime_error("Intersection failed");
+        }
+};
+
+TEST_F(DistributedTest, LosingWorkersThatFail) {
+    FailingShape failing {};
+    default_world.Add(&failing);
+    // the workers exit rather than returning here, so the coordinator loses
+    // them all
+    testing::internal::CaptureStderr();
+    ASSERT_THROW(RenderWithWorkers(default_world, c, 2, 4), std::runtime_error);
+    ASSERT_NE(std::string::npos, testing::internal::GetCapturedStderr().find("failed"));
+}
@@ -0,0 +1,30 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "grid.h"
+
+#include "sphere.h"
+#include "transformations.h"
+
+// See test/accelerator.cc for the tests shared with the other structures
+
+TEST(GridTest, ChoosingTheResolutionFromTheDensityOfPrimitives) {
+    // a 4*4*4 cube of spheres
+    std::vector<Sphere> spheres(64);
+    std::vector<const Shape*> objects {};
+    for (std::size_t i = 0; i < spheres.size(); i++) {
+        spheres[i].SetTransform(
+            Transformation().Translate(3 * (i % 4), 3 * ((i / 4) % 4), 3 * (i / 16))
+        );
+        objects.push_back(&spheres[i]);
+    }
+    UniformGrid grid {};
+    grid.Build(objects);
+    auto resolution = grid.Resolution();
+    // the lattice is cubic, so the cells should be too
+    ASSERT_EQ(resolution[0], resolution[1]);
+    ASSERT_EQ(resolution[1], resolution[2]);
+    int cells = resolution[0] * resolution[1] * resolution[2];
+    ASSERT_NEAR(cells, UniformGrid::kDensity * spheres.size(), cells / 2);
+}
\ No newline at end of file
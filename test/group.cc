@@ -2,6 +2,8 @@
 
 #include <array>
 #include <vector>
+#include <sstream>
+#include <thread>
 
 #include "group.h"
 
@@ -11,6 +13,8 @@
 #include "sphere.h"
 #include "transformations.h"
 #include "cylinder.h"
+#include "cube.h"
+#include "hemisphere.h"
 
 /*
 Scenario: Creating a new group
@@ -343,6 +347,19 @@ TEST(GroupTest, ConfirmingTheBoundingBoxOfAGroupAfterAddingAShape) {
     ASSERT_EQ(s_bbox.Max(), g_bbox.Max());
 }
 
+TEST(GroupTest, AddingSeveralChildrenToAGroup) {
+    ShapeGroup g {};
+    Sphere s1 {}, s2 {};
+    s2.SetTransform(Transformation().Translate(5, 0, 0));
+    g.Add(std::vector<Shape*> { &s1, &s2 });
+    ASSERT_TRUE(g.Contains(&s1));
+    ASSERT_TRUE(g.Contains(&s2));
+    ASSERT_EQ(s2.Parent(), &g);
+    BoundingBox bbox = g.BoundsOfInParentSpace();
+    ASSERT_EQ((Point { -1, -1, -1 }), bbox.Min());
+    ASSERT_EQ((Point { 6, 1, 1 }), bbox.Max());
+}
+
 // For Issue ShapeGroup::Divide() drops shapes under certain conditions #1
 TEST(GroupTest, DividingACubeOfSpheresDoesNotDropObjects) {
     std::vector<Shape *> objects;
@@ -387,4 +404,354 @@ TEST(GroupTest, DividingACubeOfSpheresDoesNotDropObjects) {
         throw e;
     }
     clean_up();
+}
+
+// Refitting propagates the bounds of transformed children to their ancestors
+TEST(GroupTest, RefittingAGroupAfterTransformingAChild) {
+    Sphere s1 {}, s2 {};
+    s1.SetTransform(Transformation().Translate(-2, 0, 0));
+    s2.SetTransform(Transformation().Translate(2, 0, 0));
+    ShapeGroup subgroup {};
+    subgroup << &s1 << &s2;
+    ShapeGroup g {};
+    g << &subgroup;
+    s2.SetTransform(Transformation().Translate(0, 5, 0));
+    // the subgroup's bounds in parent space are stale until refit
+    ASSERT_EQ(g.BoundsOf().Max(), Point(3, 1, 1));
+    ASSERT_FALSE(g.Refit());
+    ASSERT_EQ(g.BoundsOf().Min(), Point(-3, -1, -1));
+    ASSERT_EQ(g.BoundsOf().Max(), Point(3, 6, 1));
+    ASSERT_EQ(g.Size(), 1);
+}
+
+TEST(GroupTest, RefittingADividedGroupRebuildsItWhenItsCostDegrades) {
+    std::vector<Sphere> spheres(8);
+    ShapeGroup g {};
+    for (int i = 0; i < spheres.size(); i++) {
+        spheres[i].SetTransform(Transformation().Translate(4 * i, 0, 0));
+        g << &spheres[i];
+    }
+    g.Divide(2);
+    double cost = g.Cost();
+    ASSERT_FALSE(g.Refit());
+    ASSERT_DOUBLE_EQ(g.Cost(), cost);
+
+    // scatter the spheres so that the subgroups overlap one another
+    for (int i = 0; i < spheres.size(); i++) {
+        double offset = (i % 2 == 0) ? 100 : -100;
+        spheres[i].SetTransform(Transformation().Translate(offset, 0, 0));
+    }
+    ASSERT_TRUE(g.Refit());
+    ASSERT_LE(g.Cost(), cost * ShapeGroup::kMaxRefitDegradation);
+
+    Ray r { Point { 100, 0, -5 }, Vector { 0, 0, 1 } };
+    IntersectionList xs {};
+    ASSERT_TRUE(g.Intersect(xs, r));
+    ASSERT_EQ(xs.Size(), 2);
+    ASSERT_EQ(xs[0]->Object(), &spheres[0]);
+}
+
+
+TEST(GroupTest, CollectingStatisticsForADividedGroup) {
+    Sphere s1 {}, s2 {}, s3 {};
+    s1.SetTransform(Transformation().Translate(-2, 0, 0));
+    s2.SetTransform(Transformation().Translate(2, 0, 0));
+    ShapeGroup g {};
+    g << &s1 << &s2 << &s3;
+    g.Divide(1);
+    HierarchyStatistics stats = g.Statistics();
+    ASSERT_EQ(stats.groups, 3);
+    ASSERT_EQ(stats.primitives, 3);
+    ASSERT_EQ(stats.groups_by_depth, std::vector<int>({ 1, 2 }));
+    // s3 straddles both halves of the group
+    ASSERT_EQ(stats.unsplit_by_depth, std::vector<int>({ 1, 0 }));
+    ASSERT_EQ(stats.leaf_sizes.size(), 1);
+    ASSERT_EQ(stats.leaf_sizes[1], 2);
+    ASSERT_DOUBLE_EQ(stats.cost, g.Cost());
+    ASSERT_GT(stats.memory, 3 * sizeof(ShapeGroup));
+}
+
+TEST(GroupTest, CountingGroupsVisitedAndPrimitivesTested) {
+    Sphere s1 {}, s2 {};
+    s1.SetTransform(Transformation().Translate(-2, 0, 0));
+    s2.SetTransform(Transformation().Translate(2, 0, 0));
+    ShapeGroup g {};
+    g << &s1 << &s2;
+    g.Divide(1);
+
+    TraversalStatistics::Reset();
+    TraversalStatistics::Enable();
+    Ray r { Point { -2, 0, -5 }, Vector { 0, 0, 1 } };
+    IntersectionList xs {};
+    g.Intersect(xs, r);
+    TraversalStatistics::Enable(false);
+
+    // the group and both subgroups are visited, but only the subgroup
+    // containing s1 is intersected by the ray
+    ASSERT_EQ(TraversalStatistics::GroupsVisited(), 3);
+    ASSERT_EQ(TraversalStatistics::PrimitivesTested(), 1);
+}
+
+
+
+TEST(GroupTest, SavingAndLoadingADividedGroup) {
+    std::vector<Sphere> spheres(8);
+    ShapeGroup g1 {}, g2 {};
+    for (int i = 0; i < spheres.size(); i++) {
+        spheres[i].SetTransform(Transformation().Translate(4 * i, 0, 0));
+        g1 << &spheres[i];
+    }
+    std::stringstream cache {};
+    g1.DivideAndSave(2, cache);
+    HierarchyStatistics divided = g1.Statistics();
+
+    // load the hierarchy into a second group with the same children
+    for (int i = 0; i < spheres.size(); i++) {
+        g2 << &spheres[i];
+    }
+    ASSERT_TRUE(g2.LoadDivided(2, cache));
+    HierarchyStatistics loaded = g2.Statistics();
+    ASSERT_EQ(loaded.groups, divided.groups);
+    ASSERT_EQ(loaded.groups_by_depth, divided.groups_by_depth);
+    ASSERT_EQ(loaded.leaf_sizes, divided.leaf_sizes);
+    ASSERT_DOUBLE_EQ(loaded.cost, divided.cost);
+    ShapeGroup* root = spheres[0].Parent();
+    while (root->Parent() != nullptr) {
+        root = root->Parent();
+    }
+    ASSERT_EQ(root, &g2);
+
+    Ray r { Point { 0, 0, -5 }, Vector { 0, 0, 1 } };
+    IntersectionList xs {};
+    ASSERT_TRUE(g2.Intersect(xs, r));
+    ASSERT_EQ(xs.Size(), 2);
+}
+
+TEST(GroupTest, LoadingAHierarchySavedForDifferentChildren) {
+    std::vector<Sphere> spheres(4);
+    ShapeGroup g {};
+    for (int i = 0; i < spheres.size(); i++) {
+        spheres[i].SetTransform(Transformation().Translate(4 * i, 0, 0));
+        g << &spheres[i];
+    }
+    std::stringstream cache {};
+    g.DivideAndSave(2, cache);
+    std::string saved = cache.str();
+
+    // a different threshold or a moved child invalidates the cache
+    std::stringstream different_threshold { saved };
+    ASSERT_FALSE(g.LoadDivided(1, different_threshold));
+    ASSERT_EQ(g.Size(), 4);
+
+    spheres[0].SetTransform(Transformation().Translate(0, 1, 0));
+    std::stringstream moved { saved };
+    ASSERT_FALSE(g.LoadDivided(2, moved));
+    ASSERT_EQ(g.Size(), 4);
+
+    std::stringstream truncated { saved.substr(0, saved.size() - 4) };
+    ASSERT_FALSE(g.LoadDivided(2, truncated));
+    ASSERT_EQ(g.Size(), 4);
+}
+
+
+TEST(GroupTest, DividingAGroupLazily) {
+    std::vector<Sphere> spheres(8);
+    ShapeGroup g {};
+    for (int i = 0; i < spheres.size(); i++) {
+        spheres[i].SetTransform(Transformation().Translate(4 * i, 0, 0));
+        g << &spheres[i];
+    }
+    g.DivideLazily(2);
+    HierarchyStatistics stats = g.Statistics();
+    ASSERT_EQ(stats.groups, 3);
+    ASSERT_EQ(stats.undivided, 2);
+
+    // only the groups the ray enters are divided
+    Ray r { Point { 0, 0, -5 }, Vector { 0, 0, 1 } };
+    IntersectionList xs {};
+    ASSERT_TRUE(g.Intersect(xs, r));
+    ASSERT_EQ(xs.Size(), 2);
+    ASSERT_EQ(xs[0]->Object(), &spheres[0]);
+    stats = g.Statistics();
+    ASSERT_EQ(stats.groups, 7);
+    ASSERT_EQ(stats.undivided, 3);
+
+    // a ray that misses the group divides nothing
+    Ray miss { Point { 0, 5, -5 }, Vector { 0, 0, 1 } };
+    ASSERT_FALSE(g.Intersect(xs, miss));
+    ASSERT_EQ(g.Statistics().groups, 7);
+}
+
+TEST(GroupTest, RefittingALazilyDividedGroup) {
+    std::vector<Sphere> spheres(8);
+    ShapeGroup g {};
+    for (std::size_t i = 0; i < spheres.size(); i++) {
+        spheres[i].SetTransform(Transformation().Translate(4 * i, 0, 0));
+        g << &spheres[i];
+    }
+    g.DivideLazily(2);
+    int undivided = g.Statistics().undivided;
+    // nothing has moved, so the hierarchy is kept and stays lazy
+    ASSERT_FALSE(g.Refit());
+    ASSERT_EQ(g.Statistics().undivided, undivided);
+
+    // rays dividing it only lower its cost
+    Ray r { Point { 0, 0, -5 }, Vector { 0, 0, 1 } };
+    IntersectionList xs {};
+    ASSERT_TRUE(g.Intersect(xs, r));
+    ASSERT_FALSE(g.Refit());
+
+    // once it degrades, it is rebuilt lazily
+    for (std::size_t i = 0; i < spheres.size(); i++) {
+        double offset = (i % 2 == 0) ? 100 : -100;
+        spheres[i].SetTransform(Transformation().Translate(offset, 0, 0));
+    }
+    ASSERT_TRUE(g.Refit());
+    ASSERT_GT(g.Statistics().undivided, 0);
+    IntersectionList ys {};
+    ASSERT_TRUE(g.Intersect(ys, Ray { Point { 100, 0, -5 }, Vector { 0, 0, 1 } }));
+    ASSERT_EQ(ys[0]->Object(), &spheres[0]);
+}
+
+TEST(GroupTest, DividingAGroupLazilyFromSeveralThreads) {
+    std::vector<Sphere> spheres(64);
+    ShapeGroup g {};
+    for (int i = 0; i < spheres.size(); i++) {
+        spheres[i].SetTransform(Transformation().Translate(4 * (i % 8), 4 * (i / 8), 0));
+        g << &spheres[i];
+    }
+    g.DivideLazily(2);
+
+    std::vector<std::thread> threads {};
+    std::vector<int> hits(spheres.size(), 0);
+    for (int i = 0; i < spheres.size(); i++) {
+        threads.push_back(std::thread { [&g, &hits, i] () {
+            Ray r { Point { 4.0 * (i % 8), 4.0 * (i / 8), -5 }, Vector { 0, 0, 1 } };
+            IntersectionList xs {};
+            g.Intersect(xs, r);
+            hits[i] = xs.Size();
+        } });
+    }
+    for (auto& t: threads) {
+        t.join();
+    }
+    for (int i = 0; i < spheres.size(); i++) {
+        ASSERT_EQ(hits[i], 2);
+    }
+    HierarchyStatistics stats = g.Statistics();
+    ASSERT_EQ(stats.primitives, 64);
+    ASSERT_EQ(stats.undivided, 0);
+}
+
+// Tracing a packet through a hierarchy finds the same intersections as
+// tracing its rays one at a time, including rays that leave the packet
+TEST(GroupTest, IntersectingARayPacketWithADividedGroup) {
+    ShapeGroup g {};
+    std::vector<Sphere> spheres(27);
+    int index { 0 };
+    for (int x = 0; x < 3; x++) {
+        for (int y = 0; y < 3; y++) {
+            for (int z = 0; z < 3; z++) {
+                spheres[index].SetTransform(Transformation().Translate(3*x, 3*y, 3*z));
+                g.Add(&spheres[index++]);
+            }
+        }
+    }
+    g.SetTransform(Transformation().Translate(-3, -3, 0));
+    g.Divide(2);
+
+    RayPacket packet {};
+    for (int lane = 0; lane < kMaxPacketSize; lane++) {
+        // a fan of rays, some of which miss every sphere
+        Vector direction = Vector { -0.6 + 0.08 * lane, 0.3 - 0.04 * lane, 1 }.Normalize();
+        packet.Add(Ray { Point { 0, 0, -10 }, direction });
+    }
+    IntersectionList lists[kMaxPacketSize];
+    LaneMask intersected = g.IntersectPacket(lists, packet, packet.Mask());
+    for (int lane = 0; lane < kMaxPacketSize; lane++) {
+        IntersectionList expected {};
+        bool hit = g.Intersect(expected, packet.At(lane));
+        ASSERT_EQ(hit, (intersected & (1u << lane)) != 0);
+        ASSERT_EQ(lists[lane].Size(), expected.Size());
+        for (int i = 0; i < expected.Size(); i++) {
+            ASSERT_EQ(lists[lane][i]->Distance(), expected[i]->Distance());
+            ASSERT_EQ(lists[lane][i]->Object(), expected[i]->Object());
+        }
+    }
+}
+
+// A subgroup entirely beyond the closest hit so far is not entered
+TEST(GroupTest, SkippingSubgroupsBeyondTheClosestHit) {
+    Sphere near {}, far {};
+    far.SetTransform(Transformation().Translate(0, 0, 10));
+    ShapeGroup g {}, near_group {}, far_group {};
+    near_group.Add(&near);
+    far_group.Add(&far);
+    g.Add(&near_group);
+    g.Add(&far_group);
+
+    Ray r { Point { 0, 0, -5 }, Vector { 0, 0, 1 } };
+    IntersectionList xs {};
+    ASSERT_TRUE(g.Intersect(xs, r));
+    ASSERT_EQ(xs.Size(), 2);
+    ASSERT_DOUBLE_EQ(xs.Hit()->Distance(), 4);
+
+    // with the far group first, both are entered
+    ShapeGroup reversed {};
+    reversed.Add(&far_group);
+    reversed.Add(&near_group);
+    IntersectionList all {};
+    ASSERT_TRUE(reversed.Intersect(all, r));
+    ASSERT_EQ(all.Size(), 4);
+    ASSERT_DOUBLE_EQ(all.Hit()->Distance(), 4);
+}
+
+// A divided group intersects its spheres and cubes with the block kernels and
+// any other shapes as usual, finding the same hits as the shapes themselves,
+// and the kernels see a child's new transform after Refit()
+TEST(GroupTest, IntersectingADividedGroupOfMixedPrimitives) {
+    Sphere sphere {};
+    sphere.SetTransform(Transformation().Translate(0, 0, 0));
+    Cube cube {};
+    cube.SetTransform(Transformation().Scale(0.5, 0.5, 0.5).Translate(3, 0, 0));
+    Hemisphere hemisphere {};
+    hemisphere.SetTransform(Transformation().Translate(-3, 0, 0));
+    Sphere far {};
+    far.SetTransform(Transformation().Translate(0, 0, 3));
+    std::vector<Shape*> shapes { &sphere, &cube, &hemisphere, &far };
+    ShapeGroup g {};
+    for (auto s: shapes) {
+        g.Add(s);
+    }
+    g.Divide(3);
+
+    std::vector<Ray> rays {
+        Ray { Point { 0, 0, -5 }, Vector { 0, 0, 1 } },
+        Ray { Point { 3, 0.2, -5 }, Vector { 0, 0, 1 } },
+        Ray { Point { -3, 0.5, -5 }, Vector { 0, 0, 1 } },
+        Ray { Point { -5, 0, 0 }, Vector { 1, 0, 0 } },
+        Ray { Point { 0, -5, 3.5 }, Vector { 0, 1, 0 } },
+        Ray { Point { 0, 5, -5 }, Vector { 0, 0, 1 } }
+    };
+    for (auto& r: rays) {
+        IntersectionList actual {}, expected {};
+        g.Intersect(actual, r);
+        for (auto s: shapes) {
+            s->Intersect(expected, r);
+        }
+        // subgroups beyond the hit may be skipped, so only the hits match
+        ASSERT_EQ(actual.Hit() == nullptr, expected.Hit() == nullptr);
+        if (expected.Hit()) {
+            ASSERT_EQ(actual.Hit()->Distance(), expected.Hit()->Distance());
+            ASSERT_EQ(actual.Hit()->Object(), expected.Hit()->Object());
+        }
+    }
+
+    cube.SetTransform(Transformation().Translate(0, 10, 0));
+    g.Refit();
+    Ray r { Point { 3, 5, -5 }, Vector { 0, 0, 1 } };
+    IntersectionList xs {};
+    ASSERT_TRUE(g.Intersect(xs, r));
+    ASSERT_EQ(xs.Size(), 2);
+    ASSERT_EQ(xs[0]->Object(), &cube);
 }
\ No newline at end of file
@@ -363,6 +363,82 @@ TEST(IntersectionsTest, FindingN1AndN2AtVariousIntersections) {
     }
 }
 
+TEST(IntersectionsTest, CarryingTheMediumAlongTheRayPath) {
+    // The same spheres as above: each intersection is found with the
+    // medium left by the previous one instead of from the list
+    Sphere a = GlassySphere();
+    Material am {};
+    am.RefractiveIndex(1.5);
+    a.SetTransform(Transformation().Scale(2, 2, 2));
+    a.SetMaterial(am);
+
+    Sphere b = GlassySphere();
+    Material bm {};
+    bm.RefractiveIndex(2);
+    b.SetTransform(Transformation().Translate(0, 0, -0.25));
+    b.SetMaterial(bm);
+
+    Sphere c = GlassySphere();
+    Material cm {};
+    cm.RefractiveIndex(2.5);
+    c.SetTransform(Transformation().Translate(0, 0, 0.25));
+    c.SetMaterial(cm);
+
+    const Ray r { Point {0, 0, -4}, Vector {0, 0, 1} };
+    std::vector<Intersection> intersections {
+        Intersection { 2, &a }, Intersection { 2.75, &b }, Intersection { 3.25, &c },
+        Intersection { 4.75, &b }, Intersection { 5.25, &c }, Intersection { 6, &a }
+    };
+    std::vector<std::array<double, 2>> indices {
+        { 1.0, 1.5 }, { 1.5, 2.0 }, { 2.0, 2.5 }, { 2.5, 2.5 }, { 2.5, 1.5 }, { 1.5, 1.0 }
+    };
+
+    MediumStack medium {};
+    for (int i = 0; i < intersections.size(); i++) {
+        IntersectionComputation ic { intersections[i], r, medium };
+        ASSERT_DOUBLE_EQ(indices[i][0], ic.N1());
+        ASSERT_DOUBLE_EQ(indices[i][1], ic.N2());
+        ASSERT_EQ(medium.Size(), ic.ReflectedMedium()->Size());
+        medium = ic.RefractedMedium();
+    }
+    ASSERT_EQ(0, medium.Size());
+}
+
+TEST(IntersectionsTest, LeavingAnObjectThatIsNotInnermost) {
+    Sphere a = GlassySphere(), b = GlassySphere();
+    Material bm {};
+    bm.RefractiveIndex(2);
+    b.SetMaterial(bm);
+
+    MediumStack medium {};
+    ASSERT_DOUBLE_EQ(1.0, medium.RefractiveIndex());
+    medium.Cross(&a);
+    medium.Cross(&b);
+    ASSERT_EQ(2, medium.Size());
+    ASSERT_DOUBLE_EQ(2.0, medium.RefractiveIndex());
+    medium.Cross(&a);
+    ASSERT_EQ(1, medium.Size());
+    ASSERT_FALSE(medium.Contains(&a));
+    ASSERT_TRUE(medium.Contains(&b));
+    ASSERT_DOUBLE_EQ(2.0, medium.RefractiveIndex());
+}
+
+TEST(IntersectionsTest, FindingTheMediumOnlyWhenNeededForAnOpaqueHit) {
+    Sphere glass = GlassySphere(), opaque {};
+    const Ray r { Point {0, 0, -5}, Vector {0, 0, 1} };
+    IntersectionList intersections {};
+    intersections << Intersection { 4, &opaque } << Intersection { 6, &opaque };
+
+    IntersectionComputation transparent_ic { Intersection { 4, &glass }, r, &intersections };
+    ASSERT_NE(nullptr, transparent_ic.ReflectedMedium());
+
+    IntersectionComputation opaque_ic { Intersection { 4, &opaque }, r, &intersections };
+    ASSERT_EQ(nullptr, opaque_ic.ReflectedMedium());
+    ASSERT_DOUBLE_EQ(1.0, opaque_ic.N1());
+    ASSERT_DOUBLE_EQ(1.0, opaque_ic.N2());
+    ASSERT_NE(nullptr, opaque_ic.ReflectedMedium());
+}
+
 /*
 Scenario: The Schlick approximation under total internal reflection
   Given shape ← glass_sphere()
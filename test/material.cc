@@ -2,6 +2,8 @@
 
 #include <gtest/gtest.h>
 #include <cmath>
+#include <thread>
+#include <vector>
 
 #include "utils.h"
 #include "colour.h"
@@ -236,4 +238,45 @@ TEST(MaterialTest, LightingWithAPatternApplied) {
            c2 = m.ApplyLightAt(&dummy, light, Point { 1.1, 0, 0 }, eye, normal, false);
     ASSERT_EQ(c1, white);
     ASSERT_EQ(c2, black);
+}
+
+TEST(MaterialTest, InterningIdenticalMaterialsSharesAnEntry) {
+    MaterialTable& table = MaterialTable::Shared();
+    Material m1 = Material().Surface(Colour { 0.25, 0.5, 0.75 }).Reflectivity(0.3),
+             m2 = Material().Surface(Colour { 0.25, 0.5, 0.75 }).Reflectivity(0.3),
+             m3 = Material().Surface(Colour { 0.25, 0.5, 0.75 }).Reflectivity(0.3 + 1e-12);
+    MaterialIndex i1 = table.Intern(m1),
+                  i2 = table.Intern(m2),
+                  i3 = table.Intern(m3);
+    ASSERT_EQ(i1, i2);
+    // operator== allows for rounding errors, but interning doesn't
+    ASSERT_NE(i1, i3);
+    ASSERT_TRUE(table.At(i1).Identical(m1));
+    ASSERT_TRUE(table.At(i3).Identical(m3));
+    ASSERT_TRUE(table.At(MaterialTable::kDefault).Identical(Material()));
+}
+
+TEST(MaterialTest, InterningMaterialsFromSeveralThreads) {
+    MaterialTable& table = MaterialTable::Shared();
+    MaterialIndex first = table.Intern(Material().Shininess(1000));
+    // enough materials to fill several chunks, while another thread reads
+    // the entries already added
+    std::vector<std::thread> threads {};
+    std::vector<MaterialIndex> indices[2] {};
+    for (int t = 0; t < 2; t++) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 2 * static_cast<int>(MaterialTable::kChunkSize); i++) {
+                indices[t].push_back(table.Intern(Material().Shininess(1000 + t + 2 * i)));
+                ASSERT_EQ(table.At(first).Shininess(), 1000);
+            }
+        });
+    }
+    for (auto& t: threads) {
+        t.join();
+    }
+    for (int t = 0; t < 2; t++) {
+        for (std::size_t i = 0; i < indices[t].size(); i++) {
+            ASSERT_EQ(table.At(indices[t][i]).Shininess(), 1000 + t + 2 * i);
+        }
+    }
 }
\ No newline at end of file
@@ -0,0 +1,31 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "octree.h"
+
+#include "sphere.h"
+#include "transformations.h"
+
+// See test/accelerator.cc for the tests shared with the other structures
+
+TEST(OctreeTest, BuildingAnOctreeOnlyCreatesOccupiedOctants) {
+    // a 4*4*4 cube of spheres
+    std::vector<Sphere> spheres(64);
+    std::vector<const Shape*> objects {};
+    for (std::size_t i = 0; i < spheres.size(); i++) {
+        spheres[i].SetTransform(
+            Transformation().Translate(3 * (i % 4), 3 * ((i / 4) % 4), 3 * (i / 16))
+        );
+        objects.push_back(&spheres[i]);
+    }
+    Octree octree {};
+    octree.Build(objects);
+    // the root splits the lattice into 8 octants of 8 spheres each, which
+    // are small enough not to be divided further
+    ASSERT_EQ(octree.NNodes(), 9);
+
+    std::vector<const Shape*> corner { objects[0], objects[63] };
+    octree.Build(corner);
+    ASSERT_EQ(octree.NNodes(), 1);
+}
\ No newline at end of file
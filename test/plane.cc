@@ -140,4 +140,20 @@ TEST(PlaneTest, APlaneHasABoundingBox) {
           max { kInfinity, 0, kInfinity };
     ASSERT_EQ(min, box.Min());
     ASSERT_EQ(max, box.Max());
+}
+
+TEST(PlaneTest, IntersectingARayPacketWithAPlane) {
+    Plane p {};
+    RayPacket packet {};
+    packet.Add(Ray { Point { 0, 1, 0 }, Vector { 0, -1, 0 } });
+    packet.Add(Ray { Point { 0, 10, 0 }, Vector { 0, 0, 1 } });
+    packet.Add(Ray { Point { 0, -1, 0 }, Vector { 0, 2, 0 } });
+
+    IntersectionList lists[kMaxPacketSize];
+    ASSERT_EQ(p.IntersectPacket(lists, packet, packet.Mask()), 0x5);
+    ASSERT_EQ(lists[0].Size(), 1);
+    ASSERT_DOUBLE_EQ(lists[0][0]->Distance(), 1);
+    ASSERT_EQ(lists[1].Size(), 0);
+    ASSERT_EQ(lists[2].Size(), 1);
+    ASSERT_DOUBLE_EQ(lists[2][0]->Distance(), 0.5);
 }
\ No newline at end of file
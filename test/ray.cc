@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
+#include <limits>
 #include "ray.h"
+#include "ray-packet.h"
 #include "transformations.h"
 
 /*
@@ -92,4 +94,54 @@ TEST(RayTest, ScalingARay) {
     ASSERT_EQ(r2.Origin(), p2);
     Vector v2 { 0, 3, 0 };
     ASSERT_EQ(r2.Direction(), v2);
+}
+
+// A packet's lanes are transformed exactly as single rays are
+TEST(RayTest, TransformingARayPacket) {
+    Ray r1 { Point { 1, 2, 3 }, Vector { 0, 1, 0 } },
+        r2 { Point { -1, 0.5, 4 }, Vector { 0.3, -0.2, 0.9 } };
+    RayPacket packet {};
+    ASSERT_TRUE(packet.Add(r1));
+    ASSERT_TRUE(packet.Add(r2));
+    ASSERT_EQ(packet.Size(), 2);
+    ASSERT_EQ(packet.Mask(), 0x3);
+
+    Matrix transform = Transformation().Scale(2, 3, 4).RotateY(0.5).Translate(3, 4, 5);
+    RayPacket transformed = packet.Transform(transform);
+    ASSERT_EQ(transformed.Size(), 2);
+    for (int lane = 0; lane < 2; lane++) {
+        Ray expected = packet.At(lane).Transform(transform);
+        Ray actual = transformed.At(lane);
+        ASSERT_EQ(actual.Origin(), expected.Origin());
+        ASSERT_EQ(actual.Direction(), expected.Direction());
+    }
+}
+
+TEST(RayTest, FillingARayPacket) {
+    RayPacket packet {};
+    Ray r { Point { 0, 0, 0 }, Vector { 0, 0, 1 } };
+    for (int lane = 0; lane < kMaxPacketSize; lane++) {
+        ASSERT_TRUE(packet.Add(r));
+    }
+    ASSERT_FALSE(packet.Add(r));
+    ASSERT_EQ(packet.Mask(), 0xffff);
+    ASSERT_EQ(LaneCount(packet.Mask()), kMaxPacketSize);
+}
+
+// The reciprocal direction and its signs are computed when the ray is built
+// and again when it is transformed
+TEST(RayTest, ARayHasAnInverseDirection) {
+    Ray r { Point { 1, 2, 3 }, Vector { 2, -4, 0 } };
+    ASSERT_DOUBLE_EQ(r.InverseDirection(0), 0.5);
+    ASSERT_DOUBLE_EQ(r.InverseDirection(1), -0.25);
+    ASSERT_EQ(r.InverseDirection(2), std::numeric_limits<double>::infinity());
+    ASSERT_EQ(r.Sign(0), 0);
+    ASSERT_EQ(r.Sign(1), 1);
+    ASSERT_EQ(r.Sign(2), 0);
+
+    Ray r2 = r.Transform(Transformation().Scale(-1, 2, 1));
+    ASSERT_DOUBLE_EQ(r2.InverseDirection(0), -0.5);
+    ASSERT_DOUBLE_EQ(r2.InverseDirection(1), -0.125);
+    ASSERT_EQ(r2.Sign(0), 1);
+    ASSERT_EQ(r2.Sign(1), 1);
 }
\ No newline at end of file
@@ -0,0 +1,95 @@
+#define _USE_MATH_DEFINES // for M_PI
+#include <gtest/gtest.h>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include "render-server.h"
+#include "camera.h"
+#include "canvas.h"
+#include "world.h"
+#include "sphere.h"
+#include "material.h"
+#include "transformations.h"
+
+class RenderServerTest: public testing::Test {
+    protected:
+        World default_world {};
+        Light light { Point { -10, 10, -10 }, Colour { 1, 1, 1 } };
+        Sphere sphere1 {};
+        Camera c { 11, 11, M_PI / 2 };
+
+        void SetUp() override {
+            // Set up world, see p. 92
+            default_world.Add(&light);
+            sphere1.SetMaterial(Material { Colour { 0.8, 1.0, 0.6 }, 0.1, 0.7, 0.2, 200.0 });
+            default_world.Add(&sphere1);
+            c.SetTransform(ViewTransform { Point { 0, 0, -5 }, Point { 0, 0, 0 },
+                Vector { 0, 1, 0 } });
+        }
+};
+
+static std::string PPM(const Canvas& canvas) {
+    std::ostringstream ppm {};
+    ppm << PPMv3 { canvas };
+    return ppm.str();
+}
+
+TEST_F(RenderServerTest, ParsingARenderRequest) {
+    RenderRequest request { c };
+    ASSERT_EQ(11, request.width);
+    ASSERT_FALSE(request.has_view);
+    ASSERT_FALSE(request.has_crop);
+
+    request.Parse("render width=20 height=10 fov=1.5 from=1,2,3 crop=2,3,4,5");
+    ASSERT_EQ(20, request.width);
+    ASSERT_EQ(10, request.height);
+    ASSERT_DOUBLE_EQ(1.5, request.field_of_view);
+    ASSERT_TRUE(request.has_view);
+    ASSERT_EQ(Point(1, 2, 3), request.from);
+    ASSERT_EQ(Point(0, 0, 0), request.to);
+    ASSERT_TRUE(request.has_crop);
+    ASSERT_EQ(3, request.crop_row);
+    ASSERT_EQ(5, request.crop_height);
+
+    for (const char* line: { "draw width=20", "render width", "render width=0",
+            "render width=2.5", "render fov=4", "render from=1,2", "render up=1,2,3,4",
+            "render crop=1,2,x,4", "render crop=1,2,3,4,", "render from=1,2,3,",
+            "render crop=0.5,0,2.7,4", "render height=1e10", "render width=16385",
+            "render width=2000000000 height=2000000000", "render width=8192 height=8192",
+            "render depth=3" }) {
+        ASSERT_THROW(request.Parse(line), std::invalid_argument) << line;
+    }
+    // a bad request leaves it unchanged
+    ASSERT_EQ(20, request.width);
+}
+
+TEST_F(RenderServerTest, RenderingRequestedFrames) {
+    std::string path = testing::TempDir() + "render-server-test-" + std::to_string(getpid());
+    RenderServer server { default_world, c, path, 3 };
+    ASSERT_THROW(RenderServer(default_world, c, path), std::runtime_error);
+    std::thread serving { [&server] { server.Serve(); } };
+
+    // the server's camera, unless the request changes it
+    ASSERT_EQ(PPM(c.Render(default_world)), RequestRender(path, "render"));
+    Camera moved { 11, 11, M_PI / 2 };
+    moved.SetTransform(ViewTransform { Point { 1, 2, -5 }, Point { 0, 0, 0 },
+        Vector { 0, 1, 0 } });
+    ASSERT_EQ(PPM(moved.Render(default_world)), RequestRender(path, "render from=1,2,-5"));
+    Camera wide { 20, 10, M_PI / 3 };
+    wide.SetTransform(c.Transform());
+    ASSERT_EQ(PPM(wide.RenderRegion(default_world, 4, 2, 7, 5)),
+        RequestRender(path, "render width=20 height=10 fov=1.0471975511965976 crop=4,2,7,5"));
+
+    ASSERT_EQ("error: Region must be within the image\n",
+        RequestRender(path, "render crop=8,0,4,4"));
+    ASSERT_EQ("error: Region must be within the image\n",
+        RequestRender(path, "render crop=8,0,2147483647,4"));
+    ASSERT_EQ("error: Unknown key: depth\n", RequestRender(path, "render depth=3"));
+
+    ASSERT_EQ("", RequestRender(path, "stop"));
+    serving.join();
+    ASSERT_EQ(3, server.Frames());
+}
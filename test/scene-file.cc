@@ -0,0 +1,224 @@
+#define _USE_MATH_DEFINES // for M_PI
+#include <gtest/gtest.h>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "scene-file.h"
+#include "camera.h"
+#include "canvas.h"
+#include "sphere.h"
+#include "cylinder.h"
+#include "material.h"
+#include "pattern.h"
+#include "transformations.h"
+#include "world.h"
+
+// The default world (see p. 92), seen as in the book's camera tests
+static const char* kDefaultWorld =
+    "- add: camera\n"
+    "  width: 11\n"
+    "  height: 11\n"
+    "  field-of-view: 1.5707963267948966\n"
+    "  from: [ 0, 0, -5 ]\n"
+    "  to: [ 0, 0, 0 ]\n"
+    "  up: [ 0, 1, 0 ]\n"
+    "- add: light\n"
+    "  at: [ -10, 10, -10 ]\n"
+    "  intensity: [ 1, 1, 1 ]\n"
+    "- add: sphere\n"
+    "  material:\n"
+    "    color: [ 0.8, 1.0, 0.6 ]\n"
+    "    diffuse: 0.7\n"
+    "    specular: 0.2\n"
+    "- add: sphere\n"
+    "  transform:\n"
+    "    - [ scale, 0.5, 0.5, 0.5 ]\n";
+
+static const char* kDefaultWorldJson = R"([
+    { "add": "camera", "width": 11, "height": 11, "field-of-view": 1.5707963267948966,
+      "from": [0, 0, -5], "to": [0, 0, 0], "up": [0, 1, 0] },
+    { "add": "light", "at": [-10, 10, -10], "intensity": [1, 1, 1] },
+    { "add": "sphere",
+      "material": { "color": [0.8, 1.0, 0.6], "diffuse": 0.7, "specular": 0.2 } },
+    { "add": "sphere", "transform": [["scale", 0.5, 0.5, 0.5]] }
+])";
+
+TEST(SceneFileTest, LoadingTheDefaultWorld) {
+    World expected {};
+    Light light { Point { -10, 10, -10 }, Colour { 1, 1, 1 } };
+    expected.Add(&light);
+    Sphere sphere1 {};
+    sphere1.SetMaterial(Material { Colour { 0.8, 1.0, 0.6 }, 0.1, 0.7, 0.2, 200.0 });
+    expected.Add(&sphere1);
+    Sphere sphere2 {};
+    sphere2.SetTransform(Transformation().Scale(0.5, 0.5, 0.5));
+    expected.Add(&sphere2);
+    Camera c { 11, 11, M_PI / 2 };
+    c.SetTransform(ViewTransform { Point { 0, 0, -5 }, Point { 0, 0, 0 }, Vector { 0, 1, 0 } });
+    Canvas image = c.Render(expected);
+
+    for (const char* text: { kDefaultWorld, kDefaultWorldJson }) {
+        SceneFile scene {};
+        ASSERT_FALSE(scene.HasCamera());
+        std::istringstream is { text };
+        scene.Load(is);
+        ASSERT_EQ(2, scene.NShapes());
+        ASSERT_EQ(2, scene.SceneWorld().NObjects());
+        ASSERT_EQ(1, scene.SceneWorld().NLights());
+        ASSERT_EQ(11, scene.SceneCamera().Horizontal());
+        Canvas loaded = scene.SceneCamera().Render(scene.SceneWorld());
+        for (int row = 0; row < 11; row++) {
+            for (int column = 0; column < 11; column++) {
+                ASSERT_EQ(image.At(row, column), loaded.At(row, column));
+            }
+        }
+    }
+}
+
+TEST(SceneFileTest, LoadingDefinitionsGroupsAndPatterns) {
+    std::istringstream is {
+        "- define: white\n"
+        "  value:\n"
+        "    color: [ 1, 1, 1 ]\n"
+        "    reflective: 0.1\n"
+        "- define: blue\n"
+        "  extend: white\n"
+        "  value:\n"
+        "    color: [ 0.5, 0.8, 0.9 ]\n"
+        "- define: raised\n"
+        "  value:\n"
+        "    - [ translate, 0, 1, 0 ]\n"
+        "- add: group\n"
+        "  material: blue\n"
+        "  transform: [ raised, [ translate, 0, 0, 5 ] ]\n"
+        "  children:\n"
+        "    - add: cube\n"
+        "    - add: cylinder\n"
+        "      min: -1\n"
+        "      max: 2\n"
+        "      closed: true\n"
+        "      transform: [ [ translate, 5, 0, 0 ] ]\n"
+        "      material:\n"
+        "        pattern:\n"
+        "          type: stripes\n"
+        "          colors: [ [ 1, 0, 0 ], [ 0, 0, 1 ] ]\n"
+        "          transform: [ [ scale, 0.5, 1, 1 ] ]\n" };
+    SceneFile scene {};
+    scene.Load(is);
+    ASSERT_FALSE(scene.HasCamera());
+    ASSERT_THROW(scene.SceneCamera(), std::runtime_error);
+    ASSERT_EQ(3, scene.NShapes());
+    ASSERT_EQ(1, scene.SceneWorld().NObjects());
+
+    // the cube is at (0, 1, 5) and inherits the group's material
+    IntersectionList xs = scene.SceneWorld().Intersect(
+        Ray { Point { 0, 1, 0 }, Vector { 0, 0, 1 } });
+    ASSERT_NE(nullptr, xs.Hit());
+    ASSERT_DOUBLE_EQ(4, xs.Hit()->Distance());
+    const Shape* cube = xs.Hit()->Object();
+    ASSERT_EQ(Colour(0.5, 0.8, 0.9), cube->ShapeMaterial().Surface());
+    ASSERT_DOUBLE_EQ(0.1, cube->ShapeMaterial().Reflectivity());
+
+    // the cylinder is at (5, 1, 5) and has its own
+    IntersectionList ys = scene.SceneWorld().Intersect(
+        Ray { Point { 5, 1, 0 }, Vector { 0, 0, 1 } });
+    ASSERT_NE(nullptr, ys.Hit());
+    ASSERT_DOUBLE_EQ(4, ys.Hit()->Distance());
+    const Cylinder* cylinder = static_cast<const Cylinder*>(ys.Hit()->Object());
+    ASSERT_DOUBLE_EQ(-1, cylinder->Minimum());
+    ASSERT_DOUBLE_EQ(2, cylinder->Maximum());
+    ASSERT_TRUE(cylinder->Closed());
+    ASSERT_DOUBLE_EQ(0, cylinder->ShapeMaterial().Reflectivity());
+    const Pattern* stripes = cylinder->ShapeMaterial().SurfacePattern();
+    ASSERT_NE(nullptr, stripes);
+    ASSERT_EQ(Colour(1, 0, 0), stripes->ObjectColourAt(cylinder, Point { 5.4, 1, 5 }));
+    ASSERT_EQ(Colour(0, 0, 1), stripes->ObjectColourAt(cylinder, Point { 5.6, 1, 5 }));
+}
+
+TEST(SceneFileTest, SharingMaterials) {
+    std::istringstream is {
+        "- define: striped\n"
+        "  value:\n"
+        "    pattern:\n"
+        "      type: stripes\n"
+        "      colors: [ [ 1, 0, 0 ], [ 0, 0, 1 ] ]\n"
+        "- define: moved\n"
+        "  value: [ [ translate, 0, 0, 5 ] ]\n"
+        "- define: moved-twice\n"
+        "  value: [ moved, moved ]\n"
+        "- add: sphere\n"
+        "  material: striped\n"
+        "- add: sphere\n"
+        "  material: striped\n"
+        "  transform: [ moved-twice ]\n"
+        "- add: group\n"
+        "  transform: [ [ translate, 10, 0, 0 ] ]\n"
+        "  material:\n"
+        "    pattern:\n"
+        "      type: rings\n"
+        "      colors: [ [ 1, 0, 0 ], [ 0, 0, 1 ] ]\n"
+        "  children:\n"
+        "    - add: cube\n"
+        "    - add: cube\n"
+        "      transform: [ moved ]\n" };
+    std::size_t materials = MaterialTable::Shared().Size();
+    SceneFile scene {};
+    scene.Load(is);
+    // each material is made once, whatever the number of shapes using it
+    ASSERT_EQ(materials + 2, MaterialTable::Shared().Size());
+
+    // the spheres are at z = 0 and 10, the cubes at x = 10 and z = 0 and 5
+    const Shape* shapes[4] {};
+    Point above[4] { Point { 0, 5, 0 }, Point { 0, 5, 10 }, Point { 10, 5, 0 },
+        Point { 10, 5, 5 } };
+    for (int i = 0; i < 4; i++) {
+        IntersectionList xs = scene.SceneWorld().Intersect(Ray { above[i], Vector { 0, -1, 0 } });
+        ASSERT_NE(nullptr, xs.Hit());
+        shapes[i] = xs.Hit()->Object();
+    }
+    for (int i: { 0, 2 }) {
+        ASSERT_NE(shapes[i], shapes[i + 1]);
+        ASSERT_NE(nullptr, shapes[i]->ShapeMaterial().SurfacePattern());
+        ASSERT_EQ(shapes[i]->ShapeMaterial().SurfacePattern(),
+            shapes[i + 1]->ShapeMaterial().SurfacePattern());
+    }
+}
+
+TEST(SceneFileTest, RejectingInvalidScenes) {
+    struct { const char* text; const char* error; } cases[] {
+        { "- add: torus\n", "Line 1: Unknown shape: torus" },
+        { "- add: sphere\n  colour: [ 1, 0, 0 ]\n", "Line 2: Unknown key: colour" },
+        { "- add: sphere\n  material: shiny\n", "Line 2: Unknown definition: shiny" },
+        { "- add: light\n  at: [ 1, 2 ]\n  intensity: [ 1, 1, 1 ]\n",
+            "Line 2: Expected a list of three numbers" },
+        { "- add: sphere\n  transform:\n    - [ spin, 1 ]\n",
+            "Line 3: Unknown transformation: spin" },
+        { "- add: cube\n  transform: [ [ rotate-x, 1, 2 ] ]\n",
+            "Line 2: Expected 1 numbers for rotate-x" },
+        { "- add: camera\n  width: 10\n", "Line 1: Expected height" },
+        { "- add: camera\n  width: 10.5\n  height: 10\n", "Line 2: Expected a whole number" },
+        { "- add: camera\n  width: 10\n  height: 1e10\n", "Line 3: Expected a whole number" },
+        { "- remove: sphere\n", "Line 1: Expected add or define" },
+        // a transform can only refer to those defined before it
+        { "- define: t\n  value: [ t, [ translate, 1, 0, 0 ] ]\n",
+            "Line 2: Unknown definition: t" },
+        { "- define: a\n  value: [ b ]\n- define: b\n  value: [ a ]\n",
+            "Line 2: Unknown definition: b" },
+        { "- define: m\n  value:\n    ambient: 1\n- add: cube\n  transform: [ m ]\n",
+            "Line 5: Expected a transform: m" },
+    };
+    for (const auto& c: cases) {
+        SceneFile scene {};
+        std::istringstream is { c.text };
+        try {
+            scene.Load(is);
+            FAIL() << c.text;
+        }
+        catch (const std::invalid_argument& e) {
+            ASSERT_EQ(std::string { c.error }, e.what());
+        }
+    }
+    SceneFile scene {};
+    ASSERT_THROW(scene.Load("no-such-scene.yml"), std::runtime_error);
+}
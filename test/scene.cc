@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "scene.h"
+
+#include "sphere.h"
+#include "group.h"
+#include "pattern.h"
+#include "transformations.h"
+
+// counts the destructor calls of objects made by a scene
+struct Counted {
+    static int destroyed_;
+    double value_;
+
+    Counted(double v): value_ { v } {}
+    ~Counted() { destroyed_++; }
+};
+
+int Counted::destroyed_ = 0;
+
+TEST(SceneTest, MakingShapesInAScene) {
+    Scene scene {};
+    Sphere* s = scene.Make<Sphere>();
+    s->SetTransform(Transformation().Translate(1, 2, 3));
+    ShapeGroup* g = scene.Make<ShapeGroup>();
+    g->Add(s);
+    ASSERT_EQ(scene.NObjects(), 2);
+    ASSERT_EQ(s->Parent(), g);
+    ASSERT_EQ(s->Transform(), Transformation().Translate(1, 2, 3));
+    ASSERT_EQ(scene.NBlocks(), 1);
+    ASSERT_GE(scene.Used(), sizeof(Sphere) + sizeof(ShapeGroup));
+}
+
+TEST(SceneTest, ObjectsAreLaidOutInTheOrderTheyAreMade) {
+    Scene scene {};
+    Sphere* s1 = scene.Make<Sphere>();
+    Sphere* s2 = scene.Make<Sphere>();
+    StripePattern* p = scene.Make<StripePattern>(Colour::kWhite, Colour::kBlack);
+    ASSERT_LT(reinterpret_cast<char*>(s1), reinterpret_cast<char*>(s2));
+    ASSERT_LT(reinterpret_cast<char*>(s2), reinterpret_cast<char*>(p));
+    // the second sphere follows the first, apart from any padding
+    ASSERT_LT(reinterpret_cast<char*>(s2) - reinterpret_cast<char*>(s1),
+        sizeof(Sphere) + alignof(Sphere));
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(p) % alignof(StripePattern), 0);
+}
+
+TEST(SceneTest, MakingObjectsBiggerThanABlock) {
+    Scene scene { 256 };
+    for (int i = 0; i < 10; i++) {
+        scene.Make<Sphere>();
+    }
+    ASSERT_GT(scene.NBlocks(), 1);
+    ASSERT_EQ(scene.NObjects(), 10);
+    ASSERT_GE(scene.Memory(), 10 * sizeof(Sphere));
+}
+
+TEST(SceneTest, ClearingASceneDestroysItsObjects) {
+    Scene scene { 1024 };
+    Counted::destroyed_ = 0;
+    for (int i = 0; i < 100; i++) {
+        scene.Make<Counted>(i);
+    }
+    // trivially destructible objects need no destructor call
+    double* d = scene.Make<double>(1.5);
+    ASSERT_EQ(*d, 1.5);
+    std::size_t peak = scene.Memory();
+    ASSERT_EQ(scene.PeakMemory(), peak);
+    scene.Clear();
+    ASSERT_EQ(Counted::destroyed_, 100);
+    ASSERT_EQ(scene.NObjects(), 0);
+    ASSERT_EQ(scene.NBlocks(), 0);
+    ASSERT_EQ(scene.Memory(), 0);
+    // the peak is kept after the blocks are released
+    ASSERT_EQ(scene.PeakMemory(), peak);
+    scene.Make<Counted>(1);
+    ASSERT_EQ(scene.PeakMemory(), peak);
+}
\ No newline at end of file
@@ -303,3 +303,15 @@ TEST(ShapeTest, SubdividingAPrimitiveDoesNothing) {
     ASSERT_EQ(s1, s2);
 }
 
+
+
+TEST(ShapeTest, ShapesWithTheSameMaterialShareIt) {
+    Sphere s1 {}, s2 {}, s3 {};
+    Material m = Material().Surface(Colour { 0.1, 0.2, 0.3 }).Transparency(0.5);
+    s1.SetMaterial(m);
+    s2.SetMaterial(Material(m));
+    s3.SetMaterial(Material(m).RefractiveIndex(1.5));
+    ASSERT_EQ(&s1.ShapeMaterial(), &s2.ShapeMaterial());
+    ASSERT_NE(&s1.ShapeMaterial(), &s3.ShapeMaterial());
+    ASSERT_EQ(s1.ShapeMaterial(), m);
+}
\ No newline at end of file
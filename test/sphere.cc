@@ -435,3 +435,30 @@ TEST(SphereTest, ASphereHasABoundingBox) {
     ASSERT_EQ(min, box.Min());
     ASSERT_EQ(max, box.Max());
 }
+
+// Each lane of a packet gets the same intersections as the single ray, and
+// lanes outside the mask are skipped
+TEST(SphereTest, IntersectingARayPacketWithASphere) {
+    Sphere s {};
+    s.SetTransform(Transformation().Scale(2, 2, 2));
+    RayPacket packet {};
+    packet.Add(Ray { Point { 0, 0, -5 }, Vector { 0, 0, 1 } });
+    packet.Add(Ray { Point { 0, 2, -5 }, Vector { 0, 0, 1 } });
+    packet.Add(Ray { Point { 0, 3, -5 }, Vector { 0, 0, 1 } });
+    packet.Add(Ray { Point { 0, 0, 0 }, Vector { 0, 0, 1 } });
+    packet.Add(Ray { Point { 1, 0, -5 }, Vector { 0, 0, 1 } });
+
+    IntersectionList lists[kMaxPacketSize];
+    LaneMask mask = packet.Mask() & ~(1u << 4);
+    ASSERT_EQ(s.IntersectPacket(lists, packet, mask), 0xb);
+
+    double expected[][2] = { { 3, 7 }, { 5, 5 }, { 0, 0 }, { -2, 2 } };
+    for (int lane: { 0, 1, 3 }) {
+        ASSERT_EQ(lists[lane].Size(), 2);
+        ASSERT_DOUBLE_EQ(lists[lane][0]->Distance(), expected[lane][0]);
+        ASSERT_DOUBLE_EQ(lists[lane][1]->Distance(), expected[lane][1]);
+        ASSERT_EQ(lists[lane][0]->Object(), &s);
+    }
+    ASSERT_EQ(lists[2].Size(), 0);
+    ASSERT_EQ(lists[4].Size(), 0);
+}
\ No newline at end of file
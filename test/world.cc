@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include <cmath>
+#include <sstream>
+#include <string>
 #include "world.h"
 #include "sphere.h"
 #include "material.h"
@@ -9,6 +11,8 @@
 #include "plane.h"
 #include "pattern.h"
 #include "cube.h"
+#include "group.h"
+#include "grid.h"
 
 /*
 Scenario: Creating a world
@@ -369,6 +373,41 @@ TEST_F(DefaultWorldTest, ConfirmingTheReflectedColourForReflectiveMaterial) {
     ASSERT_TRUE(ColoursAreEqual(expected, colour, 1e-4));
 }
 
+TEST_F(DefaultWorldTest, PruningAReflectedRayThatContributesTooLittle) {
+    Plane plane {};
+    Material material {};
+    material.Reflectivity(0.5);
+    plane.SetMaterial(material);
+    plane.SetTransform(Transformation().Translate(0, -1, 0));
+    default_world_.Add(&plane);
+
+    Ray r { Point(0, 0, -3), Vector(0, -DefaultWorldTest::kHalfSqrt2,
+        DefaultWorldTest::kHalfSqrt2) };
+    Intersection i { DefaultWorldTest::kSqrt2, &plane };
+    IntersectionComputation comps { i, r };
+
+    // the reflected ray contributes 0.5 of its colour, or 0.05 of it when
+    // the plane is itself seen through something that passes 0.1
+    ASSERT_EQ(0.0, default_world_.MinContribution());
+    default_world_.SetMinContribution(0.1);
+    Colour colour = default_world_.ReflectedColour(comps),
+           expected { 0.19032, 0.2379, 0.14274 };
+    ASSERT_TRUE(ColoursAreEqual(expected, colour, 1e-4));
+
+    TraversalStatistics::Reset();
+    TraversalStatistics::Enable();
+    colour = default_world_.ReflectedColour(comps, World::kMaxReflections, 0.1);
+    TraversalStatistics::Enable(false);
+    ASSERT_EQ(Colour::kBlack, colour);
+    ASSERT_EQ(1, TraversalStatistics::RaysPruned());
+}
+
+TEST_F(DefaultWorldTest, ConfiguringTheMaximumDepthOfARender) {
+    ASSERT_EQ(World::kMaxReflections, default_world_.MaxDepth());
+    default_world_.SetMaxDepth(2);
+    ASSERT_EQ(2, default_world_.MaxDepth());
+}
+
 /*
 Scenario: shade_hit() with a reflective material
   Given w ← default_world()
@@ -808,4 +847,35 @@ TEST(WorldTest, ConfirmingAShadowlessLight) {
     IntersectionComputation ic { i, r };
     Colour shaded = w.ColourAt(ic);
     ASSERT_EQ(original, shaded);
+}
+
+TEST_F(DefaultWorldTest, IntersectingAWorldWithAnAccelerator) {
+    UniformGrid grid {};
+    default_world_.SetAccelerator(&grid);
+    Ray r { Point { 0, 0, -5 }, Vector { 0, 0, 1 } };
+    IntersectionList xs = default_world_.Intersect(r);
+    ASSERT_EQ(xs.Size(), 4);
+    ASSERT_DOUBLE_EQ(xs[0]->Distance(), 4);
+    ASSERT_DOUBLE_EQ(xs[1]->Distance(), 4.5);
+    ASSERT_DOUBLE_EQ(xs[2]->Distance(), 5.5);
+    ASSERT_DOUBLE_EQ(xs[3]->Distance(), 6);
+    default_world_.SetAccelerator(nullptr);
+}
+
+
+TEST_F(DefaultWorldTest, ReportingTheMemoryUsedByTheWorldsShapes) {
+    ShapeGroup g {};
+    Cube c {};
+    g.Add(&c);
+    default_world_.Add(&g);
+    std::ostringstream os {};
+    default_world_.MemoryReport(os);
+    std::string report = os.str();
+    ASSERT_NE(report.find("Sphere\t2\t" + std::to_string(2 * sphere1_->Memory()) + "\t"),
+        std::string::npos);
+    ASSERT_NE(report.find("Cube\t1\t"), std::string::npos);
+    ASSERT_NE(report.find("ShapeGroup\t1\t"), std::string::npos);
+    ASSERT_NE(report.find("total\t4\t"), std::string::npos);
+    ASSERT_NE(report.find("materials\t"), std::string::npos);
+    default_world_.Remove(&g);
 }
\ No newline at end of file
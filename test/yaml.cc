@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "yaml.h"
+
+static YamlNode Parse(const std::string& text) {
+    std::istringstream is { text };
+    YamlReader reader { is };
+    return reader.Document();
+}
+
+TEST(YamlTest, ReadingBlockCollections) {
+    YamlNode document = Parse(
+        "# a comment\n"
+        "- add: camera   # another\n"
+        "  width: 100\n"
+        "  'quoted key': \"a # b\"\n"
+        "  empty:\n"
+        "-\n"
+        "  - 1\n"
+        "  - two words\n"
+        "- nested:\n"
+        "  - [ translate, 1, -2.5, 3 ]\n"
+        "  -   { a: 1, \"b\": [ ] }\n");
+    ASSERT_TRUE(document.IsSequence());
+    ASSERT_EQ(3, document.items.size());
+
+    const YamlNode& camera = document.items[0];
+    ASSERT_TRUE(camera.IsMapping());
+    ASSERT_EQ(4, camera.entries.size());
+    ASSERT_EQ("camera", camera.Find("add")->text);
+    ASSERT_DOUBLE_EQ(100, camera.Find("width")->Number());
+    ASSERT_EQ(3, camera.Find("width")->line);
+    ASSERT_EQ("a # b", camera.Find("quoted key")->text);
+    ASSERT_EQ(YamlNode::Kind::kNull, camera.Find("empty")->kind);
+    ASSERT_EQ(nullptr, camera.Find("height"));
+
+    const YamlNode& list = document.items[1];
+    ASSERT_TRUE(list.IsSequence());
+    ASSERT_EQ("1", list.items[0].text);
+    ASSERT_EQ("two words", list.items[1].text);
+
+    const YamlNode& nested = *document.items[2].Find("nested");
+    ASSERT_EQ(2, nested.items.size());
+    ASSERT_EQ(4, nested.items[0].items.size());
+    ASSERT_EQ("translate", nested.items[0].items[0].text);
+    ASSERT_DOUBLE_EQ(-2.5, nested.items[0].items[2].Number());
+    ASSERT_TRUE(nested.items[1].IsMapping());
+    ASSERT_TRUE(nested.items[1].Find("b")->IsSequence());
+    ASSERT_TRUE(nested.items[1].Find("b")->items.empty());
+}
+
+TEST(YamlTest, ReadingASequenceAtTheIndentationOfItsKey) {
+    YamlNode document = Parse(
+        "transform:\n"
+        "- [ scale, 2, 2, 2 ]\n"
+        "- standard\n"
+        "material: red\n");
+    ASSERT_EQ(2, document.Find("transform")->items.size());
+    ASSERT_EQ("red", document.Find("material")->text);
+}
+
+TEST(YamlTest, StreamingTheItemsOfAList) {
+    for (const char* text: {
+            "- { add: light }\n- add: sphere\n  material: { color: [ 1, 0, 0 ] }\n",
+            "[\n  { \"add\": \"light\" },\n  {\n    \"add\": \"sphere\",\n"
+            "    \"material\": { \"color\": [1, 0,\n 0] }\n  }\n]\n" }) {
+        std::istringstream is { text };
+        YamlReader reader { is };
+        YamlNode item {};
+        ASSERT_TRUE(reader.Next(item));
+        ASSERT_EQ("light", item.Find("add")->text);
+        ASSERT_TRUE(reader.Next(item));
+        ASSERT_EQ("sphere", item.Find("add")->text);
+        ASSERT_DOUBLE_EQ(1, item.Find("material")->Find("color")->items[0].Number());
+        ASSERT_FALSE(reader.Next(item));
+        ASSERT_FALSE(reader.Next(item));
+    }
+}
+
+TEST(YamlTest, ReadingScalars) {
+    YamlNode document = Parse("[ 'it''s', \"a\\\"b\\n\", yes, no, 1e3, ~, it's ]");
+    ASSERT_EQ("it's", document.items[0].text);
+    ASSERT_EQ("a\"b\n", document.items[1].text);
+    ASSERT_TRUE(document.items[2].Boolean());
+    ASSERT_FALSE(document.items[3].Boolean());
+    ASSERT_DOUBLE_EQ(1000, document.items[4].Number());
+    ASSERT_EQ(YamlNode::Kind::kNull, document.items[5].kind);
+    ASSERT_EQ("it's", document.items[6].text);
+    ASSERT_THROW(document.items[0].Number(), std::invalid_argument);
+    ASSERT_THROW(document.items[4].Boolean(), std::invalid_argument);
+}
+
+TEST(YamlTest, RejectingMalformedDocuments) {
+    for (const char* text: { "- a\n  - b\n", "a: 1\nb\n", "[ 1, 2\n", "{ a 1 }",
+            "\"open", "- [ 1 ] 2\n", "a: 1\n\tb: 2\n" }) {
+        ASSERT_THROW(Parse(text), std::invalid_argument) << text;
+    }
+    std::istringstream is { "a: 1\n" };
+    YamlReader reader { is };
+    YamlNode item {};
+    ASSERT_THROW(reader.Next(item), std::invalid_argument);
+    try {
+        Parse("- a: 1\n  b: [ 1,\n  2 } ]\n");
+        FAIL();
+    }
+    catch (const std::invalid_argument& e) {
+        ASSERT_EQ(std::string { "Line 3: Expected , or ]" }, e.what());
+    }
+}